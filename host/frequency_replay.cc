@@ -0,0 +1,46 @@
+#include "frequency_trace.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+/*
+ * 回放调频策略的输入序列，打印每次需求变化和级别变化，以及各级别的停留时间:
+ *   frequency_replay <日志文件|-> [downscale_hold_ms]
+ */
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <trace log|-> [downscale_hold_ms]\n", argv[0]);
+        return 1;
+    }
+    std::vector<FrequencyTraceSample> trace;
+    if (!LoadFrequencyTrace(argv[1], trace) || trace.empty()) {
+        fprintf(stderr, "No trace samples in %s\n", argv[1]);
+        return 1;
+    }
+
+    FrequencyPolicy policy(argc > 2 ? strtoul(argv[2], nullptr, 10) : 3000);
+    uint32_t last_demands = ~0u;
+    bool last_sleep = false;
+    for (auto& sample : trace) {
+        if (sample.demands != last_demands || sample.sleep != last_sleep) {
+            printf("%8lu ms  demand %-28s%s\n", (unsigned long)sample.time_ms, FormatPowerDemands(sample.demands).c_str(),
+                sample.sleep ? " sleep" : "");
+            last_demands = sample.demands;
+            last_sleep = sample.sleep;
+        }
+        std::vector<FrequencyTransition> transitions;
+        policy.Replay({sample}, &transitions);
+        for (auto& transition : transitions) {
+            printf("%8lu ms  level  %s -> %s\n", (unsigned long)transition.time_ms,
+                FrequencyLevelName(transition.from), FrequencyLevelName(transition.to));
+        }
+    }
+
+    uint32_t total_ms = trace.back().time_ms - trace.front().time_ms;
+    for (int i = 0; i < kFrequencyLevelCount; i++) {
+        uint32_t time_ms = policy.time_in_level_ms((FrequencyLevel)i);
+        printf("%-8s %8lu ms %5.1f%%\n", FrequencyLevelName((FrequencyLevel)i), (unsigned long)time_ms,
+            total_ms > 0 ? time_ms * 100.0 / total_ms : 0.0);
+    }
+    return 0;
+}
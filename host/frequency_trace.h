@@ -0,0 +1,49 @@
+#ifndef HOST_FREQUENCY_TRACE_H
+#define HOST_FREQUENCY_TRACE_H
+
+#include "frequency_policy.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*
+ * 读取 FrequencyGovernor 调试日志中的输入序列，每行形如:
+ *   D (20410) FrequencyGovernor: trace 20410 0x19 0
+ * 即 时间(ms) 需求掩码 是否休眠，可以直接使用串口日志，其他行被忽略。
+ */
+inline bool LoadFrequencyTrace(const char* path, std::vector<FrequencyTraceSample>& trace) {
+    FILE* file = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (file == nullptr) {
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        const char* field = strstr(line, "trace ");
+        unsigned long time_ms;
+        long demands;
+        int sleep;
+        if (field != nullptr && sscanf(field, "trace %lu %li %d", &time_ms, &demands, &sleep) == 3) {
+            trace.push_back({(uint32_t)time_ms, (uint32_t)demands, sleep != 0});
+        }
+    }
+    if (file != stdin) {
+        fclose(file);
+    }
+    return true;
+}
+
+inline std::string FormatPowerDemands(uint32_t demands) {
+    static const char* const kDemandNames[] = {"audio_in", "audio_out", "video", "animation", "network"};
+    std::string result;
+    for (size_t i = 0; i < sizeof(kDemandNames) / sizeof(kDemandNames[0]); i++) {
+        if (demands & (1u << i)) {
+            result += result.empty() ? "" : "|";
+            result += kDemandNames[i];
+        }
+    }
+    return result.empty() ? "none" : result;
+}
+
+#endif // HOST_FREQUENCY_TRACE_H
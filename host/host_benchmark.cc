@@ -0,0 +1,463 @@
+#include "mcp_server.h"
+#include "frequency_policy.h"
+#include "posture_detection.h"
+#include "chat_message.h"
+#include "chat_message_corpus.h"
+#include "task_queue.h"
+#include "EyeAnimation.h"
+#include "mjpeg_frame_parser.h"
+#include "device_state_event.h"
+
+#include <esp_timer.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * 主机上的基准测试，输入与设备上的 bench 命令 (main/benchmark.cc) 相同，打印每个模块的吞吐量:
+ *   host_benchmark [模块|all] [次数]
+ *   mcp_bind     把 12 个属性的 tools/call 参数绑定到预先分配的参数帧
+ *   tool_json    序列化一个 12 个属性的工具描述，即 tools/list 重建时每个工具的开销
+ *   tools_build  工具列表变化后重新序列化 24 个工具并分页；tools_list 为之后直接返回缓存的第一页
+ *   chat_parse   用快速路径解析一轮对话的 stt / llm / tts 消息；chat_cjson 用 cJSON 解析同样的消息
+ *   posture      用抖动的 17 个关键点分析坐姿
+ *   frequency    回放一段对话的调频状态序列
+ *   task_queue   4 个生产者线程 Schedule 同样大小的任务，主循环线程执行，次数为每个生产者的任务数；
+ *                task_deque 为原来的 mutex + std::deque<std::function<void()>>
+ *   eye          渲染并缩放一帧眼球动画
+ *   mjpeg_scan   在 64KB 的读取缓存中查找一帧 JPEG，帧位于缓存末尾
+ *   state_event  订阅者表满员时分发一次状态变化，每个订阅者只关心两个状态
+ *   state_post   同样的订阅者表，通过事件循环投递一次状态变化并等到分发完，即投递的延迟
+ * 主机上单次迭代常不到 1us，因此按 ns 打印。
+ */
+struct BenchmarkResult {
+    int iterations;
+    int64_t elapsed_us;
+};
+
+static McpTool& BenchmarkTool() {
+    static McpTool tool("self.benchmark.bind", "Benchmark tool", PropertyList({
+        Property("volume", kPropertyTypeInteger, 0, 100),
+        Property("brightness", kPropertyTypeInteger, 50, 0, 100),
+        Property("theme", kPropertyTypeString),
+        Property("muted", kPropertyTypeBoolean, false),
+        Property("duration", kPropertyTypeInteger, 1000, 0, 60000),
+        Property("url", kPropertyTypeString),
+        Property("token", kPropertyTypeString, std::string("")),
+        Property("loop", kPropertyTypeBoolean),
+        Property("x", kPropertyTypeInteger, 0, 320),
+        Property("y", kPropertyTypeInteger, 0, 240),
+        Property("question", kPropertyTypeString),
+        Property("verbose", kPropertyTypeBoolean, false),
+    }), [](const PropertyList&) -> ReturnValue {
+        return true;
+    });
+    return tool;
+}
+
+static BenchmarkResult BenchmarkMcpBind(int iterations) {
+    auto& tool = BenchmarkTool();
+    cJSON* arguments = cJSON_Parse("{\"question\":\"What is in the picture?\",\"y\":120,\"x\":160,"
+        "\"loop\":true,\"url\":\"https://example.com/vision/explain\",\"theme\":\"dark\",\"volume\":50,"
+        "\"unknown\":1}");
+    PropertyList frame;
+    std::string error;
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        if (!tool.BindArguments(arguments, frame, error)) {
+            fprintf(stderr, "Failed to bind arguments: %s\n", error.c_str());
+            break;
+        }
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start_time;
+    cJSON_Delete(arguments);
+    return {iterations, elapsed_us};
+}
+
+static BenchmarkResult BenchmarkToolJson(int iterations) {
+    auto& tool = BenchmarkTool();
+    size_t total_size = 0;
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        total_size += tool.to_json().size();
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start_time;
+    return {total_size > 0 ? iterations : 0, elapsed_us};
+}
+
+// 与设备上常见的工具数相当：24 个工具，每个有 3 个属性和一段描述，分为 2 页以上
+static const std::vector<McpTool*>& BenchmarkTools() {
+    static std::vector<McpTool*> tools;
+    if (tools.empty()) {
+        for (int i = 0; i < 24; i++) {
+            tools.push_back(new McpTool("self.benchmark.tool_" + std::to_string(i),
+                "Benchmark tool used to measure tools/list. Sets a value on the device and returns the result, "
+                "the description is about as long as the descriptions of the common tools.", PropertyList({
+                Property("value", kPropertyTypeInteger, 0, 100),
+                Property("name", kPropertyTypeString),
+                Property("enabled", kPropertyTypeBoolean, true),
+            }), [](const PropertyList&) -> ReturnValue {
+                return true;
+            }));
+        }
+    }
+    return tools;
+}
+
+// 工具列表变化后的第一次 tools/list：序列化所有工具并分页
+static BenchmarkResult BenchmarkToolsListBuild(int iterations) {
+    auto& tools = BenchmarkTools();
+    McpToolsList tools_list;
+    std::string json;
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        tools_list.Clear();
+        tools_list.Build(tools);
+        tools_list.Find("", json);
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start_time;
+    return {tools_list.page_count() > 1 ? iterations : 0, elapsed_us};
+}
+
+// 之后的 tools/list 只复制缓存的分页
+static BenchmarkResult BenchmarkToolsList(int iterations) {
+    McpToolsList tools_list;
+    tools_list.Build(BenchmarkTools());
+    std::string json;
+    size_t total_size = 0;
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        tools_list.Find("", json);
+        total_size += json.size();
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start_time;
+    return {total_size > 0 ? iterations : 0, elapsed_us};
+}
+
+// 每次迭代处理一轮对话的全部消息，与 Protocol::DispatchChatMessage 相同，快速路径失败时回退到 cJSON
+static BenchmarkResult BenchmarkChatParse(int iterations) {
+    const int count = sizeof(kChatMessageCorpus) / sizeof(kChatMessageCorpus[0]);
+    size_t lengths[count];
+    for (int i = 0; i < count; i++) {
+        lengths[i] = strlen(kChatMessageCorpus[i]);
+    }
+    char scratch[512];
+    ChatMessage message;
+    int fallbacks = 0;
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        for (int j = 0; j < count; j++) {
+            if (!ParseChatMessage(kChatMessageCorpus[j], lengths[j], message, scratch, sizeof(scratch))) {
+                cJSON_Delete(cJSON_ParseWithLength(kChatMessageCorpus[j], lengths[j]));
+                fallbacks++;
+            }
+        }
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start_time;
+    if (fallbacks > 0) {
+        fprintf(stderr, "%d messages fell back to cJSON\n", fallbacks);
+    }
+    return {iterations, elapsed_us};
+}
+
+// 原来的路径: 构建 cJSON 树并取出 type / state / text / emotion
+static BenchmarkResult BenchmarkChatCjson(int iterations) {
+    const int count = sizeof(kChatMessageCorpus) / sizeof(kChatMessageCorpus[0]);
+    size_t lengths[count];
+    for (int i = 0; i < count; i++) {
+        lengths[i] = strlen(kChatMessageCorpus[i]);
+    }
+    ChatMessage message;
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        for (int j = 0; j < count; j++) {
+            cJSON* root = cJSON_ParseWithLength(kChatMessageCorpus[j], lengths[j]);
+            auto type = cJSON_GetObjectItem(root, "type");
+            auto state = cJSON_GetObjectItem(root, "state");
+            auto text = cJSON_GetObjectItem(root, "text");
+            auto emotion = cJSON_GetObjectItem(root, "emotion");
+            message.type = cJSON_IsString(type) ? type->valuestring : "";
+            message.state = cJSON_IsString(state) ? state->valuestring : "";
+            message.text = cJSON_IsString(text) ? text->valuestring : "";
+            message.emotion = cJSON_IsString(emotion) ? emotion->valuestring : "";
+            cJSON_Delete(root);
+        }
+    }
+    return {iterations, esp_timer_get_time() - start_time};
+}
+
+static BenchmarkResult BenchmarkPosture(int iterations) {
+    // 端坐时 17 个关键点的大致位置 (x, y)，每次加入随机抖动
+    static const int kKeypoints[34] = {
+        160, 80, 150, 70, 170, 70, 140, 75, 180, 75,
+        120, 140, 200, 140, 110, 200, 210, 200, 120, 250,
+        200, 250, 130, 260, 190, 260, 130, 330, 190, 330,
+        130, 400, 190, 400,
+    };
+    PostureDetector detector;
+    std::vector<int> keypoints(kKeypoints, kKeypoints + 34);
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        for (int j = 0; j < 34; j++) {
+            keypoints[j] = kKeypoints[j] + (rand() % 21) - 10;
+        }
+        detector.AnalyzePosture(keypoints);
+    }
+    return {iterations, esp_timer_get_time() - start_time};
+}
+
+// 每 100ms 一个采样：待机、唤醒、说话、播放、空闲后休眠
+static BenchmarkResult BenchmarkFrequency(int iterations) {
+    std::vector<FrequencyTraceSample> trace;
+    uint32_t time_ms = 0;
+    auto append = [&trace, &time_ms](int samples, uint32_t demands, bool sleep) {
+        for (int i = 0; i < samples; i++, time_ms += 100) {
+            trace.push_back({time_ms, demands, sleep});
+        }
+    };
+    append(50, kPowerDemandAnimation, false);
+    append(10, kPowerDemandAudioInput | kPowerDemandNetwork, false);
+    append(40, kPowerDemandAudioInput, false);
+    append(60, kPowerDemandAudioOutput | kPowerDemandAnimation, false);
+    append(100, 0, false);
+    append(40, 0, true);
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        FrequencyPolicy policy;
+        policy.Replay(trace);
+    }
+    return {iterations, esp_timer_get_time() - start_time};
+}
+
+#define BENCHMARK_PRODUCERS 4
+
+// 生产者线程同时开始 Push，消费者在当前线程执行，直到所有任务执行完
+template <typename Push, typename Drain>
+static BenchmarkResult RunProducerConsumer(int iterations, Push push, Drain drain) {
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> threads;
+    for (int p = 0; p < BENCHMARK_PRODUCERS; p++) {
+        threads.emplace_back([&, p]() {
+            ready.fetch_add(1);
+            while (!go.load()) {
+            }
+            for (int i = 0; i < iterations; i++) {
+                push(p, i);
+            }
+        });
+    }
+    while (ready.load() < BENCHMARK_PRODUCERS) {
+    }
+
+    const size_t total = (size_t)BENCHMARK_PRODUCERS * iterations;
+    size_t executed = 0;
+    int64_t start_time = esp_timer_get_time();
+    go.store(true);
+    while (executed < total) {
+        size_t count = drain();
+        executed += count;
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start_time;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return {(int)total, elapsed_us};
+}
+
+// 任务捕获 [this, state] 大小的数据，与 Application 中常见的 Schedule 相同
+static BenchmarkResult BenchmarkTaskQueue(int iterations) {
+    static TaskQueue queue;
+    static std::atomic<int> sink;
+    uint32_t overflows = queue.GetStats().overflows;
+    auto result = RunProducerConsumer(iterations, [](int producer, int i) {
+        queue.Push([producer, i]() { sink.store(producer + i, std::memory_order_relaxed); }, esp_timer_get_time());
+    }, []() {
+        return queue.RunPending(TASK_QUEUE_CAPACITY, [](int64_t) {});
+    });
+    // 生产者持续满速 Push 时大部分任务会进入溢出队列
+    fprintf(stderr, "task_queue: %lu of %d tasks overflowed\n", (unsigned long)(queue.GetStats().overflows - overflows),
+        result.iterations);
+    return result;
+}
+
+static BenchmarkResult BenchmarkTaskDeque(int iterations) {
+    static std::mutex mutex;
+    static std::deque<std::function<void()>> tasks;
+    static std::atomic<int> sink;
+    return RunProducerConsumer(iterations, [](int producer, int i) {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back([producer, i]() { sink.store(producer + i, std::memory_order_relaxed); });
+    }, []() {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto pending = std::move(tasks);
+        lock.unlock();
+        for (auto& task : pending) {
+            task();
+        }
+        return pending.size();
+    });
+}
+
+static BenchmarkResult BenchmarkEye(int iterations) {
+    EyeAnimation eye;
+    eye.begin();
+    eye.setEyelidGap(0);
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        eye.update();
+    }
+    return {iterations, esp_timer_get_time() - start_time};
+}
+
+// 缓存开头是上一帧的尾部，最坏情况下要扫描几乎整个缓存
+static BenchmarkResult BenchmarkMjpegScan(int iterations) {
+    std::vector<uint8_t> cache(64 * 1024);
+    for (size_t i = 0; i < cache.size(); i++) {
+        cache[i] = (uint8_t)(i * 7);
+    }
+    for (size_t i = 0; i + 1 < cache.size(); i++) {
+        if (cache[i] == 0xFF && (cache[i + 1] == 0xD8 || cache[i + 1] == 0xD9)) {
+            cache[i + 1] = 0;
+        }
+    }
+    const size_t frame_offset = cache.size() - 4096;
+    cache[frame_offset] = 0xFF;
+    cache[frame_offset + 1] = 0xD8;
+    cache[cache.size() - 2] = 0xFF;
+    cache[cache.size() - 1] = 0xD9;
+    size_t total_size = 0;
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        const uint8_t* frame = nullptr;
+        size_t size = 0;
+        if (mjpeg_find_frame(cache.data(), cache.size(), &frame, &size)) {
+            total_size += size;
+        }
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start_time;
+    return {total_size > 0 ? iterations : 0, elapsed_us};
+}
+
+ESP_EVENT_DEFINE_BASE(BENCHMARK_STATE_EVENTS);
+
+static std::atomic<int> s_state_calls{0};
+
+// 订阅者表满员，第一个订阅者关心所有状态并计数，其余每个只关心两个状态
+static StateChangeSubscribers& BenchmarkSubscribers() {
+    static StateChangeSubscribers subscribers;
+    static bool initialized = false;
+    if (!initialized) {
+        subscribers.Add([](DeviceState, DeviceState) {
+            s_state_calls.fetch_add(1, std::memory_order_release);
+        }, DEVICE_STATE_MASK_ALL);
+        for (int i = 1; i < DEVICE_STATE_MAX_SUBSCRIBERS; i++) {
+            uint32_t mask = DEVICE_STATE_MASK(i % (kDeviceStateFatalError + 1)) | DEVICE_STATE_MASK(kDeviceStateIdle);
+            subscribers.Add([](DeviceState, DeviceState) {}, mask);
+        }
+        initialized = true;
+    }
+    return subscribers;
+}
+
+static BenchmarkResult BenchmarkStateEvent(int iterations) {
+    auto& subscribers = BenchmarkSubscribers();
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        auto state = (DeviceState)(i % (kDeviceStateFatalError + 1));
+        if (subscribers.Wants(state)) {
+            subscribers.Dispatch(kDeviceStateUnknown, state);
+        }
+    }
+    return {iterations, esp_timer_get_time() - start_time};
+}
+
+static BenchmarkResult BenchmarkStatePost(int iterations) {
+    auto& subscribers = BenchmarkSubscribers();
+    static bool registered = false;
+    if (!registered) {
+        esp_event_loop_create_default();
+        esp_event_handler_register(BENCHMARK_STATE_EVENTS, 0, StateChangeSubscribers::EventHandler, &subscribers);
+        registered = true;
+    }
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        int calls = s_state_calls.load(std::memory_order_acquire);
+        subscribers.Post(BENCHMARK_STATE_EVENTS, 0, kDeviceStateUnknown, (DeviceState)(i % (kDeviceStateFatalError + 1)));
+        while (s_state_calls.load(std::memory_order_acquire) == calls) {
+            std::this_thread::yield();
+        }
+    }
+    return {iterations, esp_timer_get_time() - start_time};
+}
+
+static const struct {
+    const char* name;
+    BenchmarkResult (*function)(int iterations);
+    int default_iterations;
+} kBenchmarks[] = {
+    {"mcp_bind", BenchmarkMcpBind, 200000},
+    {"tool_json", BenchmarkToolJson, 20000},
+    {"tools_build", BenchmarkToolsListBuild, 2000},
+    {"tools_list", BenchmarkToolsList, 200000},
+    {"chat_parse", BenchmarkChatParse, 100000},
+    {"chat_cjson", BenchmarkChatCjson, 100000},
+    {"posture", BenchmarkPosture, 200000},
+    {"frequency", BenchmarkFrequency, 20000},
+    {"task_queue", BenchmarkTaskQueue, 200000},
+    {"task_deque", BenchmarkTaskDeque, 200000},
+    {"eye", BenchmarkEye, 2000},
+    {"mjpeg_scan", BenchmarkMjpegScan, 20000},
+    {"state_event", BenchmarkStateEvent, 1000000},
+    {"state_post", BenchmarkStatePost, 20000},
+};
+
+static void PrintResult(const char* name, const BenchmarkResult& result) {
+    int64_t elapsed_us = result.elapsed_us > 0 ? result.elapsed_us : 1;
+    int64_t per_iteration_ns = elapsed_us * 1000 / (result.iterations > 0 ? result.iterations : 1);
+    int64_t per_second = (int64_t)result.iterations * 1000000 / elapsed_us;
+    printf("%-12s %8d iters %10lld ns/iter %10lld /s\n", name, result.iterations,
+        (long long)per_iteration_ns, (long long)per_second);
+}
+
+int main(int argc, char** argv) {
+    const char* name = argc > 1 && strcmp(argv[1], "all") != 0 ? argv[1] : nullptr;
+    int iterations = argc > 2 ? atoi(argv[2]) : 0;
+    int count = 0;
+    for (auto& benchmark : kBenchmarks) {
+        if (name != nullptr && strcmp(name, benchmark.name) != 0) {
+            continue;
+        }
+        int n = iterations > 0 ? iterations : benchmark.default_iterations;
+        PrintResult(benchmark.name, benchmark.function(n));
+        count++;
+    }
+    if (count == 0) {
+        fprintf(stderr, "Unknown benchmark: %s\n", name);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,920 @@
+#include "mcp_server.h"
+#include "chat_message.h"
+#include "chat_message_corpus.h"
+#include "task_queue.h"
+#include "frequency_policy.h"
+#include "frequency_trace.h"
+#include "posture_detection.h"
+#include "uplink_rate_controller.h"
+#include "network_path_selector.h"
+#include "EyeAnimation.h"
+#include "mjpeg_frame_parser.h"
+#include "metrics.h"
+#include "device_state_event.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * 主机上的单元测试，每个测试是一个返回 bool 的函数，由 ctest 按名称分别运行:
+ *   host_tests [测试名]    不带参数时运行全部
+ * CHECK 失败时打印位置并让当前测试返回 false。
+ */
+#define CHECK(condition) do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            return false; \
+        } \
+    } while (0)
+
+static std::string ToJson(const cJSON* json) {
+    char* str = cJSON_PrintUnformatted(json);
+    std::string result(str);
+    cJSON_free(str);
+    return result;
+}
+
+static McpTool MakeVolumeTool() {
+    return McpTool("self.audio_speaker.set_volume", "Set the volume", PropertyList({
+        Property("volume", kPropertyTypeInteger, 0, 100),
+        Property("muted", kPropertyTypeBoolean, false),
+        Property("theme", kPropertyTypeString, std::string("light")),
+    }), [](const PropertyList& properties) -> ReturnValue {
+        return properties["volume"].value<int>();
+    });
+}
+
+static bool TestPropertyBind() {
+    McpTool tool = MakeVolumeTool();
+    PropertyList frame;
+    std::string error;
+
+    cJSON* arguments = cJSON_Parse("{\"theme\":\"dark\",\"volume\":42,\"unknown\":1}");
+    CHECK(tool.BindArguments(arguments, frame, error));
+    CHECK(frame["volume"].value<int>() == 42);
+    CHECK(frame["muted"].value<bool>() == false);
+    CHECK(frame["theme"].value<std::string>() == "dark");
+    cJSON_Delete(arguments);
+
+    // 复用参数帧时恢复默认值
+    arguments = cJSON_Parse("{\"volume\":7}");
+    CHECK(tool.BindArguments(arguments, frame, error));
+    CHECK(frame["theme"].value<std::string>() == "light");
+    cJSON_Delete(arguments);
+
+    arguments = cJSON_Parse("{\"volume\":101}");
+    CHECK(!tool.BindArguments(arguments, frame, error));
+    CHECK(error.find("maximum") != std::string::npos);
+    cJSON_Delete(arguments);
+
+    // 类型不符与缺失相同
+    arguments = cJSON_Parse("{\"volume\":\"50\"}");
+    CHECK(!tool.BindArguments(arguments, frame, error));
+    CHECK(error == "Missing valid argument: volume");
+    cJSON_Delete(arguments);
+
+    CHECK(!tool.BindArguments(nullptr, frame, error));
+    CHECK(tool.properties().IndexOf("muted") == 1);
+    CHECK(tool.properties().IndexOf("Muted") == -1);
+    return true;
+}
+
+static bool TestToolJson() {
+    McpTool tool = MakeVolumeTool();
+    cJSON* json = cJSON_Parse(tool.to_json().c_str());
+    CHECK(json != nullptr);
+    CHECK(strcmp(cJSON_GetObjectItem(json, "name")->valuestring, "self.audio_speaker.set_volume") == 0);
+    cJSON* schema = cJSON_GetObjectItem(json, "inputSchema");
+    CHECK(cJSON_IsObject(schema));
+    cJSON* volume = cJSON_GetObjectItem(cJSON_GetObjectItem(schema, "properties"), "volume");
+    CHECK(ToJson(volume) == "{\"type\":\"integer\",\"minimum\":0,\"maximum\":100}");
+    cJSON* required = cJSON_GetObjectItem(schema, "required");
+    CHECK(cJSON_GetArraySize(required) == 1);
+    CHECK(strcmp(required->child->valuestring, "volume") == 0);
+    cJSON_Delete(json);
+
+    PropertyList frame;
+    std::string error;
+    cJSON* arguments = cJSON_Parse("{\"volume\":30}");
+    CHECK(tool.BindArguments(arguments, frame, error));
+    cJSON_Delete(arguments);
+    CHECK(tool.Call(frame) == "{\"content\":[{\"type\":\"text\",\"text\":\"30\"}],\"isError\":false}");
+    return true;
+}
+
+// 名字为 self.test.<index>，描述长度可调，用于控制每个工具序列化后的大小
+struct TestTools {
+    std::vector<std::unique_ptr<McpTool>> storage;
+    std::vector<McpTool*> tools;
+
+    void Add(const std::string& name, size_t description_length) {
+        storage.emplace_back(new McpTool(name, std::string(description_length, 'd'), PropertyList({
+            Property("value", kPropertyTypeInteger, 0, 100),
+        }), [](const PropertyList&) -> ReturnValue {
+            return true;
+        }));
+        tools.push_back(storage.back().get());
+    }
+};
+
+// 从第一页开始沿 nextCursor 取完所有页，每页不超过限制，工具按注册顺序各出现一次
+static bool TestToolsListPages() {
+    const size_t max_payload = 600;
+    TestTools test_tools;
+    for (int i = 0; i < 12; i++) {
+        test_tools.Add("self.test." + std::to_string(i), 100);
+    }
+    McpToolsList tools_list(max_payload);
+    tools_list.Build(test_tools.tools);
+    CHECK(tools_list.page_count() > 2);
+
+    std::string cursor;
+    std::string json;
+    size_t pages = 0;
+    size_t next_tool = 0;
+    while (true) {
+        CHECK(tools_list.Find(cursor, json));
+        CHECK(json.length() <= max_payload);
+        cJSON* root = cJSON_Parse(json.c_str());
+        CHECK(root != nullptr);
+        cJSON* tool;
+        cJSON_ArrayForEach(tool, cJSON_GetObjectItem(root, "tools")) {
+            CHECK(next_tool < test_tools.tools.size());
+            CHECK(cJSON_GetObjectItem(tool, "name")->valuestring == test_tools.tools[next_tool]->name());
+            next_tool++;
+        }
+        pages++;
+        cJSON* next_cursor = cJSON_GetObjectItem(root, "nextCursor");
+        if (next_cursor == nullptr) {
+            cJSON_Delete(root);
+            break;
+        }
+        // 下一页的 cursor 是该页的第一个工具
+        cursor = next_cursor->valuestring;
+        CHECK(cursor == test_tools.tools[next_tool]->name());
+        cJSON_Delete(root);
+    }
+    CHECK(pages == tools_list.page_count());
+    CHECK(next_tool == test_tools.tools.size());
+    return true;
+}
+
+// 超过限制的工具之前的页正常返回，从它开始的页返回错误，之后的工具不再分页
+static bool TestToolsListOversizedTool() {
+    TestTools test_tools;
+    test_tools.Add("self.test.a", 100);
+    test_tools.Add("self.test.b", 100);
+    test_tools.Add("self.test.big", 1000);
+    test_tools.Add("self.test.c", 100);
+    McpToolsList tools_list(600);
+    tools_list.Build(test_tools.tools);
+
+    std::string json;
+    CHECK(tools_list.Find("", json));
+    CHECK(json.find("\"nextCursor\":\"self.test.big\"") != std::string::npos);
+    CHECK(!tools_list.Find("self.test.big", json));
+    CHECK(json == "Failed to add tool self.test.big because of payload size limit");
+    CHECK(!tools_list.Find("self.test.c", json));
+    CHECK(json == "Invalid cursor: self.test.c");
+
+    // 第一个工具就超过限制时第一页即为错误
+    TestTools first_oversized;
+    first_oversized.Add("self.test.big", 1000);
+    first_oversized.Add("self.test.a", 100);
+    tools_list.Build(first_oversized.tools);
+    CHECK(tools_list.page_count() == 1);
+    CHECK(!tools_list.Find("", json));
+    CHECK(json == "Failed to add tool self.test.big because of payload size limit");
+    return true;
+}
+
+static bool TestToolsListUnknownCursor() {
+    TestTools test_tools;
+    test_tools.Add("self.test.a", 10);
+    McpToolsList tools_list;
+    std::string json;
+    CHECK(!tools_list.Find("", json));
+
+    tools_list.Build(test_tools.tools);
+    CHECK(tools_list.page_count() == 1);
+    CHECK(tools_list.Find("", json));
+    CHECK(json.find("nextCursor") == std::string::npos);
+    // 工具名只有作为某页的第一个工具时才是有效的 cursor
+    CHECK(!tools_list.Find("self.test.a", json));
+    CHECK(json == "Invalid cursor: self.test.a");
+    CHECK(!tools_list.Find("self.unknown", json));
+    CHECK(json == "Invalid cursor: self.unknown");
+
+    tools_list.Clear();
+    CHECK(tools_list.empty());
+    CHECK(!tools_list.Find("", json));
+    return true;
+}
+
+static bool TestChatMessage() {
+    ChatMessage message;
+    char scratch[64];
+    const char* tts = "{\"type\":\"tts\",\"state\":\"sentence_start\",\"text\":\"\\u4f60\\u597d \\\"hi\\\"\",\"session_id\":\"abc\"}";
+    CHECK(ParseChatMessage(tts, strlen(tts), message, scratch, sizeof(scratch)));
+    CHECK(message.type == "tts");
+    CHECK(message.state == "sentence_start");
+    CHECK(message.text == "你好 \"hi\"");
+    CHECK(message.emotion.empty());
+
+    const char* llm = "{ \"type\" : \"llm\", \"emotion\" : \"happy\", \"text\" : \"😀\" }";
+    CHECK(ParseChatMessage(llm, strlen(llm), message, scratch, sizeof(scratch)));
+    CHECK(message.type == "llm");
+    CHECK(message.emotion == "happy");
+
+    // 嵌套对象和数组交给 cJSON
+    const char* mcp = "{\"type\":\"mcp\",\"payload\":{\"jsonrpc\":\"2.0\"}}";
+    CHECK(!ParseChatMessage(mcp, strlen(mcp), message, scratch, sizeof(scratch)));
+    const char* truncated = "{\"type\":\"tts\",\"state\":\"st";
+    CHECK(!ParseChatMessage(truncated, strlen(truncated), message, scratch, sizeof(scratch)));
+    return true;
+}
+
+// 非字符串的值只接受完整的 true / false / null 和合法的数字
+static bool TestChatMessageLiterals() {
+    ChatMessage message;
+    char scratch[64];
+    const char* valid[] = {
+        "{\"type\":\"tts\",\"a\":true,\"b\":false,\"c\":null}",
+        "{\"type\":\"tts\",\"a\":0,\"b\":-12,\"c\":3.25,\"d\":1e3,\"e\":-0.5E-2}",
+    };
+    for (auto json : valid) {
+        CHECK(ParseChatMessage(json, strlen(json), message, scratch, sizeof(scratch)));
+        CHECK(message.type == "tts");
+    }
+    const char* invalid[] = {
+        "{\"type\":\"tts\",\"a\":tru}",
+        "{\"type\":\"tts\",\"a\":truex}",
+        "{\"type\":\"tts\",\"a\":nul}",
+        "{\"type\":\"tts\",\"a\":False}",
+        "{\"type\":\"tts\",\"a\":abc}",
+        "{\"type\":\"tts\",\"a\":-}",
+        "{\"type\":\"tts\",\"a\":01}",
+        "{\"type\":\"tts\",\"a\":1.}",
+        "{\"type\":\"tts\",\"a\":1e}",
+        "{\"type\":\"tts\",\"a\":+1}",
+    };
+    for (auto json : invalid) {
+        if (ParseChatMessage(json, strlen(json), message, scratch, sizeof(scratch))) {
+            fprintf(stderr, "Accepted %s\n", json);
+            return false;
+        }
+    }
+    return true;
+}
+
+// 快速路径与 cJSON 对同一批消息的解析结果一致
+static bool TestChatMessageCorpus() {
+    char scratch[512];
+    for (auto json : kChatMessageCorpus) {
+        ChatMessage message;
+        CHECK(ParseChatMessage(json, strlen(json), message, scratch, sizeof(scratch)));
+        cJSON* root = cJSON_Parse(json);
+        CHECK(root != nullptr);
+        const char* fields[] = {"type", "state", "text", "emotion"};
+        std::string_view values[] = {message.type, message.state, message.text, message.emotion};
+        for (int i = 0; i < 4; i++) {
+            cJSON* item = cJSON_GetObjectItem(root, fields[i]);
+            CHECK(values[i] == (cJSON_IsString(item) ? item->valuestring : ""));
+        }
+        cJSON_Delete(root);
+    }
+    return true;
+}
+
+static bool TestTaskQueue() {
+    TaskQueue queue;
+    std::vector<int> order;
+    // 超过环形队列容量的任务进入溢出队列，顺序不变
+    const int count = TASK_QUEUE_CAPACITY * 3;
+    for (int i = 0; i < count; i++) {
+        queue.Push([&order, i]() { order.push_back(i); }, i);
+    }
+    char large[TASK_INLINE_SIZE + 8] = {};
+    queue.Push([&order, large]() { order.push_back(count + large[0]); });
+
+    int64_t last_enqueue_time = -1;
+    size_t run = queue.RunPending(count + 1, [&last_enqueue_time](int64_t enqueue_time_us) {
+        last_enqueue_time = enqueue_time_us;
+    });
+    CHECK(run == (size_t)count + 1);
+    CHECK(!queue.HasPending());
+    CHECK(last_enqueue_time == 0);
+    CHECK(order.size() == (size_t)count + 1);
+    for (int i = 0; i <= count; i++) {
+        CHECK(order[i] == i);
+    }
+
+    auto stats = queue.GetStats();
+    CHECK(stats.pushed == (uint32_t)count + 1);
+    CHECK(stats.heap_tasks == 1);
+    CHECK(stats.overflows == (uint32_t)count + 1 - TASK_QUEUE_CAPACITY);
+    return true;
+}
+
+// 多个生产者线程同时 Push (部分任务捕获较大，走堆分配)，单个消费者线程执行:
+// 每个任务恰好执行一次，同一生产者的任务按 Push 的顺序执行。
+// 第一轮生产者满速 Push，大部分任务进入溢出队列；第二轮每个任务后让出 CPU，主要经过环形队列
+static bool TestTaskQueueProducers() {
+    const int producers = 4;
+    const int tasks_per_producer = 20000;
+    for (bool paced : {false, true}) {
+        TaskQueue queue;
+        int next_sequence[producers] = {};
+        int out_of_order = 0;
+        std::atomic<int> started{0};
+
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; p++) {
+            threads.emplace_back([&, p]() {
+                started.fetch_add(1);
+                while (started.load() < producers) {
+                }
+                for (int i = 0; i < tasks_per_producer; i++) {
+                    if (i % 7 == 0) {
+                        char padding[TASK_INLINE_SIZE] = {};
+                        queue.Push([&next_sequence, &out_of_order, p, i, padding]() {
+                            out_of_order += next_sequence[p] != i + padding[0];
+                            next_sequence[p] = i + 1;
+                        });
+                    } else {
+                        queue.Push([&next_sequence, &out_of_order, p, i]() {
+                            out_of_order += next_sequence[p] != i;
+                            next_sequence[p] = i + 1;
+                        });
+                    }
+                    if (paced) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        // 消费者每轮只执行一部分任务，让环形队列经常处于满的状态
+        size_t executed = 0;
+        const size_t total = (size_t)producers * tasks_per_producer;
+        while (executed < total) {
+            size_t count = queue.RunPending(TASK_QUEUE_CAPACITY / 2, [](int64_t) {});
+            executed += count;
+            if (count == 0) {
+                std::this_thread::yield();
+            }
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        CHECK(!queue.HasPending());
+        CHECK(out_of_order == 0);
+        for (int p = 0; p < producers; p++) {
+            CHECK(next_sequence[p] == tasks_per_producer);
+        }
+        auto stats = queue.GetStats();
+        CHECK(stats.pushed == total);
+        CHECK(stats.heap_tasks == (uint32_t)producers * ((tasks_per_producer + 6) / 7));
+        printf("%s: %lu of %lu tasks overflowed\n", paced ? "paced" : "flood", (unsigned long)stats.overflows,
+            (unsigned long)total);
+    }
+    return true;
+}
+
+// 可调用对象在第二次移动 (写入环形队列的槽位) 时阻塞，模拟生产者占位后、写完前被抢占
+struct StallingTask {
+    std::atomic<int>* moves;
+    std::atomic<bool>* reserved;
+    std::atomic<bool>* release;
+    std::vector<int>* order;
+
+    StallingTask(std::atomic<int>* moves, std::atomic<bool>* reserved, std::atomic<bool>* release, std::vector<int>* order)
+        : moves(moves), reserved(reserved), release(release), order(order) {}
+    StallingTask(StallingTask&& other) noexcept
+        : moves(other.moves), reserved(other.reserved), release(other.release), order(other.order) {
+        if (moves->fetch_add(1) + 1 == 2) {
+            reserved->store(true);
+            while (!release->load()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+    void operator()() { order->push_back(0); }
+};
+
+// 生产者占位后停住时，后面已写完的任务不能越过它执行，HasPending 也不能报告有任务，
+// 否则主循环会不停地重新唤醒自己
+static bool TestTaskQueueStalledProducer() {
+    TaskQueue queue;
+    std::vector<int> order;
+    std::atomic<int> moves{0};
+    std::atomic<bool> reserved{false};
+    std::atomic<bool> release{false};
+
+    std::thread producer([&]() {
+        queue.Push(StallingTask(&moves, &reserved, &release, &order));
+    });
+    while (!reserved.load()) {
+        std::this_thread::yield();
+    }
+    CHECK(!queue.HasPending());
+    queue.Push([&order]() { order.push_back(1); });
+    CHECK(!queue.HasPending());
+    CHECK(queue.RunPending(TASK_QUEUE_CAPACITY, [](int64_t) {}) == 0);
+
+    release.store(true);
+    producer.join();
+    CHECK(queue.HasPending());
+    CHECK(queue.RunPending(TASK_QUEUE_CAPACITY, [](int64_t) {}) == 2);
+    CHECK(!queue.HasPending());
+    CHECK(order.size() == 2 && order[0] == 0 && order[1] == 1);
+    return true;
+}
+
+static bool TestFrequencyPolicy() {
+    FrequencyPolicy policy(3000);
+    CHECK(policy.Update(kPowerDemandAudioInput, false, 0) == kFrequencyLevelHigh);
+    CHECK(policy.Update(kPowerDemandAnimation, false, 1000) == kFrequencyLevelHigh);
+    CHECK(policy.Update(kPowerDemandAnimation, false, 4000) == kFrequencyLevelMedium);
+    CHECK(policy.Update(0, true, 4500) == kFrequencyLevelSleep);
+    CHECK(policy.time_in_level_ms(kFrequencyLevelHigh) == 4000);
+    CHECK(policy.time_in_level_ms(kFrequencyLevelMedium) == 500);
+    return true;
+}
+
+// 按 1 秒一次的 Tick 展开: 从 start_ms 到 end_ms (不含) 保持同一组输入
+static void AppendTicks(std::vector<FrequencyTraceSample>& trace, uint32_t start_ms, uint32_t end_ms, uint32_t demands, bool sleep = false) {
+    for (uint32_t time_ms = start_ms; time_ms < end_ms; time_ms += 1000) {
+        trace.push_back({time_ms, demands, sleep});
+    }
+}
+
+// 播放结束后保持 downscale_hold_ms 才降频，之后每个保持周期降一级
+static bool TestFrequencyDownscaleHold() {
+    std::vector<FrequencyTraceSample> trace;
+    AppendTicks(trace, 0, 5000, kPowerDemandAudioOutput);
+    AppendTicks(trace, 5000, 20000, 0);
+    std::vector<FrequencyTransition> transitions;
+    FrequencyPolicy policy(3000);
+    CHECK(policy.Replay(trace, &transitions) == kFrequencyLevelLow);
+
+    CHECK(transitions.size() == 2);
+    CHECK(transitions[0].time_ms == 7000 && transitions[0].from == kFrequencyLevelHigh && transitions[0].to == kFrequencyLevelMedium);
+    CHECK(transitions[1].time_ms == 10000 && transitions[1].from == kFrequencyLevelMedium && transitions[1].to == kFrequencyLevelLow);
+    CHECK(policy.time_in_level_ms(kFrequencyLevelHigh) == 7000);
+    CHECK(policy.time_in_level_ms(kFrequencyLevelMedium) == 3000);
+    CHECK(policy.time_in_level_ms(kFrequencyLevelLow) == 9000);
+    return true;
+}
+
+// 需求间隔短于保持时间时不降频，新的高需求立即升频
+static bool TestFrequencyHysteresis() {
+    std::vector<FrequencyTraceSample> trace;
+    for (uint32_t time_ms = 3000; time_ms < 23000; time_ms += 500) {
+        // 眼球动画每 2.5 秒只有 0.5 秒报告需求
+        trace.push_back({time_ms, time_ms % 2500 == 0 ? (uint32_t)kPowerDemandAnimation : 0, false});
+    }
+    std::vector<FrequencyTransition> transitions;
+    FrequencyPolicy policy(3000);
+    policy.Update(kPowerDemandAnimation, false, 0);
+    policy.Update(kPowerDemandAnimation, false, 3000);
+    CHECK(policy.level() == kFrequencyLevelMedium);
+    policy.Replay(trace, &transitions);
+    CHECK(transitions.empty());
+    CHECK(policy.level() == kFrequencyLevelMedium);
+
+    trace = {{23100, kPowerDemandAudioInput, false}, {23200, kPowerDemandAnimation, false}};
+    policy.Replay(trace, &transitions);
+    CHECK(transitions.size() == 1);
+    CHECK(transitions[0].time_ms == 23100 && transitions[0].to == kFrequencyLevelHigh);
+    CHECK(policy.time_in_level_ms(kFrequencyLevelMedium) == 20100);
+    return true;
+}
+
+// 休眠不等待保持时间，直接降到最低；唤醒后按需求立即升频
+static bool TestFrequencySleep() {
+    std::vector<FrequencyTraceSample> trace;
+    AppendTicks(trace, 0, 2000, kPowerDemandAudioInput);
+    AppendTicks(trace, 2000, 10000, 0, true);
+    trace.push_back({10000, kPowerDemandAudioInput, false});
+    std::vector<FrequencyTransition> transitions;
+    FrequencyPolicy policy(3000);
+    CHECK(policy.Replay(trace, &transitions) == kFrequencyLevelHigh);
+
+    CHECK(transitions.size() == 2);
+    CHECK(transitions[0].time_ms == 2000 && transitions[0].from == kFrequencyLevelHigh && transitions[0].to == kFrequencyLevelSleep);
+    CHECK(transitions[1].time_ms == 10000 && transitions[1].to == kFrequencyLevelHigh);
+    CHECK(policy.time_in_level_ms(kFrequencyLevelSleep) == 8000);
+
+    // 休眠期间有网络需求时保持中等频率
+    CHECK(FrequencyPolicy::RequiredLevel(kPowerDemandNetwork, true) == kFrequencyLevelMedium);
+    CHECK(FrequencyPolicy::RequiredLevel(0, true) == kFrequencyLevelSleep);
+    return true;
+}
+
+// 回放 traces/ 中记录的对话: 连接、唤醒、对话、眨眼、休眠、触摸唤醒
+static bool TestFrequencyRecordedTrace() {
+    std::vector<FrequencyTraceSample> trace;
+    CHECK(LoadFrequencyTrace(HOST_TRACE_DIR "/conversation.log", trace));
+    CHECK(trace.size() > 100);
+    std::vector<FrequencyTransition> transitions;
+    FrequencyPolicy policy(3000);
+    policy.Replay(trace, &transitions);
+
+    std::string levels;
+    for (auto& transition : transitions) {
+        levels += std::string(FrequencyLevelName(transition.to)) + " ";
+    }
+    CHECK(levels == "medium high medium low sleep high medium low ");
+    uint32_t total_ms = 0;
+    for (int i = 0; i < kFrequencyLevelCount; i++) {
+        total_ms += policy.time_in_level_ms((FrequencyLevel)i);
+    }
+    CHECK(total_ms == trace.back().time_ms - trace.front().time_ms);
+    return true;
+}
+
+// 唤醒词一直在运行时 (包括休眠模式)，音频输入需求始终存在，不能降到 low
+static bool TestFrequencyWakeWordIdle() {
+    std::vector<FrequencyTraceSample> trace;
+    CHECK(LoadFrequencyTrace(HOST_TRACE_DIR "/wake_word_idle.log", trace));
+    CHECK(trace.size() > 90);
+    for (auto& sample : trace) {
+        CHECK(sample.demands & kPowerDemandAudioInput);
+    }
+    std::vector<FrequencyTransition> transitions;
+    FrequencyPolicy policy(3000);
+    CHECK(policy.Replay(trace, &transitions) == kFrequencyLevelHigh);
+    CHECK(transitions.empty());
+    CHECK(policy.time_in_level_ms(kFrequencyLevelHigh) == trace.back().time_ms - trace.front().time_ms);
+    return true;
+}
+
+// 模拟链路轨迹: 每段连续 count 个统计周期使用相同的反馈
+struct UplinkTraceSegment {
+    int count;
+    UplinkFeedback feedback;
+};
+
+static UplinkFeedback MakeUplinkFeedback(uint32_t sent, uint32_t failures, uint32_t queue_depth,
+    uint32_t received = 0, uint32_t lost = 0) {
+    UplinkFeedback feedback;
+    feedback.interval_ms = 1000;
+    feedback.packets_sent = sent;
+    feedback.send_failures = failures;
+    feedback.queue_depth = queue_depth;
+    feedback.packets_received = received;
+    feedback.packets_lost = lost;
+    return feedback;
+}
+
+// 返回每个周期结束后的档位
+static std::vector<int> RunUplinkTrace(UplinkRateController& controller, std::initializer_list<UplinkTraceSegment> trace) {
+    std::vector<int> levels;
+    for (auto& segment : trace) {
+        for (int i = 0; i < segment.count; i++) {
+            controller.Update(segment.feedback);
+            levels.push_back(controller.stats().level);
+        }
+    }
+    return levels;
+}
+
+// 发送队列积压: 每隔 2 秒降一档直到 8k + DTX，链路恢复后每 5 个良好周期升一档
+static bool TestUplinkCongestion() {
+    UplinkRateController controller;
+    auto levels = RunUplinkTrace(controller, {
+        {5, MakeUplinkFeedback(50, 0, 0)},
+        {10, MakeUplinkFeedback(20, 0, 6)},
+        {20, MakeUplinkFeedback(50, 0, 0)},
+    });
+    const std::vector<int> expected = {
+        0, 0, 0, 0, 0,
+        1, 1, 2, 2, 3, 3, 4, 4, 4, 4,
+        4, 4, 4, 4, 3, 3, 3, 3, 3, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 0,
+    };
+    CHECK(levels == expected);
+    auto& stats = controller.stats();
+    CHECK(stats.step_downs == 4);
+    CHECK(stats.step_ups == 4);
+    CHECK(stats.congested_intervals == 10);
+    CHECK(stats.bitrate == 0 && !stats.dtx);
+    return true;
+}
+
+// 下行序号空洞作为丢包: 平滑后的丢包率超过阈值才降档，丢包消失后平滑值回落到阈值以下才开始计良好周期
+static bool TestUplinkDownlinkLoss() {
+    UplinkRateController controller;
+    auto levels = RunUplinkTrace(controller, {
+        {1, MakeUplinkFeedback(50, 0, 0, 50, 20)},
+        {1, MakeUplinkFeedback(50, 0, 0, 50, 20)},
+    });
+    CHECK(levels[0] == 0);
+    CHECK(levels[1] == 1);
+    CHECK(controller.stats().loss_permille > 50 && controller.stats().loss_permille < 200);
+
+    levels = RunUplinkTrace(controller, {
+        {12, MakeUplinkFeedback(50, 0, 0, 50, 0)},
+    });
+    CHECK(controller.stats().loss_permille <= 50);
+    CHECK(levels.back() == 0);
+    CHECK(controller.stats().step_ups == 1);
+    // 丢包消失后的第一个周期平滑值仍高于阈值，按拥塞处理，但在降档保持时间内不再降档
+    CHECK(controller.stats().step_downs == 1);
+    CHECK(controller.stats().congested_intervals == 2);
+    return true;
+}
+
+// 计数接近 32 位上限时丢包率不能溢出
+static bool TestUplinkCounterOverflow() {
+    UplinkRateController controller;
+    controller.Update(MakeUplinkFeedback(0xFFFFFFF0u, 0x10, 0, 0x20));
+    CHECK(controller.stats().loss_permille == 0);
+    CHECK(controller.stats().level == 0);
+
+    controller.Reset();
+    controller.Update(MakeUplinkFeedback(100, 0, 0, 0, 5000000));
+    CHECK(controller.stats().loss_permille == 249);
+    return true;
+}
+
+// 模拟两条链路: 每条链路有固定的建连耗时，每 loss_period 次建连失败一次 (0 表示不丢)，down 时全部失败
+class SimulatedPaths : public PathProber {
+public:
+    struct Link {
+        uint32_t rtt_ms = 0;
+        uint32_t loss_period = 0;
+        bool down = false;
+        uint32_t attempts = 0;
+    };
+    Link links[NetworkPathSelector::kPathCount];
+
+    bool Connect(int path, uint32_t& rtt_ms) override {
+        auto& link = links[path];
+        link.attempts++;
+        if (link.down || (link.loss_period > 0 && link.attempts % link.loss_period == 0)) {
+            return false;
+        }
+        rtt_ms = link.rtt_ms;
+        return true;
+    }
+};
+
+// 与 DualNetworkBoard::PathMonitorTask 相同: 每轮依次探测两条链路后选择，返回每轮结束后的链路
+static std::vector<int> RunPathRounds(NetworkPathSelector& selector, SimulatedPaths& paths, int rounds) {
+    std::vector<int> active;
+    for (int round = 0; round < rounds; round++) {
+        for (int path = 0; path < NetworkPathSelector::kPathCount; path++) {
+            selector.Report(path, NetworkPathSelector::Probe(paths, path, 3));
+        }
+        selector.Select();
+        active.push_back(selector.active_path());
+    }
+    return active;
+}
+
+// 两条链路相近或当前链路更快时不切换
+static bool TestNetworkPathHold() {
+    NetworkPathSelector selector;
+    SimulatedPaths paths;
+    paths.links[0].rtt_ms = 60;
+    paths.links[1].rtt_ms = 50;
+    auto active = RunPathRounds(selector, paths, 10);
+    CHECK(active == std::vector<int>(10, 0));
+
+    paths.links[1].rtt_ms = 30;
+    paths.links[1].loss_period = 3;
+    active = RunPathRounds(selector, paths, 10);
+    CHECK(active == std::vector<int>(10, 0));
+    CHECK(selector.quality(1).loss_permille > 300);
+    return true;
+}
+
+// 当前链路变慢后，候选链路连续两轮明显更快才切换，之后不会来回切换
+static bool TestNetworkPathSwitch() {
+    NetworkPathSelector selector;
+    SimulatedPaths paths;
+    paths.links[0].rtt_ms = 40;
+    paths.links[1].rtt_ms = 120;
+    CHECK(RunPathRounds(selector, paths, 5) == std::vector<int>(5, 0));
+
+    paths.links[0].rtt_ms = 400;
+    auto active = RunPathRounds(selector, paths, 6);
+    const std::vector<int> expected = {0, 0, 1, 1, 1, 1};
+    CHECK(active == expected);
+    CHECK(selector.quality(0).srtt_ms > selector.quality(1).srtt_ms);
+    return true;
+}
+
+// 当前链路不可达时下一轮立即切换，两条都不可达时保持不变
+static bool TestNetworkPathUnreachable() {
+    NetworkPathSelector selector;
+    SimulatedPaths paths;
+    paths.links[0].rtt_ms = 40;
+    paths.links[1].rtt_ms = 200;
+    RunPathRounds(selector, paths, 3);
+
+    paths.links[0].down = true;
+    CHECK(RunPathRounds(selector, paths, 1) == std::vector<int>{1});
+    CHECK(!selector.quality(0).reachable);
+
+    paths.links[1].down = true;
+    CHECK(RunPathRounds(selector, paths, 3) == std::vector<int>(3, 1));
+    return true;
+}
+
+static bool TestPosture() {
+    // 端坐时 17 个关键点的大致位置 (x, y)
+    std::vector<int> keypoints = {
+        160, 80, 150, 70, 170, 70, 140, 75, 180, 75,
+        120, 140, 200, 140, 110, 200, 210, 200, 120, 250,
+        200, 250, 130, 260, 190, 260, 130, 330, 190, 330,
+        130, 400, 190, 400,
+    };
+    PostureDetector detector;
+    auto result = detector.AnalyzePosture(keypoints);
+    CHECK(result.valid_keypoints_count == 17);
+    CHECK(result.posture_type != PostureType::UNKNOWN);
+
+    keypoints.pop_back();
+    result = detector.AnalyzePosture(keypoints);
+    CHECK(result.posture_type == PostureType::UNKNOWN);
+    return true;
+}
+
+ESP_EVENT_DEFINE_BASE(HOST_TEST_STATE_EVENTS);
+
+// 只调用关心目标状态的订阅者，没有订阅者关心时不投递事件
+static bool TestStateChangeFilter() {
+    static StateChangeSubscribers subscribers;
+    static int calls[3];
+    static std::atomic<int> posted_calls{0};
+    static DeviceState last_previous_state = kDeviceStateUnknown;
+    CHECK(!subscribers.Wants(kDeviceStateIdle));
+    CHECK(subscribers.Add([](DeviceState previous_state, DeviceState) {
+        last_previous_state = previous_state;
+        calls[0]++;
+        posted_calls++;
+    }, DEVICE_STATE_MASK(kDeviceStateIdle) | DEVICE_STATE_MASK(kDeviceStateListening)));
+    CHECK(subscribers.Add([](DeviceState, DeviceState) { calls[1]++; }, DEVICE_STATE_MASK(kDeviceStateSpeaking)));
+    CHECK(subscribers.Add([](DeviceState, DeviceState) { calls[2]++; }, DEVICE_STATE_MASK(kDeviceStateListening)));
+
+    CHECK(subscribers.Wants(kDeviceStateIdle));
+    CHECK(subscribers.Wants(kDeviceStateSpeaking));
+    CHECK(!subscribers.Wants(kDeviceStateUpgrading));
+    CHECK(subscribers.Dispatch(kDeviceStateStarting, kDeviceStateIdle) == 1);
+    CHECK(subscribers.Dispatch(kDeviceStateStarting, kDeviceStateListening) == 2);
+    CHECK(subscribers.Dispatch(kDeviceStateStarting, kDeviceStateUpgrading) == 0);
+    CHECK(calls[0] == 2 && calls[1] == 0 && calls[2] == 1);
+    CHECK(last_previous_state == kDeviceStateStarting);
+
+    // 通过事件循环投递，只有第一个订阅者关心 Idle
+    esp_err_t err = esp_event_loop_create_default();
+    CHECK(err == ESP_OK || err == ESP_ERR_INVALID_STATE);
+    CHECK(esp_event_handler_register(HOST_TEST_STATE_EVENTS, 0, StateChangeSubscribers::EventHandler, &subscribers) == ESP_OK);
+    CHECK(!subscribers.Post(HOST_TEST_STATE_EVENTS, 0, kDeviceStateStarting, kDeviceStateUpgrading));
+    posted_calls = 0;
+    CHECK(subscribers.Post(HOST_TEST_STATE_EVENTS, 0, kDeviceStateStarting, kDeviceStateIdle));
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (posted_calls.load() == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+    CHECK(posted_calls.load() == 1);
+    CHECK(calls[1] == 0 && calls[2] == 1);
+    esp_event_handler_unregister(HOST_TEST_STATE_EVENTS, 0, StateChangeSubscribers::EventHandler);
+
+    // 订阅者表满后拒绝新的订阅者，已有的掩码不变
+    while (subscribers.Add([](DeviceState, DeviceState) {}, DEVICE_STATE_MASK(kDeviceStateFatalError))) {
+    }
+    CHECK(!subscribers.Add([](DeviceState, DeviceState) {}, DEVICE_STATE_MASK(kDeviceStateUpgrading)));
+    CHECK(!subscribers.Wants(kDeviceStateUpgrading));
+    CHECK(subscribers.Dispatch(kDeviceStateIdle, kDeviceStateFatalError) == DEVICE_STATE_MAX_SUBSCRIBERS - 3);
+    return true;
+}
+
+// 每种眼球都能渲染出缩放后的帧，每帧计数一次
+static bool TestEyeAnimation() {
+    MetricCounter* frames = MetricsRegistry::GetInstance().AddCounter("eye.frames");
+    EyeAnimation eye;
+    eye.begin();
+    eye.setEyelidGap(0);
+    const size_t pixels = (size_t)REAL_SCREEN_WIDTH * REAL_SCREEN_HEIGHT;
+    for (int type = 0; type < EyeAnimation::MAX_EYE_TYPE; type++) {
+        eye.switchEyeType(static_cast<EyeAnimation::EyeType>(type));
+        CHECK(eye.getCurrentEyeType() == type);
+        uint32_t before = frames->Get();
+        for (int i = 0; i < 3; i++) {
+            eye.update();
+        }
+        CHECK(frames->Get() - before == 3);
+        const uint16_t* buffer = eye.getScaledBuffer();
+        size_t lit = 0;
+        for (size_t i = 0; i < pixels; i++) {
+            lit += buffer[i] != 0;
+        }
+        // 猫眼大部分是黑色，只要求画出了内容
+        CHECK(lit > 0);
+    }
+    return true;
+}
+
+static bool FindFrame(const std::vector<uint8_t>& data, size_t& offset, size_t& size) {
+    const uint8_t* frame = nullptr;
+    if (!mjpeg_find_frame(data.data(), data.size(), &frame, &size)) {
+        return false;
+    }
+    offset = frame - data.data();
+    return true;
+}
+
+static bool TestMjpegFrameParser() {
+    size_t offset = 0;
+    size_t size = 0;
+    // 前面是上一帧的尾部，取第一帧完整的 JPEG，EOI 包含在帧内
+    std::vector<uint8_t> data = {0x12, 0xFF, 0xD9, 0xFF, 0x00, 0xFF, 0xD8, 0x01, 0xFF, 0xFF, 0xD9, 0xFF, 0xD8, 0xFF, 0xD9};
+    CHECK(FindFrame(data, offset, size));
+    CHECK(offset == 5 && size == 6);
+
+    // 最短的帧是 SOI 紧跟 EOI
+    data = {0xFF, 0xD8, 0xFF, 0xD9};
+    CHECK(FindFrame(data, offset, size));
+    CHECK(offset == 0 && size == 4);
+
+    // SOI 的第二个字节不能被当成 EOI 的开头
+    data = {0xFF, 0xD8, 0xD9};
+    CHECK(!FindFrame(data, offset, size));
+
+    // 截断的帧和标记只有一半时都不算找到
+    data = {0xFF, 0xD8, 0x01, 0x02, 0xFF};
+    CHECK(!FindFrame(data, offset, size));
+    data = {0x00, 0xFF};
+    CHECK(!FindFrame(data, offset, size));
+
+    // 空缓冲和单字节缓冲不能越界
+    data = {0xFF};
+    CHECK(!FindFrame(data, offset, size));
+    const uint8_t* frame = nullptr;
+    CHECK(!mjpeg_find_frame(nullptr, 0, &frame, &size));
+    return true;
+}
+
+static const struct {
+    const char* name;
+    bool (*function)();
+} kTests[] = {
+    {"property_bind", TestPropertyBind},
+    {"tool_json", TestToolJson},
+    {"tools_list_pages", TestToolsListPages},
+    {"tools_list_oversized_tool", TestToolsListOversizedTool},
+    {"tools_list_unknown_cursor", TestToolsListUnknownCursor},
+    {"chat_message", TestChatMessage},
+    {"chat_message_literals", TestChatMessageLiterals},
+    {"chat_message_corpus", TestChatMessageCorpus},
+    {"task_queue", TestTaskQueue},
+    {"task_queue_producers", TestTaskQueueProducers},
+    {"task_queue_stalled_producer", TestTaskQueueStalledProducer},
+    {"frequency_policy", TestFrequencyPolicy},
+    {"frequency_downscale_hold", TestFrequencyDownscaleHold},
+    {"frequency_hysteresis", TestFrequencyHysteresis},
+    {"frequency_sleep", TestFrequencySleep},
+    {"frequency_recorded_trace", TestFrequencyRecordedTrace},
+    {"frequency_wake_word_idle", TestFrequencyWakeWordIdle},
+    {"uplink_congestion", TestUplinkCongestion},
+    {"uplink_downlink_loss", TestUplinkDownlinkLoss},
+    {"uplink_counter_overflow", TestUplinkCounterOverflow},
+    {"network_path_hold", TestNetworkPathHold},
+    {"network_path_switch", TestNetworkPathSwitch},
+    {"network_path_unreachable", TestNetworkPathUnreachable},
+    {"posture", TestPosture},
+    {"state_change_filter", TestStateChangeFilter},
+    {"eye_animation", TestEyeAnimation},
+    {"mjpeg_frame_parser", TestMjpegFrameParser},
+};
+
+int main(int argc, char** argv) {
+    const char* name = argc > 1 ? argv[1] : nullptr;
+    int count = 0;
+    int failed = 0;
+    for (auto& test : kTests) {
+        if (name != nullptr && strcmp(name, test.name) != 0) {
+            continue;
+        }
+        bool passed = test.function();
+        printf("%-20s %s\n", test.name, passed ? "PASS" : "FAIL");
+        failed += passed ? 0 : 1;
+        count++;
+    }
+    if (count == 0) {
+        fprintf(stderr, "Unknown test: %s\n", name);
+        return 1;
+    }
+    return failed == 0 ? 0 : 1;
+}
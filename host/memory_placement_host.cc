@@ -0,0 +1,27 @@
+#include "memory_placement.h"
+
+#include <cstdlib>
+
+// 主机上只有一种内存，所有缓冲直接用 malloc，策略查询都返回内部 RAM
+
+extern "C" void* memory_placement_malloc(memory_buffer_class_t, size_t size) {
+    return malloc(size);
+}
+
+extern "C" void* memory_placement_calloc(memory_buffer_class_t, size_t count, size_t size) {
+    return calloc(count, size);
+}
+
+extern "C" void memory_placement_free(void* ptr) {
+    free(ptr);
+}
+
+extern "C" memory_region_t memory_placement_region(memory_buffer_class_t) {
+    return MEMORY_REGION_INTERNAL;
+}
+
+extern "C" void memory_placement_print(void) {
+}
+
+extern "C" void memory_placement_register_console_command(void) {
+}
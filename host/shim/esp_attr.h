@@ -0,0 +1,8 @@
+#ifndef HOST_ESP_ATTR_H
+#define HOST_ESP_ATTR_H
+
+// 主机上没有 IRAM，代码放置属性为空
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+#endif // HOST_ESP_ATTR_H
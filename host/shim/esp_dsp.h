@@ -0,0 +1,6 @@
+#ifndef HOST_ESP_DSP_H
+#define HOST_ESP_DSP_H
+
+// 主机编译的模块只包含 esp_dsp.h，没有调用其中的函数
+
+#endif // HOST_ESP_DSP_H
@@ -0,0 +1,140 @@
+#ifndef HOST_ESP_EVENT_H
+#define HOST_ESP_EVENT_H
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * 主机上的默认事件循环：一个线程按投递顺序调用处理函数。
+ * 与设备上一样，投递时复制事件数据并为每个事件分配内存，只支持默认事件循环。
+ */
+typedef const char* esp_event_base_t;
+typedef void (*esp_event_handler_t)(void* handler_args, esp_event_base_t base, int32_t id, void* event_data);
+
+#define ESP_EVENT_ANY_ID -1
+#define ESP_EVENT_DECLARE_BASE(id) extern esp_event_base_t const id
+#define ESP_EVENT_DEFINE_BASE(id) esp_event_base_t const id = #id
+
+class HostEventLoop {
+public:
+    // 不析构，进程退出时循环线程可能仍在等待事件
+    static std::atomic<HostEventLoop*>& Instance() {
+        static std::atomic<HostEventLoop*> instance{nullptr};
+        return instance;
+    }
+
+    HostEventLoop() {
+        std::thread([this]() { Run(); }).detach();
+    }
+
+    void Register(esp_event_base_t base, int32_t id, esp_event_handler_t handler, void* args) {
+        std::lock_guard<std::mutex> lock(handlers_mutex_);
+        handlers_.push_back({base, id, handler, args});
+    }
+
+    void Unregister(esp_event_base_t base, int32_t id, esp_event_handler_t handler) {
+        std::lock_guard<std::mutex> lock(handlers_mutex_);
+        for (auto it = handlers_.begin(); it != handlers_.end();) {
+            if (it->base == base && it->id == id && (handler == nullptr || it->handler == handler)) {
+                it = handlers_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void Post(esp_event_base_t base, int32_t id, const void* data, size_t size) {
+        Event event = {base, id, std::vector<uint8_t>(size)};
+        if (size > 0) {
+            memcpy(event.data.data(), data, size);
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        events_.push_back(std::move(event));
+        condition_.notify_one();
+    }
+
+private:
+    struct Handler {
+        esp_event_base_t base;
+        int32_t id;
+        esp_event_handler_t handler;
+        void* args;
+    };
+    struct Event {
+        esp_event_base_t base;
+        int32_t id;
+        std::vector<uint8_t> data;
+    };
+
+    std::mutex handlers_mutex_;
+    std::vector<Handler> handlers_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<Event> events_;
+
+    void Run() {
+        while (true) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]() { return !events_.empty(); });
+            Event event = std::move(events_.front());
+            events_.pop_front();
+            lock.unlock();
+
+            std::lock_guard<std::mutex> handlers_lock(handlers_mutex_);
+            for (auto& handler : handlers_) {
+                if (handler.base == event.base && (handler.id == ESP_EVENT_ANY_ID || handler.id == event.id)) {
+                    handler.handler(handler.args, event.base, event.id, event.data.empty() ? nullptr : event.data.data());
+                }
+            }
+        }
+    }
+};
+
+inline esp_err_t esp_event_loop_create_default() {
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (HostEventLoop::Instance().load() != nullptr) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    HostEventLoop::Instance().store(new HostEventLoop());
+    return ESP_OK;
+}
+
+inline esp_err_t esp_event_handler_register(esp_event_base_t base, int32_t id, esp_event_handler_t handler, void* args) {
+    auto loop = HostEventLoop::Instance().load();
+    if (loop == nullptr) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    loop->Register(base, id, handler, args);
+    return ESP_OK;
+}
+
+inline esp_err_t esp_event_handler_unregister(esp_event_base_t base, int32_t id, esp_event_handler_t handler) {
+    auto loop = HostEventLoop::Instance().load();
+    if (loop == nullptr) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    loop->Unregister(base, id, handler);
+    return ESP_OK;
+}
+
+// 主机上队列不限长度，不会等待
+inline esp_err_t esp_event_post(esp_event_base_t base, int32_t id, const void* data, size_t size, TickType_t) {
+    auto loop = HostEventLoop::Instance().load();
+    if (loop == nullptr) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    loop->Post(base, id, data, size);
+    return ESP_OK;
+}
+
+#endif // HOST_ESP_EVENT_H
@@ -0,0 +1,23 @@
+#ifndef HOST_ESP_LOG_H
+#define HOST_ESP_LOG_H
+
+#include <cstdarg>
+#include <cstdio>
+
+// 主机上的 esp_log，E/W/I 输出到 stderr，D/V 不输出
+inline void HostLog(char level, const char* tag, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "%c (%s) ", level, tag);
+    vfprintf(stderr, format, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+#define ESP_LOGE(tag, format, ...) HostLog('E', tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) HostLog('W', tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) HostLog('I', tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) do {} while (0)
+#define ESP_LOGV(tag, format, ...) do {} while (0)
+
+#endif // HOST_ESP_LOG_H
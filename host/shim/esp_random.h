@@ -0,0 +1,15 @@
+#ifndef HOST_ESP_RANDOM_H
+#define HOST_ESP_RANDOM_H
+
+#include <cstdint>
+
+// 固定种子的 xorshift，测试和基准每次运行得到相同的序列
+inline uint32_t esp_random() {
+    static uint32_t state = 2463534242u;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+#endif // HOST_ESP_RANDOM_H
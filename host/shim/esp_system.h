@@ -0,0 +1,6 @@
+#ifndef HOST_ESP_SYSTEM_H
+#define HOST_ESP_SYSTEM_H
+
+#include "esp_random.h"
+
+#endif // HOST_ESP_SYSTEM_H
@@ -0,0 +1,15 @@
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+#include <chrono>
+#include <cstdint>
+
+typedef struct esp_timer* esp_timer_handle_t;
+
+// 与设备上一样从启动开始计时，使用单调时钟
+inline int64_t esp_timer_get_time() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+#endif // HOST_ESP_TIMER_H
@@ -0,0 +1,6 @@
+#ifndef HOST_SDKCONFIG_H
+#define HOST_SDKCONFIG_H
+
+// 主机编译不启用任何 Kconfig 选项，代码按默认配置编译
+
+#endif // HOST_SDKCONFIG_H
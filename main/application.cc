@@ -5,12 +5,25 @@
 #include "audio_codec.h"
 #include "mqtt_protocol.h"
 #include "websocket_protocol.h"
+#include "loopback_protocol.h"
+#include "replay_protocol.h"
 #include "font_awesome_symbols.h"
 #include "assets/lang_config.h"
 #include "mcp_server.h"
+#include "http_pool.h"
+#include "task_profiler.h"
+#include "heap_tracker.h"
+#include "timeline_trace.h"
+#include "boot_sequence.h"
+#include "metrics.h"
+#include "benchmark.h"
+#include "memory_placement.h"
+#include "frequency_governor.h"
+#include "task_planner.h"
 
 #include <cstring>
 #include <esp_log.h>
+#include <esp_heap_caps.h>
 #include <cJSON.h>
 #include <driver/gpio.h>
 #include <arpa/inet.h>
@@ -228,6 +241,10 @@ void Application::CheckNewVersion(Ota& ota) {
             }
         }
     }
+
+    // The OTA server is not used again until the next boot, release the idle connections
+    HttpPool::GetInstance().PrintStats();
+    HttpPool::GetInstance().Clear();
 }
 
 void Application::ShowActivationCode(const std::string& code, const std::string& message) {
@@ -301,9 +318,9 @@ void Application::ToggleChatState() {
 
     if (device_state_ == kDeviceStateIdle) {
         Schedule([this]() {
-            if (!protocol_->IsAudioChannelOpened()) {
+            if (channel_opening_ || !protocol_->IsAudioChannelOpened()) {
                 SetDeviceState(kDeviceStateConnecting);
-                if (!protocol_->OpenAudioChannel()) {
+                if (!OpenAudioChannel()) {
                     return;
                 }
             }
@@ -338,9 +355,9 @@ void Application::StartListening() {
     
     if (device_state_ == kDeviceStateIdle) {
         Schedule([this]() {
-            if (!protocol_->IsAudioChannelOpened()) {
+            if (channel_opening_ || !protocol_->IsAudioChannelOpened()) {
                 SetDeviceState(kDeviceStateConnecting);
-                if (!protocol_->OpenAudioChannel()) {
+                if (!OpenAudioChannel()) {
                     return;
                 }
             }
@@ -380,71 +397,23 @@ void Application::StopListening() {
     });
 }
 
-void Application::Start() {
+// Called during boot after the OTA check, returns whether the protocol started
+bool Application::InitializeProtocol(Ota& ota) {
     auto& board = Board::GetInstance();
-    SetDeviceState(kDeviceStateStarting);
-
-    /* Setup the display */
     auto display = board.GetDisplay();
-    mjpeg_player_port_config_t config = {
-    .buffer_size = 64 * 1024,
-    .core_id = 1,
-    .use_psram = true,  // 使用PSRAM减少内存压力
-    .task_priority = 3  // 降低优先级，让音频优先
-    };
-    mjpeg_player_port_init(&config);
-    
-    // 可选：测试新的优化播放器
-    // ESP_LOGI(TAG, "Testing optimized AVI player...");
-    // avi_player_port_play_file_optimized("/sdcard/your_video.mjpeg");
-    /* Setup the audio codec */
-
-    /* Setup the audio service */
     auto codec = board.GetAudioCodec();
-    audio_service_.Initialize(codec);
-    audio_service_.Start();
-
-    AudioServiceCallbacks callbacks;
-    callbacks.on_send_queue_available = [this]() {
-        xEventGroupSetBits(event_group_, MAIN_EVENT_SEND_AUDIO);
-    };
-    callbacks.on_wake_word_detected = [this](const std::string& wake_word) {
-        xEventGroupSetBits(event_group_, MAIN_EVENT_WAKE_WORD_DETECTED);
-    };
-    callbacks.on_vad_change = [this](bool speaking) {
-        xEventGroupSetBits(event_group_, MAIN_EVENT_VAD_CHANGE);
-    };
-    audio_service_.SetCallbacks(callbacks);
-
-    /* Start the clock timer to update the status bar */
-    esp_timer_start_periodic(clock_timer_handle_, 1000000);
-
-    /* Wait for the network to be ready */
-    board.StartNetwork();
-
-    // Update the status bar immediately to show the network state
-    display->UpdateStatusBar(true);
-
-    // Initialize posture detection service if camera is available
-    ESP_LOGI(TAG, "初始化坐姿检测服务...");
-    if (InitializePostureDetection()) {
-        // 延迟启动坐姿检测，等待系统完全初始化
-        Schedule([this]() {
-            StartPostureDetection();
-        });
-        ESP_LOGI(TAG, "坐姿检测将在idle状态下运行，对话时自动暂停");
-    }
-
-    // Check for new firmware version or get the MQTT broker address
-    Ota ota;
-    CheckNewVersion(ota);
-
-    // Initialize the protocol
     display->SetStatus(Lang::Strings::LOADING_PROTOCOL);
 
     // Add MCP common tools before initializing the protocol
     McpServer::GetInstance().AddCommonTools();
 
+#if CONFIG_USE_LOOPBACK_PROTOCOL
+    ESP_LOGW(TAG, "Loopback protocol enabled, audio will be echoed locally");
+    protocol_ = std::make_unique<LoopbackProtocol>();
+#elif CONFIG_USE_REPLAY_PROTOCOL
+    ESP_LOGW(TAG, "Replay protocol enabled, incoming messages come from %s", CONFIG_REPLAY_SESSION_FILE);
+    protocol_ = std::make_unique<ReplayProtocol>(CONFIG_REPLAY_SESSION_FILE, CONFIG_REPLAY_SPEED_PERCENT);
+#else
     if (ota.HasMqttConfig()) {
         protocol_ = std::make_unique<MqttProtocol>();
     } else if (ota.HasWebsocketConfig()) {
@@ -453,6 +422,7 @@ void Application::Start() {
         ESP_LOGW(TAG, "No protocol specified in the OTA config, using MQTT");
         protocol_ = std::make_unique<MqttProtocol>();
     }
+#endif
 
     protocol_->OnNetworkError([this](const std::string& message) {
         last_error_message_ = message;
@@ -463,67 +433,64 @@ void Application::Start() {
             audio_service_.PushPacketToDecodeQueue(std::move(packet));
         }
     });
-    protocol_->OnAudioChannelOpened([this, codec, &board]() {
+    protocol_->OnAudioChannelOpened([this, codec]() {
+        auto& board = Board::GetInstance();
+        // 新连接从默认码率重新开始
+        uplink_controller_.Reset();
+        audio_service_.SetUplinkBitrate(uplink_controller_.bitrate(), uplink_controller_.dtx());
+        last_link_stats_ = protocol_->link_stats();
+        audio_service_.ResetSendQueueStats();
+        audio_channel_opened_ = true;
         board.SetPowerSaveMode(false);
         if (protocol_->server_sample_rate() != codec->output_sample_rate()) {
             ESP_LOGW(TAG, "Server sample rate %d does not match device output sample rate %d, resampling may cause distortion",
                 protocol_->server_sample_rate(), codec->output_sample_rate());
         }
+#if CONFIG_USE_SESSION_RECORDER
+        // 8.3 文件名，兼容未开启长文件名的 FAT
+        char path[64];
+        snprintf(path, sizeof(path), "%s/%08lx.xzs", CONFIG_SESSION_RECORD_DIR, (uint32_t)time(nullptr));
+        protocol_->StartRecording(path);
+#endif
     });
-    protocol_->OnAudioChannelClosed([this, &board]() {
+    protocol_->OnAudioChannelClosed([this]() {
+        auto& board = Board::GetInstance();
+        audio_channel_opened_ = false;
         board.SetPowerSaveMode(true);
+#if CONFIG_USE_SESSION_RECORDER
+        protocol_->StopRecording();
+#endif
         Schedule([this]() {
             auto display = Board::GetInstance().GetDisplay();
+            chat_display_sequence_++;
             display->SetChatMessage("system", "");
             SetDeviceState(kDeviceStateIdle);
         });
     });
+    protocol_->OnIncomingChatMessage([this](const ChatMessage& message) {
+        OnChatMessage(message);
+    });
     protocol_->OnIncomingJson([this, display](const cJSON* root) {
         // Parse JSON data
         auto type = cJSON_GetObjectItem(root, "type");
-        if (strcmp(type->valuestring, "tts") == 0) {
+        if (strcmp(type->valuestring, "tts") == 0 || strcmp(type->valuestring, "stt") == 0 ||
+            strcmp(type->valuestring, "llm") == 0) {
+            // Chat messages that the fast path could not handle, e.g. long escaped text
+            ChatMessage message;
+            message.type = type->valuestring;
             auto state = cJSON_GetObjectItem(root, "state");
-            if (strcmp(state->valuestring, "start") == 0) {
-                Schedule([this]() {
-                    aborted_ = false;
-                    if (device_state_ == kDeviceStateIdle || device_state_ == kDeviceStateListening) {
-                        SetDeviceState(kDeviceStateSpeaking);
-                    }
-                });
-            } else if (strcmp(state->valuestring, "stop") == 0) {
-                Schedule([this]() {
-                    if (device_state_ == kDeviceStateSpeaking) {
-                        if (listening_mode_ == kListeningModeManualStop) {
-                            SetDeviceState(kDeviceStateIdle);
-                        } else {
-                            SetDeviceState(kDeviceStateListening);
-                        }
-                    }
-                });
-            } else if (strcmp(state->valuestring, "sentence_start") == 0) {
-                auto text = cJSON_GetObjectItem(root, "text");
-                if (cJSON_IsString(text)) {
-                    ESP_LOGI(TAG, "<< %s", text->valuestring);
-                    Schedule([this, display, message = std::string(text->valuestring)]() {
-                        display->SetChatMessage("assistant", message.c_str());
-                    });
-                }
-            }
-        } else if (strcmp(type->valuestring, "stt") == 0) {
             auto text = cJSON_GetObjectItem(root, "text");
+            auto emotion = cJSON_GetObjectItem(root, "emotion");
+            if (cJSON_IsString(state)) {
+                message.state = state->valuestring;
+            }
             if (cJSON_IsString(text)) {
-                ESP_LOGI(TAG, ">> %s", text->valuestring);
-                Schedule([this, display, message = std::string(text->valuestring)]() {
-                    display->SetChatMessage("user", message.c_str());
-                });
+                message.text = text->valuestring;
             }
-        } else if (strcmp(type->valuestring, "llm") == 0) {
-            auto emotion = cJSON_GetObjectItem(root, "emotion");
             if (cJSON_IsString(emotion)) {
-                Schedule([this, display, emotion_str = std::string(emotion->valuestring)]() {
-                    // display->SetEmotion(emotion_str.c_str());
-                });
+                message.emotion = emotion->valuestring;
             }
+            OnChatMessage(message);
         } else if (strcmp(type->valuestring, "mcp") == 0) {
             auto payload = cJSON_GetObjectItem(root, "payload");
             if (cJSON_IsObject(payload)) {
@@ -556,7 +523,7 @@ void Application::Start() {
             auto payload = cJSON_GetObjectItem(root, "payload");
             ESP_LOGI(TAG, "Received custom message: %s", cJSON_PrintUnformatted(root));
             if (cJSON_IsObject(payload)) {
-                Schedule([this, display, payload_str = std::string(cJSON_PrintUnformatted(payload))]() {
+                Schedule(kTaskPriorityUi, [this, display, payload_str = std::string(cJSON_PrintUnformatted(payload))]() {
                     display->SetChatMessage("system", payload_str.c_str());
                 });
             } else {
@@ -567,7 +534,121 @@ void Application::Start() {
             ESP_LOGW(TAG, "Unknown message type: %s", type->valuestring);
         }
     });
-    bool protocol_started = protocol_->Start();
+    return protocol_->Start();
+}
+
+void Application::Start() {
+    auto& board = Board::GetInstance();
+    SetDeviceState(kDeviceStateStarting);
+
+#if CONFIG_USE_TASK_PROFILER
+    TaskProfiler::GetInstance().Start(CONFIG_TASK_PROFILER_INTERVAL_MS);
+#endif
+#if CONFIG_USE_HEAP_TRACKER
+    HeapTracker::GetInstance().Start();
+#endif
+#if CONFIG_USE_TIMELINE_TRACE
+    TimelineTrace::GetInstance().Start();
+#endif
+#if CONFIG_USE_BENCHMARK
+    Benchmark::GetInstance().RegisterConsoleCommand();
+#endif
+    memory_placement_register_console_command();
+    TaskPlanner::GetInstance().RegisterConsoleCommand();
+
+    /* Start the clock timer to update the status bar */
+    esp_timer_start_periodic(clock_timer_handle_, 1000000);
+
+    auto display = board.GetDisplay();
+    Ota ota;
+    bool protocol_started = false;
+
+    /*
+     * 启动阶段及依赖关系，没有依赖关系的阶段并行执行：
+     *   display ─┬──────────── posture ──┐
+     *   audio ───┼─ network ─────────────┼─ ota ─ protocol
+     *            └─ models ──────────────┘
+     * 联网失败进入配网模式时会播放提示音，所以 network 依赖 audio；
+     * 唤醒词、AFE 模型与联网并行加载，ota 的升级流程会停止并重启音频服务，所以必须等模型加载完成
+     */
+    BootSequence boot;
+    int display_phase = boot.AddPhase("display", {}, []() {
+        auto& planner = TaskPlanner::GetInstance();
+        mjpeg_player_port_config_t config = {
+        .buffer_size = 64 * 1024,
+        .core_id = planner.GetCoreId(kTaskRoleMjpegManager),
+        .use_psram = true,  // 使用PSRAM减少内存压力
+        .task_priority = planner.Get(kTaskRoleMjpegManager).priority
+        };
+        mjpeg_player_port_init(&config);
+
+        // 可选：测试新的优化播放器
+        // ESP_LOGI(TAG, "Testing optimized AVI player...");
+        // avi_player_port_play_file_optimized("/sdcard/your_video.mjpeg");
+    });
+
+    int audio_phase = boot.AddPhase("audio", {}, [this, &board]() {
+        auto codec = board.GetAudioCodec();
+        audio_service_.Initialize(codec);
+        audio_service_.Start();
+
+        AudioServiceCallbacks callbacks;
+        callbacks.on_send_queue_available = [this]() {
+            xEventGroupSetBits(event_group_, MAIN_EVENT_SEND_AUDIO);
+        };
+        callbacks.on_wake_word_detected = [this](const std::string& wake_word) {
+            wake_word_detected_time_us_.store(esp_timer_get_time(), std::memory_order_relaxed);
+#if CONFIG_USE_SPECULATIVE_CHANNEL_OPEN
+            PreOpenAudioChannel();
+#endif
+            xEventGroupSetBits(event_group_, MAIN_EVENT_WAKE_WORD_DETECTED);
+        };
+        callbacks.on_vad_change = [this](bool speaking) {
+            xEventGroupSetBits(event_group_, MAIN_EVENT_VAD_CHANGE);
+        };
+        audio_service_.SetCallbacks(callbacks);
+    });
+
+    int models_phase = boot.AddPhase("models", {audio_phase}, [this]() {
+        audio_service_.PreloadModels();
+    });
+
+    int network_phase = boot.AddPhase("network", {display_phase, audio_phase}, [&board, display]() {
+        board.StartNetwork();
+        // Update the status bar immediately to show the network state
+        display->UpdateStatusBar(true);
+    });
+
+    int posture_phase = boot.AddPhase("posture", {display_phase}, [this]() {
+        // Initialize posture detection service if camera is available
+        ESP_LOGI(TAG, "初始化坐姿检测服务...");
+        if (InitializePostureDetection()) {
+            // 延迟启动坐姿检测，等待系统完全初始化
+            Schedule(kTaskPriorityBackground, [this]() {
+                StartPostureDetection();
+            });
+            ESP_LOGI(TAG, "坐姿检测将在idle状态下运行，对话时自动暂停");
+        }
+    });
+
+    // Check for new firmware version or get the MQTT broker address
+    int ota_phase = boot.AddPhase("ota", {network_phase, posture_phase, models_phase}, [this, &ota]() {
+        CheckNewVersion(ota);
+    });
+
+    boot.AddPhase("protocol", {ota_phase}, [this, &ota, &protocol_started]() {
+        protocol_started = InitializeProtocol(ota);
+    });
+
+#if CONFIG_USE_PARALLEL_BOOT
+    boot.Run(true);
+#else
+    boot.Run(false);
+#endif
+    boot.PrintTimeline();
+    memory_placement_print();
+    TaskPlanner::GetInstance().Print();
+    TaskPlanner::GetInstance().StartLoadCheck(30000);
 
     SetDeviceState(kDeviceStateIdle);
 
@@ -587,27 +668,118 @@ void Application::Start() {
     MainEventLoop();
 }
 
+// TTS 开始/结束影响音频收发，放在 realtime 通道；文本和表情放在 ui 通道，不会推迟音频发送。
+// 显示任务带上排队时的序号，执行前序号已变化 (状态切换清空了聊天内容) 则丢弃，旧文本不会出现在新会话中
+void Application::OnChatMessage(const ChatMessage& message) {
+    auto display = Board::GetInstance().GetDisplay();
+    uint32_t sequence = chat_display_sequence_.load();
+    if (message.type == "tts") {
+        if (message.state == "start") {
+            Schedule(kTaskPriorityRealtime, [this]() {
+                aborted_ = false;
+                if (device_state_ == kDeviceStateIdle || device_state_ == kDeviceStateListening) {
+                    SetDeviceState(kDeviceStateSpeaking);
+                }
+            });
+        } else if (message.state == "stop") {
+            Schedule(kTaskPriorityRealtime, [this]() {
+                if (device_state_ == kDeviceStateSpeaking) {
+                    if (listening_mode_ == kListeningModeManualStop) {
+                        SetDeviceState(kDeviceStateIdle);
+                    } else {
+                        SetDeviceState(kDeviceStateListening);
+                    }
+                }
+            });
+        } else if (message.state == "sentence_start" && message.text.data() != nullptr) {
+            ESP_LOGI(TAG, "<< %.*s", (int)message.text.size(), message.text.data());
+            Schedule(kTaskPriorityUi, [this, display, sequence, text = std::string(message.text)]() {
+                if (sequence == chat_display_sequence_) {
+                    display->SetChatMessage("assistant", text.c_str());
+                }
+            });
+        }
+    } else if (message.type == "stt") {
+        if (message.text.data() != nullptr) {
+            ESP_LOGI(TAG, ">> %.*s", (int)message.text.size(), message.text.data());
+            Schedule(kTaskPriorityUi, [this, display, sequence, text = std::string(message.text)]() {
+                if (sequence == chat_display_sequence_) {
+                    display->SetChatMessage("user", text.c_str());
+                }
+            });
+        }
+    } else if (message.type == "llm") {
+        if (message.emotion.data() != nullptr) {
+            Schedule(kTaskPriorityUi, [this, display, emotion_str = std::string(message.emotion)]() {
+                // display->SetEmotion(emotion_str.c_str());
+            });
+        }
+    }
+}
+
 void Application::OnClockTimer() {
     clock_ticks_++;
+    FrequencyGovernor::GetInstance().Tick();
 
     auto display = Board::GetInstance().GetDisplay();
     display->UpdateStatusBar();
 
+    if (audio_channel_opened_ && (device_state_ == kDeviceStateListening || device_state_ == kDeviceStateSpeaking)) {
+        UpdateUplinkRate();
+    }
+
     // Print the debug info every 10 seconds
     if (clock_ticks_ % 10 == 0) {
         // SystemInfo::PrintTaskCpuUsage(pdMS_TO_TICKS(1000));
         // SystemInfo::PrintTaskList();
-        SystemInfo::PrintHeapStats();
+        static auto& metrics = MetricsRegistry::GetInstance();
+        static auto internal_free = metrics.AddGauge("heap.internal_free");
+        static auto internal_min_free = metrics.AddGauge("heap.internal_min_free");
+        static auto psram_free = metrics.AddGauge("heap.psram_free");
+        internal_free->Set(heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+        internal_min_free->Set(heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL));
+        psram_free->Set(heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+        metrics.LogSummary();
+#if CONFIG_USE_HEAP_TRACKER
+        HeapTracker::GetInstance().CheckLowMemory();
+#endif
+        Schedule(kTaskPriorityBackground, [this]() {
+            PrintTaskLatency();
+        });
+        if (audio_channel_opened_) {
+            auto& stats = uplink_controller_.stats();
+            ESP_LOGI(TAG, "Uplink: level=%d bitrate=%d dtx=%d loss=%lu%% down=%lu up=%lu congested=%lu",
+                stats.level, stats.bitrate, stats.dtx, stats.loss_permille / 10,
+                stats.step_downs, stats.step_ups, stats.congested_intervals);
+            auto queue_stats = audio_service_.GetSendQueueStats();
+            ESP_LOGI(TAG, "Send queue: sent=%lu dropped=%lu (%lu ms, speech %lu ms) catch_up=%lu delay p50=%lu p90=%lu p99=%lu max=%lu ms",
+                queue_stats.sent_packets, queue_stats.dropped_packets, queue_stats.dropped_ms, queue_stats.dropped_speech_ms,
+                queue_stats.catch_up_count, queue_stats.delay_p50_ms, queue_stats.delay_p90_ms, queue_stats.delay_p99_ms,
+                queue_stats.delay_max_ms);
+        }
     }
 }
 
-// Add a async task to MainLoop
-void Application::Schedule(std::function<void()> callback) {
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        main_tasks_.push_back(std::move(callback));
+// Called every second from the clock timer, the link counters are plain uint32_t
+// so reading them from this task is safe
+void Application::UpdateUplinkRate() {
+    auto& link_stats = protocol_->link_stats();
+    UplinkFeedback feedback;
+    feedback.interval_ms = 1000;
+    feedback.packets_sent = link_stats.packets_sent - last_link_stats_.packets_sent;
+    feedback.send_failures = link_stats.send_failures - last_link_stats_.send_failures;
+    feedback.packets_received = link_stats.packets_received - last_link_stats_.packets_received;
+    feedback.packets_lost = link_stats.packets_lost - last_link_stats_.packets_lost;
+    feedback.queue_depth = audio_service_.TakeSendQueueHighWater();
+    last_link_stats_ = link_stats;
+
+    if (uplink_controller_.Update(feedback)) {
+        auto& stats = uplink_controller_.stats();
+        ESP_LOGI(TAG, "Uplink level %d: bitrate %d, dtx %d (loss %lu permille, queue %lu, failures %lu)",
+            stats.level, stats.bitrate, stats.dtx, stats.loss_permille,
+            feedback.queue_depth, feedback.send_failures);
+        audio_service_.SetUplinkBitrate(stats.bitrate, stats.dtx);
     }
-    xEventGroupSetBits(event_group_, MAIN_EVENT_SCHEDULE);
 }
 
 // The Main Event Loop controls the chat state and websocket connection
@@ -615,7 +787,7 @@ void Application::Schedule(std::function<void()> callback) {
 // they should use Schedule to call this function
 void Application::MainEventLoop() {
     // Raise the priority of the main event loop to avoid being interrupted by background tasks (which has priority 2)
-    vTaskPrioritySet(NULL, 3);
+    vTaskPrioritySet(NULL, TaskPlanner::GetInstance().Get(kTaskRoleMainLoop).priority);
 
     while (true) {
         auto bits = xEventGroupWaitBits(event_group_, MAIN_EVENT_SCHEDULE |
@@ -629,11 +801,7 @@ void Application::MainEventLoop() {
         }
 
         if (bits & MAIN_EVENT_SEND_AUDIO) {
-            while (auto packet = audio_service_.PopPacketFromSendQueue()) {
-                if (!protocol_->SendAudio(std::move(packet))) {
-                    break;
-                }
-            }
+            SendPendingAudio();
         }
 
         if (bits & MAIN_EVENT_WAKE_WORD_DETECTED) {
@@ -648,13 +816,58 @@ void Application::MainEventLoop() {
         }
 
         if (bits & MAIN_EVENT_SCHEDULE) {
-            std::unique_lock<std::mutex> lock(mutex_);
-            auto tasks = std::move(main_tasks_);
-            lock.unlock();
-            for (auto& task : tasks) {
-                task();
-            }
+            RunScheduledTasks();
+        }
+    }
+}
+
+void Application::SendPendingAudio() {
+    for (int i = 0; i < MAIN_LOOP_AUDIO_PACKETS_PER_PASS; i++) {
+        auto packet = audio_service_.PopPacketFromSendQueue();
+        if (!packet) {
+            return;
+        }
+        if (!protocol_->SendAudio(std::move(packet))) {
+            return;
+        }
+    }
+    // There may be more packets, continue in the next pass after other events are handled
+    xEventGroupSetBits(event_group_, MAIN_EVENT_SEND_AUDIO);
+}
+
+void Application::RunScheduledTasks() {
+    static const size_t budgets[kTaskPriorityCount] = { TASK_QUEUE_CAPACITY, 8, 4, 1 };
+    bool pending = false;
+    for (int lane = 0; lane < kTaskPriorityCount; lane++) {
+        auto& latency = task_latency_[lane];
+        main_tasks_[lane].RunPending(budgets[lane], [&latency](int64_t enqueue_time_us) {
+            latency.Record(esp_timer_get_time() - enqueue_time_us);
+        });
+        // Only counts tasks ready to run, a producer still writing its slot sets MAIN_EVENT_SCHEDULE itself
+        pending |= main_tasks_[lane].HasPending();
+
+        // Audio packets queued while the lane was running go out before the next lane
+        if (xEventGroupClearBits(event_group_, MAIN_EVENT_SEND_AUDIO) & MAIN_EVENT_SEND_AUDIO) {
+            SendPendingAudio();
+        }
+    }
+    if (pending) {
+        xEventGroupSetBits(event_group_, MAIN_EVENT_SCHEDULE);
+    }
+}
+
+void Application::PrintTaskLatency() {
+    static const char* const lane_names[kTaskPriorityCount] = { "realtime", "control", "ui", "background" };
+    for (int lane = 0; lane < kTaskPriorityCount; lane++) {
+        auto& latency = task_latency_[lane];
+        if (latency.tasks == 0) {
+            continue;
         }
+        auto queue_stats = main_tasks_[lane].GetStats();
+        ESP_LOGI(TAG, "Lane %s: tasks=%lu wait avg=%d us p50<=%lu ms p99<=%lu ms max=%lu us heap=%lu overflow=%lu",
+            lane_names[lane], latency.tasks, (int)(latency.total_us / latency.tasks), latency.PercentileMs(50),
+            latency.PercentileMs(99), latency.max_us, queue_stats.heap_tasks, queue_stats.overflows);
+        latency = TaskLatencyStats();
     }
 }
 
@@ -669,16 +882,17 @@ void Application::OnWakeWordDetected() {
         
         audio_service_.EncodeWakeWord();
 
-        if (!protocol_->IsAudioChannelOpened()) {
+        if (channel_opening_ || !protocol_->IsAudioChannelOpened()) {
             SetDeviceState(kDeviceStateConnecting);
-            if (!protocol_->OpenAudioChannel()) {
+            if (!OpenAudioChannel()) {
                 audio_service_.EnableWakeWordDetection(true);
                 return;
             }
         }
 
         auto wake_word = audio_service_.GetLastWakeWord();
-        ESP_LOGI(TAG, "Wake word detected: %s", wake_word.c_str());
+        ESP_LOGI(TAG, "Wake word detected: %s, channel ready in %d ms", wake_word.c_str(),
+            (int)((esp_timer_get_time() - wake_word_detected_time_us_.load(std::memory_order_relaxed)) / 1000));
 #if CONFIG_USE_AFE_WAKE_WORD || CONFIG_USE_CUSTOM_WAKE_WORD
         // Encode and send the wake word data to the server
         while (auto packet = audio_service_.PopWakeWordPacket()) {
@@ -699,6 +913,59 @@ void Application::OnWakeWordDetected() {
     }
 }
 
+// Called on the audio input task as soon as the wake word is detected, so that
+// DNS / TCP / TLS / hello run in parallel with the wake word sound and Opus encoding
+void Application::PreOpenAudioChannel() {
+    if (!protocol_ || device_state_ != kDeviceStateIdle || audio_channel_opened_) {
+        return;
+    }
+
+    // 先清除完成标志再占用，等待者看到 channel_opening_ 时不会读到上一次的结果
+    xEventGroupClearBits(event_group_, MAIN_EVENT_CHANNEL_OPEN_DONE);
+    bool expected = false;
+    if (!channel_opening_.compare_exchange_strong(expected, true)) {
+        return;
+    }
+    BaseType_t ret = xTaskCreate([](void* arg) {
+        Application* app = (Application*)arg;
+        int64_t start_time = esp_timer_get_time();
+        app->channel_open_result_ = app->protocol_->OpenAudioChannel();
+        ESP_LOGI(TAG, "Speculative channel open %s in %d ms", app->channel_open_result_ ? "done" : "failed",
+            (int)((esp_timer_get_time() - start_time) / 1000));
+        app->channel_opening_ = false;
+        xEventGroupSetBits(app->event_group_, MAIN_EVENT_CHANNEL_OPEN_DONE);
+        vTaskDelete(NULL);
+    }, "channel_open", 4096 * 2, this, 4, nullptr);
+    if (ret != pdPASS) {
+        ESP_LOGW(TAG, "Failed to create channel open task");
+        channel_open_result_ = false;
+        channel_opening_ = false;
+        xEventGroupSetBits(event_group_, MAIN_EVENT_CHANNEL_OPEN_DONE);
+    }
+}
+
+// The only place that opens the audio channel from the main loop, it joins the speculative open if any
+bool Application::OpenAudioChannel() {
+    // 与 PreOpenAudioChannel 相同，先清除完成标志再占用，占用失败说明推测建立正在进行
+    xEventGroupClearBits(event_group_, MAIN_EVENT_CHANNEL_OPEN_DONE);
+    bool expected = false;
+    if (!channel_opening_.compare_exchange_strong(expected, true)) {
+        xEventGroupWaitBits(event_group_, MAIN_EVENT_CHANNEL_OPEN_DONE, pdFALSE, pdFALSE, portMAX_DELAY);
+        return channel_open_result_ && protocol_->IsAudioChannelOpened();
+    }
+
+    bool opened = protocol_->IsAudioChannelOpened();
+    if (!opened) {
+        int64_t start_time = esp_timer_get_time();
+        opened = protocol_->OpenAudioChannel();
+        ESP_LOGI(TAG, "Channel open %s in %d ms", opened ? "done" : "failed", (int)((esp_timer_get_time() - start_time) / 1000));
+    }
+    channel_open_result_ = opened;
+    channel_opening_ = false;
+    xEventGroupSetBits(event_group_, MAIN_EVENT_CHANNEL_OPEN_DONE);
+    return opened;
+}
+
 void Application::AbortSpeaking(AbortReason reason) {
     ESP_LOGI(TAG, "Abort speaking");
     
@@ -720,7 +987,7 @@ void Application::SetDeviceState(DeviceState state) {
     }
     
     clock_ticks_ = 0;
-    auto previous_state = device_state_;
+    DeviceState previous_state = device_state_;
     device_state_ = state;
     ESP_LOGI(TAG, "STATE: %s", STATE_STRINGS[device_state_]);
 
@@ -730,6 +997,9 @@ void Application::SetDeviceState(DeviceState state) {
     // 智能坐姿检测控制：只在idle状态下运行，对话时暂停
     ManagePostureDetectionByState(previous_state, state);
 
+    FrequencyGovernor::GetInstance().SetDemand(kPowerDemandNetwork, state == kDeviceStateStarting ||
+        state == kDeviceStateConnecting || state == kDeviceStateActivating || state == kDeviceStateUpgrading);
+
     auto& board = Board::GetInstance();
     auto display = board.GetDisplay();
     auto led = board.GetLed();
@@ -745,6 +1015,7 @@ void Application::SetDeviceState(DeviceState state) {
         case kDeviceStateConnecting:
             display->SetStatus(Lang::Strings::CONNECTING);
             display->SetEmotion("xiaoliang.mjpeg");
+            chat_display_sequence_++;
             display->SetChatMessage("system", "");
             break;
         case kDeviceStateListening:
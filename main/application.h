@@ -11,10 +11,13 @@
 #include <deque>
 #include <vector>
 #include <memory>
+#include <atomic>
 
 #include "protocol.h"
+#include "task_queue.h"
 #include "ota.h"
 #include "audio_service.h"
+#include "uplink_rate_controller.h"
 #include "device_state_event.h"
 #include "posture_service.h"
 
@@ -24,6 +27,19 @@
 #define MAIN_EVENT_VAD_CHANGE (1 << 3)
 #define MAIN_EVENT_ERROR (1 << 4)
 #define MAIN_EVENT_CHECK_NEW_VERSION_DONE (1 << 5)
+#define MAIN_EVENT_CHANNEL_OPEN_DONE (1 << 6)
+
+// 主循环每轮最多发送的音频包数，剩余的下一轮继续，避免慢速链路上长时间占用主循环
+#define MAIN_LOOP_AUDIO_PACKETS_PER_PASS 8
+
+// 主循环任务的优先级通道，按顺序执行，每个通道每轮有执行上限，低优先级通道每轮至少执行一个任务
+enum TaskPriority {
+    kTaskPriorityRealtime,      // 影响音频收发的状态切换，例如 TTS 开始/结束
+    kTaskPriorityControl,       // 设备状态、协议消息，Schedule 默认使用
+    kTaskPriorityUi,            // 聊天消息、表情等显示更新
+    kTaskPriorityBackground,    // 统计输出、坐姿检测等
+    kTaskPriorityCount
+};
 
 enum AecMode {
     kAecOff,
@@ -44,7 +60,16 @@ public:
     void Start();
     DeviceState GetDeviceState() const { return device_state_; }
     bool IsVoiceDetected() const { return audio_service_.IsVoiceDetected(); }
-    void Schedule(std::function<void()> callback);
+    // Add an async task to MainLoop, small captures are stored without heap allocation
+    template <typename F>
+    void Schedule(F&& callback) {
+        Schedule(kTaskPriorityControl, std::forward<F>(callback));
+    }
+    template <typename F>
+    void Schedule(TaskPriority priority, F&& callback) {
+        main_tasks_[priority].Push(std::forward<F>(callback), esp_timer_get_time());
+        xEventGroupSetBits(event_group_, MAIN_EVENT_SCHEDULE);
+    }
     void SetDeviceState(DeviceState state);
     void Alert(const char* status, const char* message, const char* emotion = "", const std::string_view& sound = "");
     void DismissAlert();
@@ -74,12 +99,12 @@ private:
     Application();
     ~Application();
 
-    std::mutex mutex_;
-    std::deque<std::function<void()>> main_tasks_;
+    TaskQueue main_tasks_[kTaskPriorityCount];
+    TaskLatencyStats task_latency_[kTaskPriorityCount];
     std::unique_ptr<Protocol> protocol_;
     EventGroupHandle_t event_group_ = nullptr;
     esp_timer_handle_t clock_timer_handle_ = nullptr;
-    volatile DeviceState device_state_ = kDeviceStateUnknown;
+    std::atomic<DeviceState> device_state_ = kDeviceStateUnknown;  // 音频任务在预建通道时读取
     ListeningMode listening_mode_ = kListeningModeAutoStop;
     AecMode aec_mode_ = kAecOff;
     std::string last_error_message_;
@@ -87,14 +112,34 @@ private:
 
     bool has_server_time_ = false;
     bool aborted_ = false;
+    // 清空聊天内容时加一，之前排队的聊天显示任务发现序号变化后不再显示
+    std::atomic<uint32_t> chat_display_sequence_ = 0;
     int clock_ticks_ = 0;
     TaskHandle_t check_new_version_task_handle_ = nullptr;
 
+    // 唤醒词检测后提前建立音频通道
+    std::atomic<bool> audio_channel_opened_ = false;
+    std::atomic<bool> channel_opening_ = false;     // 建立通道的一方用 compare_exchange 占用
+    std::atomic<bool> channel_open_result_ = false;
+    std::atomic<int64_t> wake_word_detected_time_us_ = 0;   // 唤醒词任务写入，主循环读取，32 位芯片上 64 位读写不是原子的
+
+    // 根据链路状况调整上行码率
+    UplinkRateController uplink_controller_;
+    LinkStats last_link_stats_;
+
     void MainEventLoop();
+    void SendPendingAudio();
+    void RunScheduledTasks();
+    void PrintTaskLatency();
     void OnWakeWordDetected();
+    void PreOpenAudioChannel();
+    bool OpenAudioChannel();
     void CheckNewVersion(Ota& ota);
+    bool InitializeProtocol(Ota& ota);
     void ShowActivationCode(const std::string& code, const std::string& message);
     void OnClockTimer();
+    void UpdateUplinkRate();
+    void OnChatMessage(const ChatMessage& message);
     void SetListeningMode(ListeningMode mode);
 };
 
@@ -0,0 +1,75 @@
+#include "adaptive_opus_encoder.h"
+
+#include <esp_log.h>
+#include "opus.h"
+
+#define TAG "AdaptiveOpusEncoder"
+
+#define MAX_OPUS_PACKET_SIZE 1000
+
+AdaptiveOpusEncoder::AdaptiveOpusEncoder(int sample_rate, int channels, int duration_ms)
+    : sample_rate_(sample_rate), channels_(channels), duration_ms_(duration_ms) {
+    int error;
+    encoder_ = opus_encoder_create(sample_rate, channels, OPUS_APPLICATION_VOIP, &error);
+    if (encoder_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to create audio encoder, error code: %d", error);
+        return;
+    }
+    frame_size_ = sample_rate / 1000 * duration_ms;
+}
+
+AdaptiveOpusEncoder::~AdaptiveOpusEncoder() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (encoder_ != nullptr) {
+        opus_encoder_destroy(encoder_);
+    }
+}
+
+void AdaptiveOpusEncoder::SetDtx(bool enable) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (encoder_ != nullptr) {
+        opus_encoder_ctl(encoder_, OPUS_SET_DTX(enable ? 1 : 0));
+    }
+}
+
+void AdaptiveOpusEncoder::SetComplexity(int complexity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (encoder_ != nullptr) {
+        opus_encoder_ctl(encoder_, OPUS_SET_COMPLEXITY(complexity));
+    }
+}
+
+void AdaptiveOpusEncoder::SetBitrate(int bitrate) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (encoder_ != nullptr) {
+        opus_encoder_ctl(encoder_, OPUS_SET_BITRATE(bitrate > 0 ? bitrate : OPUS_AUTO));
+    }
+}
+
+bool AdaptiveOpusEncoder::Encode(std::vector<int16_t>&& pcm, std::vector<uint8_t>& opus) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (encoder_ == nullptr) {
+        ESP_LOGE(TAG, "Audio encoder is not configured");
+        return false;
+    }
+    if ((int)pcm.size() != frame_size_ * channels_) {
+        ESP_LOGE(TAG, "Invalid frame size: %u, expected: %d", pcm.size(), frame_size_ * channels_);
+        return false;
+    }
+
+    opus.resize(MAX_OPUS_PACKET_SIZE);
+    auto ret = opus_encode(encoder_, pcm.data(), frame_size_, opus.data(), opus.size());
+    if (ret < 0) {
+        ESP_LOGE(TAG, "Failed to encode audio, error code: %ld", (long)ret);
+        return false;
+    }
+    opus.resize(ret);
+    return true;
+}
+
+void AdaptiveOpusEncoder::ResetState() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (encoder_ != nullptr) {
+        opus_encoder_ctl(encoder_, OPUS_RESET_STATE);
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef ADAPTIVE_OPUS_ENCODER_H
+#define ADAPTIVE_OPUS_ENCODER_H
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+struct OpusEncoder;
+
+/*
+ * 上行 Opus 编码器，在 OpusEncoderWrapper 的基础上支持运行时调整码率，
+ * 由 UplinkRateController 根据链路状况控制。
+ * 输入必须是完整的一帧 PCM (AudioProcessor 已按帧长输出)。
+ */
+class AdaptiveOpusEncoder {
+public:
+    AdaptiveOpusEncoder(int sample_rate, int channels, int duration_ms);
+    ~AdaptiveOpusEncoder();
+
+    inline int sample_rate() const {
+        return sample_rate_;
+    }
+    inline int duration_ms() const {
+        return duration_ms_;
+    }
+
+    void SetDtx(bool enable);
+    void SetComplexity(int complexity);
+    // 0 表示使用编码器默认码率
+    void SetBitrate(int bitrate);
+    bool Encode(std::vector<int16_t>&& pcm, std::vector<uint8_t>& opus);
+    void ResetState();
+
+private:
+    std::mutex mutex_;
+    OpusEncoder* encoder_ = nullptr;
+    int sample_rate_;
+    int channels_;
+    int duration_ms_;
+    int frame_size_ = 0;
+};
+
+#endif // ADAPTIVE_OPUS_ENCODER_H
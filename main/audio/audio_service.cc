@@ -1,5 +1,9 @@
 #include "audio_service.h"
+#include "timeline_trace.h"
+#include "frequency_governor.h"
+#include "task_planner.h"
 #include <esp_log.h>
+#include <algorithm>
 
 #if CONFIG_USE_AUDIO_PROCESSOR
 #include "processors/afe_audio_processor.h"
@@ -20,6 +24,12 @@
 
 AudioService::AudioService() {
     event_group_ = xEventGroupCreate();
+
+    auto& metrics = MetricsRegistry::GetInstance();
+    input_counter_ = metrics.AddCounter("audio.input");
+    decode_counter_ = metrics.AddCounter("audio.decode");
+    encode_counter_ = metrics.AddCounter("audio.encode");
+    playback_counter_ = metrics.AddCounter("audio.playback");
 }
 
 AudioService::~AudioService() {
@@ -35,7 +45,7 @@ void AudioService::Initialize(AudioCodec* codec) {
 
     /* Setup the audio codec */
     opus_decoder_ = std::make_unique<OpusDecoderWrapper>(codec->output_sample_rate(), 1, OPUS_FRAME_DURATION_MS);
-    opus_encoder_ = std::make_unique<OpusEncoderWrapper>(16000, 1, OPUS_FRAME_DURATION_MS);
+    opus_encoder_ = std::make_unique<AdaptiveOpusEncoder>(16000, 1, OPUS_FRAME_DURATION_MS);
     opus_encoder_->SetComplexity(0);
 
     if (codec->input_sample_rate() != 16000) {
@@ -97,34 +107,32 @@ void AudioService::Start() {
 
     esp_timer_start_periodic(audio_power_timer_, 1000000);
 
+    // AudioCodec::Start 已经打开了输入和输出，唤醒词运行时输入不会再关闭重开，按当前状态报告需求
+    auto& governor = FrequencyGovernor::GetInstance();
+    governor.SetDemand(kPowerDemandAudioInput, codec_->input_enabled());
+    governor.SetDemand(kPowerDemandAudioOutput, codec_->output_enabled());
+
     /* Start the audio input task */
-#if CONFIG_USE_AUDIO_PROCESSOR
-    xTaskCreatePinnedToCore([](void* arg) {
-        AudioService* audio_service = (AudioService*)arg;
-        audio_service->AudioInputTask();
-        vTaskDelete(NULL);
-    }, "audio_input", 2048 * 3, this, 8, &audio_input_task_handle_, 1);
-#else
-    xTaskCreate([](void* arg) {
+    auto& planner = TaskPlanner::GetInstance();
+    planner.CreateTask(kTaskRoleAudioInput, [](void* arg) {
         AudioService* audio_service = (AudioService*)arg;
         audio_service->AudioInputTask();
         vTaskDelete(NULL);
-    }, "audio_input", 2048 * 3, this, 8, &audio_input_task_handle_);
-#endif
+    }, "audio_input", 2048 * 3, this, &audio_input_task_handle_);
 
     /* Start the audio output task */
-    xTaskCreate([](void* arg) {
+    planner.CreateTask(kTaskRoleAudioOutput, [](void* arg) {
         AudioService* audio_service = (AudioService*)arg;
         audio_service->AudioOutputTask();
         vTaskDelete(NULL);
-    }, "audio_output", 4096, this, 3, &audio_output_task_handle_);
+    }, "audio_output", 4096, this, &audio_output_task_handle_);
 
     /* Start the opus codec task */
-    xTaskCreate([](void* arg) {
+    planner.CreateTask(kTaskRoleOpusCodec, [](void* arg) {
         AudioService* audio_service = (AudioService*)arg;
         audio_service->OpusCodecTask();
         vTaskDelete(NULL);
-    }, "opus_codec", 4096 * 7, this, 2, &opus_codec_task_handle_);
+    }, "opus_codec", 4096 * 7, this, &opus_codec_task_handle_);
 }
 
 void AudioService::Stop() {
@@ -143,8 +151,10 @@ void AudioService::Stop() {
 }
 
 bool AudioService::ReadAudioData(std::vector<int16_t>& data, int sample_rate, int samples) {
+    TRACE_SCOPE("audio_read");
     if (!codec_->input_enabled()) {
         codec_->EnableInput(true);
+        FrequencyGovernor::GetInstance().SetDemand(kPowerDemandAudioInput, true);
         esp_timer_start_periodic(audio_power_timer_, AUDIO_POWER_CHECK_INTERVAL_MS * 1000);
     }
 
@@ -183,7 +193,7 @@ bool AudioService::ReadAudioData(std::vector<int16_t>& data, int sample_rate, in
 
     /* Update the last input time */
     last_input_time_ = std::chrono::steady_clock::now();
-    debug_statistics_.input_count++;
+    input_counter_->Add();
 
 #if CONFIG_USE_AUDIO_DEBUGGER
     // 音频调试：发送原始音频数据
@@ -280,13 +290,16 @@ void AudioService::AudioOutputTask() {
 
         if (!codec_->output_enabled()) {
             codec_->EnableOutput(true);
+            FrequencyGovernor::GetInstance().SetDemand(kPowerDemandAudioOutput, true);
             esp_timer_start_periodic(audio_power_timer_, AUDIO_POWER_CHECK_INTERVAL_MS * 1000);
         }
+        TRACE_BEGIN("audio_write");
         codec_->OutputData(task->pcm);
+        TRACE_END("audio_write");
 
         /* Update the last output time */
         last_output_time_ = std::chrono::steady_clock::now();
-        debug_statistics_.playback_count++;
+        playback_counter_->Add();
 
 #if CONFIG_USE_SERVER_AEC
         /* Record the timestamp for server AEC */
@@ -305,7 +318,7 @@ void AudioService::OpusCodecTask() {
         std::unique_lock<std::mutex> lock(audio_queue_mutex_);
         audio_queue_cv_.wait(lock, [this]() {
             return service_stopped_ ||
-                (!audio_encode_queue_.empty() && audio_send_queue_.size() < MAX_SEND_PACKETS_IN_QUEUE) ||
+                !audio_encode_queue_.empty() ||
                 (!audio_decode_queue_.empty() && audio_playback_queue_.size() < MAX_PLAYBACK_TASKS_IN_QUEUE);
         });
         if (service_stopped_) {
@@ -324,7 +337,10 @@ void AudioService::OpusCodecTask() {
             task->timestamp = packet->timestamp;
 
             SetDecodeSampleRate(packet->sample_rate, packet->frame_duration);
-            if (opus_decoder_->Decode(std::move(packet->payload), task->pcm)) {
+            TRACE_BEGIN("opus_decode");
+            bool decoded = opus_decoder_->Decode(std::move(packet->payload), task->pcm);
+            TRACE_END("opus_decode");
+            if (decoded) {
                 // Resample if the sample rate is different
                 if (opus_decoder_->sample_rate() != codec_->output_sample_rate()) {
                     int target_size = output_resampler_.GetOutputSamples(task->pcm.size());
@@ -336,15 +352,17 @@ void AudioService::OpusCodecTask() {
                 lock.lock();
                 audio_playback_queue_.push_back(std::move(task));
                 audio_queue_cv_.notify_all();
+                TRACE_COUNTER("playback_queue", audio_playback_queue_.size());
             } else {
                 ESP_LOGE(TAG, "Failed to decode audio");
                 lock.lock();
             }
-            debug_statistics_.decode_count++;
+            decode_counter_->Add();
         }
         
         /* Encode the audio to send queue */
-        if (!audio_encode_queue_.empty() && audio_send_queue_.size() < MAX_SEND_PACKETS_IN_QUEUE) {
+        /* The send queue never blocks the encoder, stale packets are dropped by TrimSendQueue */
+        if (!audio_encode_queue_.empty()) {
             auto task = std::move(audio_encode_queue_.front());
             audio_encode_queue_.pop_front();
             audio_queue_cv_.notify_all();
@@ -354,7 +372,10 @@ void AudioService::OpusCodecTask() {
             packet->frame_duration = OPUS_FRAME_DURATION_MS;
             packet->sample_rate = 16000;
             packet->timestamp = task->timestamp;
-            if (!opus_encoder_->Encode(std::move(task->pcm), packet->payload)) {
+            TRACE_BEGIN("opus_encode");
+            bool encoded = opus_encoder_->Encode(std::move(task->pcm), packet->payload);
+            TRACE_END("opus_encode");
+            if (!encoded) {
                 ESP_LOGE(TAG, "Failed to encode audio");
                 continue;
             }
@@ -362,7 +383,10 @@ void AudioService::OpusCodecTask() {
             if (task->type == kAudioTaskTypeEncodeToSendQueue) {
                 {
                     std::lock_guard<std::mutex> lock(audio_queue_mutex_);
-                    audio_send_queue_.push_back(std::move(packet));
+                    TrimSendQueue(esp_timer_get_time());
+                    audio_send_queue_.push_back(SendQueueEntry{std::move(packet), task->capture_time_us, task->voice});
+                    send_queue_high_water_ = std::max<uint32_t>(send_queue_high_water_, audio_send_queue_.size());
+                    TRACE_COUNTER("send_queue", audio_send_queue_.size());
                 }
                 if (callbacks_.on_send_queue_available) {
                     callbacks_.on_send_queue_available();
@@ -371,7 +395,7 @@ void AudioService::OpusCodecTask() {
                 std::lock_guard<std::mutex> lock(audio_queue_mutex_);
                 audio_testing_queue_.push_back(std::move(packet));
             }
-            debug_statistics_.encode_count++;
+            encode_counter_->Add();
             lock.lock();
         }
     }
@@ -398,6 +422,8 @@ void AudioService::PushTaskToEncodeQueue(AudioTaskType type, std::vector<int16_t
     auto task = std::make_unique<AudioTask>();
     task->type = type;
     task->pcm = std::move(pcm);
+    task->voice = voice_detected_;
+    task->capture_time_us = esp_timer_get_time();
     
     /* Push the task to the encode queue */
     std::unique_lock<std::mutex> lock(audio_queue_mutex_);
@@ -431,17 +457,113 @@ bool AudioService::PushPacketToDecodeQueue(std::unique_ptr<AudioStreamPacket> pa
     return true;
 }
 
+void AudioService::SetUplinkBitrate(int bitrate, bool dtx) {
+    opus_encoder_->SetBitrate(bitrate);
+    opus_encoder_->SetDtx(dtx);
+}
+
+uint32_t AudioService::TakeSendQueueHighWater() {
+    std::lock_guard<std::mutex> lock(audio_queue_mutex_);
+    uint32_t high_water = send_queue_high_water_;
+    send_queue_high_water_ = audio_send_queue_.size();
+    return high_water;
+}
+
 std::unique_ptr<AudioStreamPacket> AudioService::PopPacketFromSendQueue() {
     std::lock_guard<std::mutex> lock(audio_queue_mutex_);
     if (audio_send_queue_.empty()) {
         return nullptr;
     }
-    auto packet = std::move(audio_send_queue_.front());
+    auto& entry = audio_send_queue_.front();
+    uint32_t delay_ms = (esp_timer_get_time() - entry.capture_time_us) / 1000;
+    send_delay_histogram_[std::min<uint32_t>(delay_ms / SEND_DELAY_BUCKET_MS, SEND_DELAY_BUCKETS - 1)]++;
+    send_queue_stats_.sent_packets++;
+    send_queue_stats_.delay_max_ms = std::max(send_queue_stats_.delay_max_ms, delay_ms);
+
+    auto packet = std::move(entry.packet);
     audio_send_queue_.pop_front();
     audio_queue_cv_.notify_all();
     return packet;
 }
 
+/*
+ * 链路卡顿时发送队列里积压的是几秒前的音频，恢复后一次性发出会让服务器听到很久以前的话。
+ * 最老的包超过 CONFIG_SEND_QUEUE_MAX_AGE_MS 时进入追赶模式：先丢弃最老的非语音帧，
+ * 直到积压回落到上限的一半；语音帧只有在自身超过上限时才丢弃。
+ * 调用时需持有 audio_queue_mutex_
+ */
+void AudioService::TrimSendQueue(int64_t now) {
+    const int64_t max_age_us = CONFIG_SEND_QUEUE_MAX_AGE_MS * 1000LL;
+    const size_t target_packets = CONFIG_SEND_QUEUE_MAX_AGE_MS / 2 / OPUS_FRAME_DURATION_MS;
+    // Make room for the packet about to be pushed
+    if (audio_send_queue_.size() >= MAX_SEND_PACKETS_IN_QUEUE) {
+        DropSendQueueEntry(audio_send_queue_.begin());
+    }
+    if (audio_send_queue_.empty()) {
+        send_queue_catching_up_ = false;
+        return;
+    }
+
+    if (!send_queue_catching_up_) {
+        if (now - audio_send_queue_.front().capture_time_us <= max_age_us) {
+            return;
+        }
+        send_queue_catching_up_ = true;
+        send_queue_stats_.catch_up_count++;
+        ESP_LOGW(TAG, "Send queue delay %d ms exceeds %d ms, catching up (%u packets queued)",
+            (int)((now - audio_send_queue_.front().capture_time_us) / 1000), CONFIG_SEND_QUEUE_MAX_AGE_MS, audio_send_queue_.size());
+    }
+
+    while (audio_send_queue_.size() > target_packets) {
+        auto it = std::find_if(audio_send_queue_.begin(), audio_send_queue_.end(),
+            [](const SendQueueEntry& entry) { return !entry.voice; });
+        if (it == audio_send_queue_.end()) {
+            break;
+        }
+        DropSendQueueEntry(it);
+    }
+    while (!audio_send_queue_.empty() && now - audio_send_queue_.front().capture_time_us > max_age_us) {
+        DropSendQueueEntry(audio_send_queue_.begin());
+    }
+
+    if (audio_send_queue_.size() <= target_packets) {
+        send_queue_catching_up_ = false;
+    }
+}
+
+void AudioService::DropSendQueueEntry(std::deque<SendQueueEntry>::iterator it) {
+    int duration = it->packet->frame_duration;
+    send_queue_stats_.dropped_packets++;
+    send_queue_stats_.dropped_ms += duration;
+    if (it->voice) {
+        send_queue_stats_.dropped_speech_ms += duration;
+    }
+    audio_send_queue_.erase(it);
+}
+
+SendQueueStats AudioService::GetSendQueueStats() {
+    std::lock_guard<std::mutex> lock(audio_queue_mutex_);
+    SendQueueStats stats = send_queue_stats_;
+    uint32_t* percentiles[] = { &stats.delay_p50_ms, &stats.delay_p90_ms, &stats.delay_p99_ms };
+    const uint32_t ranks[] = { 50, 90, 99 };
+    uint32_t count = 0;
+    int index = 0;
+    // 取桶的上沿作为分位数
+    for (int bucket = 0; bucket < SEND_DELAY_BUCKETS && index < 3; bucket++) {
+        count += send_delay_histogram_[bucket];
+        while (index < 3 && stats.sent_packets > 0 && count * 100 >= stats.sent_packets * ranks[index]) {
+            *percentiles[index++] = (bucket + 1) * SEND_DELAY_BUCKET_MS;
+        }
+    }
+    return stats;
+}
+
+void AudioService::ResetSendQueueStats() {
+    std::lock_guard<std::mutex> lock(audio_queue_mutex_);
+    send_queue_stats_ = SendQueueStats();
+    std::fill(std::begin(send_delay_histogram_), std::end(send_delay_histogram_), 0);
+}
+
 void AudioService::EncodeWakeWord() {
     if (wake_word_) {
         wake_word_->EncodeWakeWordData();
@@ -460,6 +582,20 @@ std::unique_ptr<AudioStreamPacket> AudioService::PopWakeWordPacket() {
     return nullptr;
 }
 
+void AudioService::PreloadModels() {
+    if (wake_word_ && !wake_word_initialized_) {
+        if (wake_word_->Initialize(codec_)) {
+            wake_word_initialized_ = true;
+        } else {
+            ESP_LOGE(TAG, "Failed to initialize wake word");
+        }
+    }
+    if (!audio_processor_initialized_) {
+        audio_processor_->Initialize(codec_, OPUS_FRAME_DURATION_MS);
+        audio_processor_initialized_ = true;
+    }
+}
+
 void AudioService::EnableWakeWordDetection(bool enable) {
     if (!wake_word_) {
         return;
@@ -563,9 +699,11 @@ void AudioService::CheckAndUpdateAudioPowerState() {
     auto output_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_output_time_).count();
     if (input_elapsed > AUDIO_POWER_TIMEOUT_MS && codec_->input_enabled()) {
         codec_->EnableInput(false);
+        FrequencyGovernor::GetInstance().SetDemand(kPowerDemandAudioInput, false);
     }
     if (output_elapsed > AUDIO_POWER_TIMEOUT_MS && codec_->output_enabled()) {
         codec_->EnableOutput(false);
+        FrequencyGovernor::GetInstance().SetDemand(kPowerDemandAudioOutput, false);
     }
     if (!codec_->input_enabled() && !codec_->output_enabled()) {
         esp_timer_stop(audio_power_timer_);
@@ -17,10 +17,12 @@
 #include <opus_resampler.h>
 
 #include "audio_codec.h"
+#include "adaptive_opus_encoder.h"
 #include "audio_processor.h"
 #include "processors/audio_debugger.h"
 #include "wake_word.h"
 #include "protocol.h"
+#include "metrics.h"
 
 
 /*
@@ -42,6 +44,10 @@
 #define AUDIO_TESTING_MAX_DURATION_MS 10000
 #define MAX_TIMESTAMPS_IN_QUEUE 3
 
+// 发送时延统计的直方图，超出范围的计入最后一个桶
+#define SEND_DELAY_BUCKET_MS 30
+#define SEND_DELAY_BUCKETS (3000 / SEND_DELAY_BUCKET_MS)
+
 #define AUDIO_POWER_TIMEOUT_MS 15000
 #define AUDIO_POWER_CHECK_INTERVAL_MS 1000
 
@@ -69,13 +75,27 @@ struct AudioTask {
     AudioTaskType type;
     std::vector<int16_t> pcm;
     uint32_t timestamp;
+    bool voice = false;
+    int64_t capture_time_us = 0;
+};
+
+struct SendQueueEntry {
+    std::unique_ptr<AudioStreamPacket> packet;
+    int64_t capture_time_us;
+    bool voice;
 };
 
-struct DebugStatistics {
-    uint32_t input_count = 0;
-    uint32_t decode_count = 0;
-    uint32_t encode_count = 0;
-    uint32_t playback_count = 0;
+struct SendQueueStats {
+    uint32_t sent_packets = 0;
+    uint32_t dropped_packets = 0;
+    uint32_t dropped_ms = 0;
+    uint32_t dropped_speech_ms = 0;
+    uint32_t catch_up_count = 0;
+    // 从采集到出队的时延
+    uint32_t delay_p50_ms = 0;
+    uint32_t delay_p90_ms = 0;
+    uint32_t delay_p99_ms = 0;
+    uint32_t delay_max_ms = 0;
 };
 
 class AudioService {
@@ -94,6 +114,8 @@ public:
     bool IsWakeWordRunning() const { return xEventGroupGetBits(event_group_) & AS_EVENT_WAKE_WORD_RUNNING; }
     bool IsAudioProcessorRunning() const { return xEventGroupGetBits(event_group_) & AS_EVENT_AUDIO_PROCESSOR_RUNNING; }
 
+    // 提前加载唤醒词和音频处理模型，启动时与联网并行执行，须在 Enable* 之前调用
+    void PreloadModels();
     void EnableWakeWordDetection(bool enable);
     void EnableVoiceProcessing(bool enable);
     void EnableAudioTesting(bool enable);
@@ -106,6 +128,11 @@ public:
     void PlaySound(const std::string_view& sound);
     bool ReadAudioData(std::vector<int16_t>& data, int sample_rate, int samples);
     void ResetDecoder();
+    void SetUplinkBitrate(int bitrate, bool dtx);
+    // 返回上次调用以来发送队列的最大积压包数
+    uint32_t TakeSendQueueHighWater();
+    SendQueueStats GetSendQueueStats();
+    void ResetSendQueueStats();
 
 private:
     AudioCodec* codec_ = nullptr;
@@ -113,12 +140,15 @@ private:
     std::unique_ptr<AudioProcessor> audio_processor_;
     std::unique_ptr<WakeWord> wake_word_;
     std::unique_ptr<AudioDebugger> audio_debugger_;
-    std::unique_ptr<OpusEncoderWrapper> opus_encoder_;
+    std::unique_ptr<AdaptiveOpusEncoder> opus_encoder_;
     std::unique_ptr<OpusDecoderWrapper> opus_decoder_;
     OpusResampler input_resampler_;
     OpusResampler reference_resampler_;
     OpusResampler output_resampler_;
-    DebugStatistics debug_statistics_;
+    MetricCounter* input_counter_;
+    MetricCounter* decode_counter_;
+    MetricCounter* encode_counter_;
+    MetricCounter* playback_counter_;
 
     EventGroupHandle_t event_group_;
 
@@ -129,10 +159,14 @@ private:
     std::mutex audio_queue_mutex_;
     std::condition_variable audio_queue_cv_;
     std::deque<std::unique_ptr<AudioStreamPacket>> audio_decode_queue_;
-    std::deque<std::unique_ptr<AudioStreamPacket>> audio_send_queue_;
+    std::deque<SendQueueEntry> audio_send_queue_;
     std::deque<std::unique_ptr<AudioStreamPacket>> audio_testing_queue_;
     std::deque<std::unique_ptr<AudioTask>> audio_encode_queue_;
     std::deque<std::unique_ptr<AudioTask>> audio_playback_queue_;
+    uint32_t send_queue_high_water_ = 0;
+    bool send_queue_catching_up_ = false;
+    SendQueueStats send_queue_stats_;
+    uint32_t send_delay_histogram_[SEND_DELAY_BUCKETS] = {0};
 
     // For server AEC
     std::deque<uint32_t> timestamp_queue_;
@@ -153,6 +187,8 @@ private:
     void OpusCodecTask();
     void PushTaskToEncodeQueue(AudioTaskType type, std::vector<int16_t>&& pcm);
     void SetDecodeSampleRate(int sample_rate, int frame_duration);
+    void TrimSendQueue(int64_t now);
+    void DropSendQueueEntry(std::deque<SendQueueEntry>::iterator it);
     void CheckAndUpdateAudioPowerState();
 };
 
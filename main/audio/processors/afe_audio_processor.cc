@@ -1,4 +1,7 @@
 #include "afe_audio_processor.h"
+#include "timeline_trace.h"
+#include "memory_placement.h"
+#include "task_planner.h"
 #include <esp_log.h>
 
 #define PROCESSOR_RUNNING 0x01
@@ -50,7 +53,8 @@ void AfeAudioProcessor::Initialize(AudioCodec* codec, int frame_duration_ms) {
     afe_config->afe_perferred_core = 1;
     afe_config->afe_perferred_priority = 1;
     afe_config->agc_init = false;
-    afe_config->memory_alloc_mode = AFE_MEMORY_ALLOC_MORE_PSRAM;
+    afe_config->memory_alloc_mode = memory_placement_region(MEMORY_BUFFER_AFE) == MEMORY_REGION_PSRAM ?
+        AFE_MEMORY_ALLOC_MORE_PSRAM : AFE_MEMORY_ALLOC_MORE_INTERNAL;
 
 #ifdef CONFIG_USE_DEVICE_AEC
     afe_config->aec_init = true;
@@ -63,11 +67,11 @@ void AfeAudioProcessor::Initialize(AudioCodec* codec, int frame_duration_ms) {
     afe_iface_ = esp_afe_handle_from_config(afe_config);
     afe_data_ = afe_iface_->create_from_config(afe_config);
     
-    xTaskCreate([](void* arg) {
+    TaskPlanner::GetInstance().CreateTask(kTaskRoleAudioProcessor, [](void* arg) {
         auto this_ = (AfeAudioProcessor*)arg;
         this_->AudioProcessorTask();
         vTaskDelete(NULL);
-    }, "audio_communication", 4096, this, 5, NULL);
+    }, "audio_communication", 4096, this, NULL);
 }
 
 AfeAudioProcessor::~AfeAudioProcessor() {
@@ -88,7 +92,9 @@ void AfeAudioProcessor::Feed(std::vector<int16_t>&& data) {
     if (afe_data_ == nullptr) {
         return;
     }
+    TRACE_BEGIN("afe_feed");
     afe_iface_->feed(afe_data_, data.data());
+    TRACE_END("afe_feed");
 }
 
 void AfeAudioProcessor::Start() {
@@ -123,7 +129,10 @@ void AfeAudioProcessor::AudioProcessorTask() {
     while (true) {
         xEventGroupWaitBits(event_group_, PROCESSOR_RUNNING, pdFALSE, pdTRUE, portMAX_DELAY);
 
+        // 包含等待 AFE 输出的时间
+        TRACE_BEGIN("afe_fetch");
         auto res = afe_iface_->fetch_with_delay(afe_data_, portMAX_DELAY);
+        TRACE_END("afe_fetch");
         if ((xEventGroupGetBits(event_group_) & PROCESSOR_RUNNING) == 0) {
             continue;
         }
@@ -138,9 +147,11 @@ void AfeAudioProcessor::AudioProcessorTask() {
         if (vad_state_change_callback_) {
             if (res->vad_state == VAD_SPEECH && !is_speaking_) {
                 is_speaking_ = true;
+                TRACE_INSTANT("vad_speech");
                 vad_state_change_callback_(true);
             } else if (res->vad_state == VAD_SILENCE && is_speaking_) {
                 is_speaking_ = false;
+                TRACE_INSTANT("vad_silence");
                 vad_state_change_callback_(false);
             }
         }
@@ -0,0 +1,71 @@
+#include "uplink_rate_controller.h"
+
+#include <algorithm>
+
+static const int kBitrateLevels[UplinkRateController::kLevelCount] = { 0, 24000, 16000, 12000, 8000 };
+
+// 积压超过 3 帧 (60ms 帧即 180ms) 说明链路发不出去
+#define UPLINK_QUEUE_DEPTH_THRESHOLD 3
+#define UPLINK_LOSS_THRESHOLD_PERMILLE 50
+// 降档后至少保持一段时间，等待队列排空再判断
+#define UPLINK_HOLD_AFTER_STEP_DOWN_MS 2000
+#define UPLINK_GOOD_INTERVALS_TO_STEP_UP 5
+
+void UplinkRateController::Reset() {
+    stats_ = UplinkRateStats();
+    good_intervals_ = 0;
+    hold_ms_ = 0;
+}
+
+void UplinkRateController::ApplyLevel(int level) {
+    stats_.level = level;
+    stats_.bitrate = kBitrateLevels[level];
+    stats_.dtx = level >= kLevelCount - 2;
+}
+
+bool UplinkRateController::IsCongested(const UplinkFeedback& feedback) const {
+    if (feedback.queue_depth > UPLINK_QUEUE_DEPTH_THRESHOLD) {
+        return true;
+    }
+    if (stats_.loss_permille > UPLINK_LOSS_THRESHOLD_PERMILLE) {
+        return true;
+    }
+    return false;
+}
+
+bool UplinkRateController::Update(const UplinkFeedback& feedback) {
+    // Send failures are uplink loss; the server does not report uplink loss, so downlink
+    // sequence gaps on the same radio link stand in for it (UDP only)
+    uint64_t total = (uint64_t)feedback.packets_sent + feedback.packets_received + feedback.packets_lost;
+    if (total > 0) {
+        uint64_t loss = ((uint64_t)feedback.send_failures + feedback.packets_lost) * 1000 / total;
+        stats_.loss_permille = (stats_.loss_permille * 3 + (uint32_t)std::min<uint64_t>(loss, 1000)) / 4;
+    }
+
+    int level = stats_.level;
+    hold_ms_ = hold_ms_ > feedback.interval_ms ? hold_ms_ - feedback.interval_ms : 0;
+
+    if (IsCongested(feedback)) {
+        stats_.congested_intervals++;
+        good_intervals_ = 0;
+        if (hold_ms_ == 0 && level < kLevelCount - 1) {
+            level++;
+            stats_.step_downs++;
+            hold_ms_ = UPLINK_HOLD_AFTER_STEP_DOWN_MS;
+        }
+    } else if (feedback.packets_sent > 0) {
+        // Only intervals with traffic prove that the link is good
+        good_intervals_++;
+        if (good_intervals_ >= UPLINK_GOOD_INTERVALS_TO_STEP_UP && level > 0) {
+            level--;
+            stats_.step_ups++;
+            good_intervals_ = 0;
+        }
+    }
+
+    if (level == stats_.level) {
+        return false;
+    }
+    ApplyLevel(level);
+    return true;
+}
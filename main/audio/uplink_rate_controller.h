@@ -0,0 +1,58 @@
+#ifndef UPLINK_RATE_CONTROLLER_H
+#define UPLINK_RATE_CONTROLLER_H
+
+#include <cstdint>
+
+/*
+ * 上行码率控制器，只包含策略，不依赖 FreeRTOS，可以在主机上用链路轨迹测试。
+ *
+ * 每个统计周期输入一次链路反馈 (发送失败、发送队列积压、下行丢包)，
+ * 拥塞时立即降一档码率，连续若干个周期链路良好后再升一档。
+ * 会话中没有周期性的 RTT 样本 (hello 往返只有一次)，因此不使用 RTT 判断拥塞。
+ * 服务器不回报上行丢包，下行序号空洞作为同一条无线链路质量的近似，与发送失败合并计算丢包率。
+ * 码率档位: 自动 (编码器默认) -> 24k -> 16k -> 12k -> 8k，
+ * 最低两档同时开启 DTX，静音帧几乎不占带宽。
+ */
+struct UplinkFeedback {
+    uint32_t interval_ms = 0;
+    uint32_t packets_sent = 0;
+    uint32_t send_failures = 0;
+    uint32_t queue_depth = 0;       // 周期内发送队列的最大积压包数
+    uint32_t packets_received = 0;
+    uint32_t packets_lost = 0;      // 下行丢包，作为上行丢包的近似
+};
+
+struct UplinkRateStats {
+    int level = 0;
+    int bitrate = 0;                // 0 表示编码器默认码率
+    bool dtx = false;
+    uint32_t loss_permille = 0;     // 平滑后的丢包/发送失败率
+    uint32_t step_downs = 0;
+    uint32_t step_ups = 0;
+    uint32_t congested_intervals = 0;
+};
+
+class UplinkRateController {
+public:
+    static constexpr int kLevelCount = 5;
+
+    UplinkRateController() = default;
+
+    // 返回 true 表示档位发生变化，需要重新配置编码器
+    bool Update(const UplinkFeedback& feedback);
+    void Reset();
+
+    int bitrate() const { return stats_.bitrate; }
+    bool dtx() const { return stats_.dtx; }
+    const UplinkRateStats& stats() const { return stats_; }
+
+private:
+    UplinkRateStats stats_;
+    uint32_t good_intervals_ = 0;
+    uint32_t hold_ms_ = 0;
+
+    bool IsCongested(const UplinkFeedback& feedback) const;
+    void ApplyLevel(int level);
+};
+
+#endif // UPLINK_RATE_CONTROLLER_H
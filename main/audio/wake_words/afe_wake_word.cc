@@ -1,5 +1,7 @@
 #include "afe_wake_word.h"
 #include "application.h"
+#include "memory_placement.h"
+#include "task_planner.h"
 
 #include <esp_log.h>
 #include <model_path.h>
@@ -24,7 +26,7 @@ AfeWakeWord::~AfeWakeWord() {
     }
 
     if (wake_word_encode_task_stack_ != nullptr) {
-        heap_caps_free(wake_word_encode_task_stack_);
+        memory_placement_free(wake_word_encode_task_stack_);
     }
 
     vEventGroupDelete(event_group_);
@@ -65,16 +67,17 @@ bool AfeWakeWord::Initialize(AudioCodec* codec) {
     afe_config->aec_mode = AEC_MODE_SR_HIGH_PERF;
     afe_config->afe_perferred_core = 1;
     afe_config->afe_perferred_priority = 1;
-    afe_config->memory_alloc_mode = AFE_MEMORY_ALLOC_MORE_PSRAM;
+    afe_config->memory_alloc_mode = memory_placement_region(MEMORY_BUFFER_AFE) == MEMORY_REGION_PSRAM ?
+        AFE_MEMORY_ALLOC_MORE_PSRAM : AFE_MEMORY_ALLOC_MORE_INTERNAL;
     
     afe_iface_ = esp_afe_handle_from_config(afe_config);
     afe_data_ = afe_iface_->create_from_config(afe_config);
 
-    xTaskCreate([](void* arg) {
+    TaskPlanner::GetInstance().CreateTask(kTaskRoleWakeWord, [](void* arg) {
         auto this_ = (AfeWakeWord*)arg;
         this_->AudioDetectionTask();
         vTaskDelete(NULL);
-    }, "audio_detection", 4096, this, 5, nullptr);
+    }, "audio_detection", 4096, this, nullptr);
 
     return true;
 }
@@ -148,7 +151,7 @@ void AfeWakeWord::StoreWakeWordData(const int16_t* data, size_t samples) {
 void AfeWakeWord::EncodeWakeWordData() {
     wake_word_opus_.clear();
     if (wake_word_encode_task_stack_ == nullptr) {
-        wake_word_encode_task_stack_ = (StackType_t*)heap_caps_malloc(4096 * 8, MALLOC_CAP_SPIRAM);
+        wake_word_encode_task_stack_ = (StackType_t*)memory_placement_malloc(MEMORY_BUFFER_WAKE_WORD_STACK, 4096 * 8);
     }
     wake_word_encode_task_ = xTaskCreateStatic([](void* arg) {
         auto this_ = (AfeWakeWord*)arg;
@@ -5,6 +5,8 @@
 #include "esp_cache.h"
 #include "esp_private/esp_cache_private.h"
 #include "esp_dma_utils.h"
+#include "memory_placement.h"
+#include "mjpeg_frame_parser.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
@@ -17,6 +19,7 @@
 #endif
 
 #include "media_src_storage.h"
+#include "timeline_trace.h"
 
 static const char *TAG = "mjpeg_player";
 
@@ -27,6 +30,8 @@ typedef struct {
     bool is_playing;
     bool is_loop;
     TaskHandle_t task_handle;
+    int task_priority;
+    int task_core;
     media_src_t file;
     uint64_t file_size;
 
@@ -86,24 +91,6 @@ static uint8_t * video_decoder_malloc(uint32_t size, bool inbuff, uint32_t * out
 }
 #endif
 
-static uint8_t* find_jpeg_marker(uint8_t* buf, size_t len) {
-    for (size_t i = 0; i < len - 1; i++) {
-        if (buf[i] == 0xFF && buf[i + 1] == 0xD8) {
-            return &buf[i];
-        }
-    }
-    return NULL;
-}
-
-static uint8_t* find_jpeg_end(uint8_t* buf, size_t len) {
-    for (size_t i = 0; i < len - 1; i++) {
-        if (buf[i] == 0xFF && buf[i + 1] == 0xD9) {
-            return &buf[i + 2];
-        }
-    }
-    return NULL;
-}
-
 static void mjpeg_player_task(void *arg) {
     mjpeg_player_t *player = (mjpeg_player_t *)arg;
     uint32_t read_pos = 0;
@@ -129,18 +116,12 @@ static void mjpeg_player_task(void *arg) {
         }
 
         // 查找JPEG帧
-        uint8_t *frame_start = find_jpeg_marker(player->cache_buff, bytes_read);
-        if (!frame_start) {
-            continue;
-        }
-
-        uint8_t *frame_end = find_jpeg_end(frame_start, 
-            bytes_read - (frame_start - player->cache_buff));
-        if (!frame_end) {
+        const uint8_t *frame_start = NULL;
+        size_t frame_size = 0;
+        if (!mjpeg_find_frame(player->cache_buff, bytes_read, &frame_start, &frame_size)) {
             continue;
         }
 
-        size_t frame_size = frame_end - frame_start;
         if (frame_size > player->in_buff_size) {
             ESP_LOGW(TAG, "Frame too large: %d > %ld", frame_size, player->in_buff_size);
             continue;
@@ -154,9 +135,11 @@ static void mjpeg_player_task(void *arg) {
         uint32_t frame_size_aligned = ALIGN_UP(frame_size, 16);
         uint32_t ret_size = player->out_buff_size;
         
+        TRACE_BEGIN("mjpeg_decode");
         esp_err_t ret = jpeg_decoder_process(player->jpeg_handle, &jpeg_decode_cfg, 
                                            player->in_buff, frame_size_aligned,
                                            player->out_buff, player->out_buff_size, &ret_size);
+        TRACE_END("mjpeg_decode");
         
         if (ret == ESP_OK) {
             // 调用回调函数显示帧
@@ -177,9 +160,11 @@ static void mjpeg_player_task(void *arg) {
         // S3软件JPEG解码 - 参考原有方式
         uint8_t *rgb565_buf = NULL;
         int rgb_size = 0;
+        TRACE_BEGIN("mjpeg_decode");
         jpeg_error_t ret = esp_jpeg_decode_one_picture(
             player->in_buff, frame_size,
             &rgb565_buf, &rgb_size);
+        TRACE_END("mjpeg_decode");
 
         if (ret == JPEG_ERR_OK && rgb565_buf && rgb_size > 0) {
             // 调用回调函数显示帧
@@ -193,7 +178,7 @@ static void mjpeg_player_task(void *arg) {
 #endif
 
         // 更新读取位置
-        size_t advance = frame_end - player->cache_buff;
+        size_t advance = frame_start + frame_size - player->cache_buff;
         read_pos += advance;
         media_src_storage_seek(&player->file, read_pos);
 
@@ -262,7 +247,7 @@ esp_err_t mjpeg_player_create(const mjpeg_player_config_t* config, mjpeg_player_
 
     // 分配缓存缓冲区
     if (config->cache_in_psram) {
-        player->cache_buff = heap_caps_malloc(player->cache_buff_size, MALLOC_CAP_SPIRAM);
+        player->cache_buff = memory_placement_malloc(MEMORY_BUFFER_MJPEG_CACHE, player->cache_buff_size);
     } else {
         player->cache_buff = malloc(player->cache_buff_size);
     }
@@ -291,6 +276,8 @@ esp_err_t mjpeg_player_create(const mjpeg_player_config_t* config, mjpeg_player_
 
     player->on_frame_cb = config->on_frame_cb;
     player->user_data = config->user_data;
+    player->task_priority = config->task_priority;
+    player->task_core = config->task_core;
     *handle = player;
 
     ESP_LOGI(TAG, "MJPEG player created successfully");
@@ -357,7 +344,7 @@ esp_err_t mjpeg_player_play_file(mjpeg_player_handle_t handle, const char* filep
 
     player->is_playing = true;
     BaseType_t ret = xTaskCreatePinnedToCore(mjpeg_player_task, "mjpeg_player", 
-        8 * 1024, player, 4, &player->task_handle, 0);
+        8 * 1024, player, player->task_priority, &player->task_handle, player->task_core);
 
     if (ret != pdPASS) {
         ESP_LOGE(TAG, "Failed to create player task");
@@ -17,7 +17,7 @@ typedef struct {
     size_t cache_buffer_size;     /*!< 文件读取缓存大小 */
     bool cache_in_psram;          /*!< 是否使用PSRAM存储缓存 */
     int task_priority;            /*!< 任务优先级 */
-    int task_core;               /*!< 运行的CPU核心ID */
+    int task_core;               /*!< 运行的CPU核心ID，tskNO_AFFINITY表示不绑定 */
     void (*on_frame_cb)(uint8_t *rgb565, uint32_t width, uint32_t height, void* ctx); /*!< 帧回调函数 */
     void* user_data;             /*!< 用户数据,会传递给回调函数 */
 } mjpeg_player_config_t;
@@ -6,6 +6,7 @@
 #include "esp_log.h"
 #include "esp_heap_caps.h"
 #include "media_src_storage.h"
+#include "memory_placement.h"
 
 
 #define CACHE_SIZE (2 * 1024)
@@ -108,7 +109,7 @@ int media_src_storage_open(media_src_t *src)
         return -1;
     }
 #ifdef USE_ALIGN_CACHE
-    m->align_buffer = heap_caps_aligned_alloc(128, CACHE_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    m->align_buffer = memory_placement_malloc(MEMORY_BUFFER_MJPEG_READ, CACHE_SIZE);
     if (m->align_buffer == NULL) {
         ESP_LOGE(TAG, "No memory");
         free(m);
@@ -221,7 +222,7 @@ int media_src_storage_close(media_src_t *src)
     }
 #ifdef USE_ALIGN_CACHE
     if (m->align_buffer) {
-        free(m->align_buffer);
+        memory_placement_free(m->align_buffer);
     }
 #endif
     free(m);
@@ -0,0 +1,36 @@
+#include "mjpeg_frame_parser.h"
+#include <string.h>
+
+// 查找 FF <marker>，用 memchr 跳过不是 0xFF 的字节；标记的第二个字节必须在缓冲区内
+static const uint8_t *find_jpeg_marker(const uint8_t *buf, size_t len, uint8_t marker) {
+    if (len < 2) {
+        return NULL;
+    }
+    const uint8_t *p = buf;
+    const uint8_t *last = buf + len - 1;
+    while (p < last) {
+        p = (const uint8_t *)memchr(p, 0xFF, last - p);
+        if (p == NULL) {
+            return NULL;
+        }
+        if (p[1] == marker) {
+            return p;
+        }
+        p++;
+    }
+    return NULL;
+}
+
+bool mjpeg_find_frame(const uint8_t *buf, size_t len, const uint8_t **frame, size_t *size) {
+    const uint8_t *start = find_jpeg_marker(buf, len, 0xD8);
+    if (start == NULL) {
+        return false;
+    }
+    const uint8_t *end = find_jpeg_marker(start + 2, len - (start + 2 - buf), 0xD9);
+    if (end == NULL) {
+        return false;
+    }
+    *frame = start;
+    *size = end + 2 - start;
+    return true;
+}
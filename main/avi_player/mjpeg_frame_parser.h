@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 在缓冲区中查找第一帧完整的 JPEG (从 SOI FF D8 到 EOI FF D9)
+ * @param buf 读取的 MJPEG 数据
+ * @param len 数据长度，小于 2 时直接返回 false
+ * @param[out] frame 帧起始位置 (SOI)
+ * @param[out] size 帧长度，包含 EOI
+ * @return 找到完整的帧返回 true；没有 SOI 或帧被截断返回 false
+ */
+bool mjpeg_find_frame(const uint8_t *buf, size_t len, const uint8_t **frame, size_t *size);
+
+#ifdef __cplusplus
+}
+#endif
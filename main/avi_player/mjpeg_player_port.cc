@@ -4,6 +4,9 @@
 #include "fs_manager.h"
 #include "board.h"
 #include "display.h"
+#include "metrics.h"
+#include "frequency_governor.h"
+#include "task_planner.h"
 #include <string.h>
 
 static const char *TAG = "mjpeg_player_port";
@@ -51,10 +54,9 @@ static struct {
     .shutdown_requested = false
 };
 
-// 帧率统计相关变量
-static uint32_t frame_count = 0;
-static int64_t last_fps_time = 0;
-static uint32_t fps_frame_count = 0;
+// 帧率统计，帧率由指标汇总按每秒速率输出
+static MetricCounter* frame_counter = NULL;
+static MetricHistogram* frame_interval_histogram = NULL;
 static int64_t last_frame_time = 0;
 
 // 安全获取播放器状态
@@ -75,6 +77,7 @@ static bool set_player_state(player_state_t new_state) {
         player.state = new_state;
         success = true;
         xSemaphoreGive(player.state_mutex);
+        FrequencyGovernor::GetInstance().SetDemand(kPowerDemandVideo, new_state == PLAYER_STATE_PLAYING);
     }
     return success;
 }
@@ -88,12 +91,10 @@ static void frame_callback(uint8_t *rgb565, uint32_t width, uint32_t height, voi
         return;
     }
 
-    int64_t start_time = esp_timer_get_time();
-    
     // 计算帧间隔时间
-    int64_t frame_interval = 0;
+    int64_t start_time = esp_timer_get_time();
     if (last_frame_time > 0) {
-        frame_interval = start_time - last_frame_time;
+        frame_interval_histogram->Record((start_time - last_frame_time) / 1000);
     }
     last_frame_time = start_time;
 
@@ -102,30 +103,7 @@ static void frame_callback(uint8_t *rgb565, uint32_t width, uint32_t height, voi
     if (display) {
         display->SetFaceImage(rgb565, width, height);
     }
-
-    // 帧率统计
-    frame_count++;
-    fps_frame_count++;
-
-    int64_t current_time = esp_timer_get_time();
-
-    // 每100帧或每5秒显示一次统计信息
-    if (fps_frame_count >= 100 || (current_time - last_fps_time) >= 5000000) {
-        if (last_fps_time > 0) {
-            int64_t time_diff = current_time - last_fps_time;
-            float fps = (float)fps_frame_count * 1000000.0f / time_diff;
-
-#if CONFIG_IDF_TARGET_ESP32P4
-            ESP_LOGI(TAG, "[HW DECODE] Frame Stats - FPS: %.1f, Frames: %u, interval=%.1f ms", 
-#else
-            ESP_LOGI(TAG, "[SW DECODE] Frame Stats - FPS: %.1f, Frames: %u, interval=%.1f ms", 
-#endif
-                     fps, (unsigned int)frame_count, frame_interval / 1000.0f);
-        }
-        
-        last_fps_time = current_time;
-        fps_frame_count = 0;
-    }
+    frame_counter->Add();
 }
 
 // 安全停止播放器
@@ -193,10 +171,7 @@ static void player_manager_task(void *arg) {
                         safe_stop_player(1000); // 1秒超时
                     }
                     
-                    // 重置统计
-                    frame_count = 0;
-                    fps_frame_count = 0;
-                    last_fps_time = esp_timer_get_time();
+                    // 新文件的第一帧不计入帧间隔
                     last_frame_time = 0;
                     
                     // 获取文件系统类型和构建完整路径
@@ -291,6 +266,10 @@ esp_err_t mjpeg_player_port_init(mjpeg_player_port_config_t *config) {
         return ESP_ERR_NO_MEM;
     }
 
+    auto& metrics = MetricsRegistry::GetInstance();
+    frame_counter = metrics.AddCounter("mjpeg.frames");
+    frame_interval_histogram = metrics.AddHistogram("mjpeg.interval_ms", {20, 33, 40, 50, 67, 100, 200, 500});
+
 #if CONFIG_IDF_TARGET_ESP32S3
     // 配置SD卡
     fs_config_t sdcard_config = {
@@ -354,8 +333,8 @@ esp_err_t mjpeg_player_port_init(mjpeg_player_port_config_t *config) {
         .frame_buffer_size = config->buffer_size ? config->buffer_size : 64 * 1024,  // 默认64KB
         .cache_buffer_size = 64 * 1024,
         .cache_in_psram = config->use_psram,
-        .task_priority = 2,
-        .task_core = config->core_id,
+        .task_priority = TaskPlanner::GetInstance().Get(kTaskRoleMjpegPlayer).priority,
+        .task_core = TaskPlanner::GetInstance().GetCoreId(kTaskRoleMjpegPlayer),
         .on_frame_cb = frame_callback,
         .user_data = NULL
     };
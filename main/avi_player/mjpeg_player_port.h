@@ -14,9 +14,9 @@ extern "C" {
  */
 typedef struct {
     size_t buffer_size;     /*!< 内部缓冲区大小，0表示使用默认值32KB */
-    int core_id;           /*!< 运行的CPU核心ID，0或1 */
+    int core_id;           /*!< 管理任务运行的CPU核心ID，tskNO_AFFINITY表示不绑定 */
     bool use_psram;        /*!< 是否使用PSRAM存储缓存 */
-    int task_priority;     /*!< 播放器任务优先级，1-20，数值越大优先级越高 */
+    int task_priority;     /*!< 管理任务优先级，1-20，数值越大优先级越高；解码任务按 TaskPlanner 的 mjpeg_player 角色 */
 } mjpeg_player_port_config_t;
 
 /**
@@ -0,0 +1,453 @@
+#include "benchmark.h"
+#include "adaptive_opus_encoder.h"
+#include "mcp_server.h"
+#include "posture_detection.h"
+#include "EyeAnimation.h"
+#include "timeline_trace.h"
+#include "device_state_event.h"
+#include "protocols/chat_message.h"
+#include "protocols/chat_message_corpus.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_console.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <opus_decoder.h>
+#include <opus_resampler.h>
+
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#define TAG "Benchmark"
+
+// state_post / state_post_copy 使用独立的事件，不会通知应用中真正的订阅者
+ESP_EVENT_DEFINE_BASE(BENCHMARK_STATE_EVENTS);
+enum {
+    BENCHMARK_STATE_POST_EVENT,
+    BENCHMARK_STATE_POST_COPY_EVENT,
+};
+
+#define BENCHMARK_SAMPLE_RATE 16000
+#define BENCHMARK_FRAME_DURATION_MS 60
+#define BENCHMARK_FRAME_SAMPLES (BENCHMARK_SAMPLE_RATE * BENCHMARK_FRAME_DURATION_MS / 1000)
+
+// 440Hz 正弦波叠加少量噪声，避免编码器因静音走 DTX 分支
+static std::vector<int16_t> GenerateTone(int sample_rate, int samples) {
+    std::vector<int16_t> pcm(samples);
+    for (int i = 0; i < samples; i++) {
+        float value = sinf(2.0f * M_PI * 440.0f * i / sample_rate) * 8000.0f;
+        pcm[i] = (int16_t)(value + (rand() % 512) - 256);
+    }
+    return pcm;
+}
+
+static BenchmarkResult BenchmarkOpusEncode(int iterations) {
+    AdaptiveOpusEncoder encoder(BENCHMARK_SAMPLE_RATE, 1, BENCHMARK_FRAME_DURATION_MS);
+    auto pcm = GenerateTone(BENCHMARK_SAMPLE_RATE, BENCHMARK_FRAME_SAMPLES);
+    std::vector<uint8_t> opus;
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        encoder.Encode(std::vector<int16_t>(pcm), opus);
+    }
+    return {iterations, esp_timer_get_time() - start_time, (uint32_t)(iterations * BENCHMARK_FRAME_DURATION_MS)};
+}
+
+static BenchmarkResult BenchmarkOpusDecode(int iterations) {
+    AdaptiveOpusEncoder encoder(BENCHMARK_SAMPLE_RATE, 1, BENCHMARK_FRAME_DURATION_MS);
+    OpusDecoderWrapper decoder(BENCHMARK_SAMPLE_RATE, 1, BENCHMARK_FRAME_DURATION_MS);
+    std::vector<uint8_t> opus;
+    encoder.Encode(GenerateTone(BENCHMARK_SAMPLE_RATE, BENCHMARK_FRAME_SAMPLES), opus);
+    std::vector<int16_t> pcm;
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        decoder.Decode(std::vector<uint8_t>(opus), pcm);
+    }
+    return {iterations, esp_timer_get_time() - start_time, (uint32_t)(iterations * BENCHMARK_FRAME_DURATION_MS)};
+}
+
+// 与 AudioService 中的输入重采样相同，24kHz -> 16kHz
+static BenchmarkResult BenchmarkResample(int iterations) {
+    const int input_sample_rate = 24000;
+    OpusResampler resampler;
+    resampler.Configure(input_sample_rate, BENCHMARK_SAMPLE_RATE);
+    auto input = GenerateTone(input_sample_rate, input_sample_rate * BENCHMARK_FRAME_DURATION_MS / 1000);
+    std::vector<int16_t> output(resampler.GetOutputSamples(input.size()));
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        resampler.Process(input.data(), input.size(), output.data());
+    }
+    return {iterations, esp_timer_get_time() - start_time, (uint32_t)(iterations * BENCHMARK_FRAME_DURATION_MS)};
+}
+
+// 通知消息不会产生回复，只测量解析和分发的开销
+static BenchmarkResult BenchmarkMcpParse(int iterations) {
+    const std::string message = "{\"jsonrpc\":\"2.0\",\"method\":\"notifications/benchmark\",\"params\":"
+        "{\"name\":\"self.audio_speaker.set_volume\",\"arguments\":{\"volume\":50},"
+        "\"capabilities\":{\"vision\":{\"url\":\"https://example.com/vision/explain\",\"token\":\"0123456789abcdef\"}}}}";
+    auto& server = McpServer::GetInstance();
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        server.ParseMessage(message);
+    }
+    return {iterations, esp_timer_get_time() - start_time, 0};
+}
+
+// 会话开始时的 tools/list：每次重新序列化所有工具，与读取缓存的分页对比
+static BenchmarkResult BenchmarkToolsListBuild(int iterations) {
+    auto& server = McpServer::GetInstance();
+    std::string json;
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        server.InvalidateToolsList();
+        server.GetToolsListJson("", json);
+    }
+    return {iterations, esp_timer_get_time() - start_time, 0};
+}
+
+static BenchmarkResult BenchmarkToolsList(int iterations) {
+    auto& server = McpServer::GetInstance();
+    std::string json;
+    server.GetToolsListJson("", json);
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        server.GetToolsListJson("", json);
+    }
+    return {iterations, esp_timer_get_time() - start_time, 0};
+}
+
+// tools/call 的参数绑定：12 个混合类型的属性，参数顺序与声明顺序不同，绑定到重复使用的参数帧
+static BenchmarkResult BenchmarkMcpBind(int iterations) {
+    static McpTool tool("self.benchmark.bind", "Benchmark tool", PropertyList({
+        Property("volume", kPropertyTypeInteger, 0, 100),
+        Property("brightness", kPropertyTypeInteger, 50, 0, 100),
+        Property("theme", kPropertyTypeString),
+        Property("muted", kPropertyTypeBoolean, false),
+        Property("duration", kPropertyTypeInteger, 1000, 0, 60000),
+        Property("url", kPropertyTypeString),
+        Property("token", kPropertyTypeString, std::string("")),
+        Property("loop", kPropertyTypeBoolean),
+        Property("x", kPropertyTypeInteger, 0, 320),
+        Property("y", kPropertyTypeInteger, 0, 240),
+        Property("question", kPropertyTypeString),
+        Property("verbose", kPropertyTypeBoolean, false),
+    }), [](const PropertyList& properties) -> ReturnValue {
+        return true;
+    });
+    cJSON* arguments = cJSON_Parse("{\"question\":\"What is in the picture?\",\"y\":120,\"x\":160,"
+        "\"loop\":true,\"url\":\"https://example.com/vision/explain\",\"theme\":\"dark\",\"volume\":50,"
+        "\"unknown\":1}");
+    PropertyList frame;
+    std::string error;
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        if (!tool.BindArguments(arguments, frame, error)) {
+            ESP_LOGE(TAG, "Failed to bind arguments: %s", error.c_str());
+            break;
+        }
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start_time;
+    cJSON_Delete(arguments);
+    return {iterations, elapsed_us, 0};
+}
+
+// 每次迭代处理一轮对话的全部消息，与 Protocol::DispatchChatMessage 相同，快速路径失败时回退到 cJSON
+static BenchmarkResult BenchmarkChatParse(int iterations) {
+    const int count = sizeof(kChatMessageCorpus) / sizeof(kChatMessageCorpus[0]);
+    size_t lengths[count];
+    for (int i = 0; i < count; i++) {
+        lengths[i] = strlen(kChatMessageCorpus[i]);
+    }
+    char scratch[512];
+    ChatMessage message;
+    int fallbacks = 0;
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        for (int j = 0; j < count; j++) {
+            if (!ParseChatMessage(kChatMessageCorpus[j], lengths[j], message, scratch, sizeof(scratch))) {
+                cJSON_Delete(cJSON_ParseWithLength(kChatMessageCorpus[j], lengths[j]));
+                fallbacks++;
+            }
+        }
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start_time;
+    if (fallbacks > 0) {
+        ESP_LOGW(TAG, "%d messages fell back to cJSON", fallbacks);
+    }
+    return {iterations, elapsed_us, 0};
+}
+
+// 原来的路径: 构建 cJSON 树并取出 type / state / text / emotion
+static BenchmarkResult BenchmarkChatCjson(int iterations) {
+    const int count = sizeof(kChatMessageCorpus) / sizeof(kChatMessageCorpus[0]);
+    size_t lengths[count];
+    for (int i = 0; i < count; i++) {
+        lengths[i] = strlen(kChatMessageCorpus[i]);
+    }
+    ChatMessage message;
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        for (int j = 0; j < count; j++) {
+            cJSON* root = cJSON_ParseWithLength(kChatMessageCorpus[j], lengths[j]);
+            auto type = cJSON_GetObjectItem(root, "type");
+            auto state = cJSON_GetObjectItem(root, "state");
+            auto text = cJSON_GetObjectItem(root, "text");
+            auto emotion = cJSON_GetObjectItem(root, "emotion");
+            message.type = cJSON_IsString(type) ? type->valuestring : "";
+            message.state = cJSON_IsString(state) ? state->valuestring : "";
+            message.text = cJSON_IsString(text) ? text->valuestring : "";
+            message.emotion = cJSON_IsString(emotion) ? emotion->valuestring : "";
+            cJSON_Delete(root);
+        }
+    }
+    return {iterations, esp_timer_get_time() - start_time, 0};
+}
+
+static BenchmarkResult BenchmarkPosture(int iterations) {
+    // 端坐时 17 个关键点的大致位置 (x, y)，每次加入随机抖动
+    static const int kKeypoints[34] = {
+        160, 80, 150, 70, 170, 70, 140, 75, 180, 75,
+        120, 140, 200, 140, 110, 200, 210, 200, 120, 250,
+        200, 250, 130, 260, 190, 260, 130, 330, 190, 330,
+        130, 400, 190, 400,
+    };
+    PostureDetector detector;
+    std::vector<int> keypoints(kKeypoints, kKeypoints + 34);
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        for (int j = 0; j < 34; j++) {
+            keypoints[j] = kKeypoints[j] + (rand() % 21) - 10;
+        }
+        detector.AnalyzePosture(keypoints);
+    }
+    return {iterations, esp_timer_get_time() - start_time, 0};
+}
+
+static BenchmarkResult BenchmarkEye(int iterations) {
+    EyeAnimation eye;
+    eye.begin();
+    eye.setEyelidGap(0);
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        eye.update();
+    }
+    return {iterations, esp_timer_get_time() - start_time, 0};
+}
+
+// 状态变化分发：订阅者表满员，每个订阅者只关心两个状态，轮流切换所有状态
+static BenchmarkResult BenchmarkStateEvent(int iterations) {
+    static StateChangeSubscribers subscribers;
+    static volatile int calls;
+    static bool initialized = false;
+    if (!initialized) {
+        for (int i = 0; i < DEVICE_STATE_MAX_SUBSCRIBERS; i++) {
+            uint32_t mask = DEVICE_STATE_MASK(i % (kDeviceStateFatalError + 1)) | DEVICE_STATE_MASK(kDeviceStateIdle);
+            subscribers.Add([](DeviceState previous_state, DeviceState current_state) {
+                calls = calls + 1;
+            }, mask);
+        }
+        initialized = true;
+    }
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        auto state = (DeviceState)(i % (kDeviceStateFatalError + 1));
+        if (subscribers.Wants(state)) {
+            subscribers.Dispatch(kDeviceStateUnknown, state);
+        }
+    }
+    return {iterations, esp_timer_get_time() - start_time, 0};
+}
+
+// 端到端的状态变化投递：从投递到最后一个事件分发完，包含 esp_event_post 的复制和堆分配。
+// 订阅者表满员，一个订阅者关心所有状态并计数，其余每个只关心两个状态
+static TaskHandle_t s_state_post_task;
+static std::atomic<int> s_state_post_remaining;
+
+static void OnStatePostCounted() {
+    if (s_state_post_remaining.fetch_sub(1) == 1) {
+        xTaskNotifyGive(s_state_post_task);
+    }
+}
+
+template <typename Post>
+static BenchmarkResult RunStatePost(int iterations, Post post) {
+    s_state_post_task = xTaskGetCurrentTaskHandle();
+    s_state_post_remaining = iterations;
+    ulTaskNotifyTake(pdTRUE, 0);
+
+    int64_t start_time = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++) {
+        post(kDeviceStateUnknown, (DeviceState)(i % (kDeviceStateFatalError + 1)));
+    }
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10000)) == 0) {
+        ESP_LOGW(TAG, "%d state events were not dispatched", s_state_post_remaining.load());
+    }
+    return {iterations, esp_timer_get_time() - start_time, 0};
+}
+
+static BenchmarkResult BenchmarkStatePost(int iterations) {
+    static StateChangeSubscribers subscribers;
+    static bool initialized = false;
+    if (!initialized) {
+        DeviceStateEventManager::GetInstance();     // 创建默认事件循环
+        subscribers.Add([](DeviceState previous_state, DeviceState current_state) {
+            OnStatePostCounted();
+        }, DEVICE_STATE_MASK_ALL);
+        for (int i = 1; i < DEVICE_STATE_MAX_SUBSCRIBERS; i++) {
+            uint32_t mask = DEVICE_STATE_MASK(i % (kDeviceStateFatalError + 1)) | DEVICE_STATE_MASK(kDeviceStateIdle);
+            subscribers.Add([](DeviceState previous_state, DeviceState current_state) {}, mask);
+        }
+        esp_event_handler_register(BENCHMARK_STATE_EVENTS, BENCHMARK_STATE_POST_EVENT,
+            StateChangeSubscribers::EventHandler, &subscribers);
+        initialized = true;
+    }
+    return RunStatePost(iterations, [](DeviceState previous_state, DeviceState current_state) {
+        subscribers.Post(BENCHMARK_STATE_EVENTS, BENCHMARK_STATE_POST_EVENT, previous_state, current_state);
+    });
+}
+
+// 原来的方式：每个事件在锁内复制整个回调 vector，再调用所有回调
+static BenchmarkResult BenchmarkStatePostCopy(int iterations) {
+    static std::mutex mutex;
+    static std::vector<std::function<void(DeviceState, DeviceState)>> callbacks;
+    static bool initialized = false;
+    if (!initialized) {
+        DeviceStateEventManager::GetInstance();
+        callbacks.push_back([](DeviceState previous_state, DeviceState current_state) {
+            OnStatePostCounted();
+        });
+        for (int i = 1; i < DEVICE_STATE_MAX_SUBSCRIBERS; i++) {
+            callbacks.push_back([](DeviceState previous_state, DeviceState current_state) {});
+        }
+        esp_event_handler_register(BENCHMARK_STATE_EVENTS, BENCHMARK_STATE_POST_COPY_EVENT,
+            [](void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
+                auto* data = static_cast<device_state_event_data_t*>(event_data);
+                std::vector<std::function<void(DeviceState, DeviceState)>> snapshot;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    snapshot = callbacks;
+                }
+                for (auto& callback : snapshot) {
+                    callback(data->previous_state, data->current_state);
+                }
+            }, nullptr);
+        initialized = true;
+    }
+    return RunStatePost(iterations, [](DeviceState previous_state, DeviceState current_state) {
+        device_state_event_data_t event_data = {
+            .previous_state = previous_state,
+            .current_state = current_state
+        };
+        esp_event_post(BENCHMARK_STATE_EVENTS, BENCHMARK_STATE_POST_COPY_EVENT, &event_data, sizeof(event_data), portMAX_DELAY);
+    });
+}
+
+static const struct {
+    const char* name;
+    BenchmarkResult (*function)(int iterations);
+    int default_iterations;
+} kBenchmarks[] = {
+    {"opus_encode", BenchmarkOpusEncode, 50},
+    {"opus_decode", BenchmarkOpusDecode, 200},
+    {"resample", BenchmarkResample, 200},
+    {"mcp_parse", BenchmarkMcpParse, 500},
+    {"mcp_bind", BenchmarkMcpBind, 2000},
+    {"tools_build", BenchmarkToolsListBuild, 50},
+    {"tools_list", BenchmarkToolsList, 1000},
+    {"chat_parse", BenchmarkChatParse, 1000},
+    {"chat_cjson", BenchmarkChatCjson, 1000},
+    {"posture", BenchmarkPosture, 2000},
+    {"eye", BenchmarkEye, 50},
+    {"state_event", BenchmarkStateEvent, 10000},
+    {"state_post", BenchmarkStatePost, 2000},
+    {"state_post_copy", BenchmarkStatePostCopy, 2000},
+};
+
+bool Benchmark::Start(const char* name, int iterations) {
+    if (running_.exchange(true)) {
+        ESP_LOGW(TAG, "Benchmark is already running");
+        return false;
+    }
+    strncpy(name_, name != nullptr ? name : "", sizeof(name_) - 1);
+    iterations_ = iterations;
+
+    BaseType_t ret = xTaskCreate([](void* arg) {
+        auto benchmark = (Benchmark*)arg;
+        benchmark->Run(benchmark->name_[0] != '\0' ? benchmark->name_ : nullptr, benchmark->iterations_);
+        benchmark->running_ = false;
+        vTaskDelete(NULL);
+    }, "benchmark", 4096 * 7, this, 1, nullptr);
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create benchmark task");
+        running_ = false;
+        return false;
+    }
+    return true;
+}
+
+int Benchmark::Run(const char* name, int iterations) {
+    int count = 0;
+    for (auto& benchmark : kBenchmarks) {
+        if (name != nullptr && strcmp(name, benchmark.name) != 0) {
+            continue;
+        }
+        int n = iterations > 0 ? iterations : benchmark.default_iterations;
+        TRACE_BEGIN(benchmark.name);
+        auto result = benchmark.function(n);
+        TRACE_END(benchmark.name);
+        PrintResult(benchmark.name, result);
+        count++;
+    }
+    if (count == 0) {
+        ESP_LOGW(TAG, "Unknown benchmark: %s", name);
+    }
+    return count;
+}
+
+void Benchmark::PrintResult(const char* name, const BenchmarkResult& result) {
+    int64_t elapsed_us = result.elapsed_us > 0 ? result.elapsed_us : 1;
+    uint32_t per_iteration_us = elapsed_us / result.iterations;
+    uint32_t per_second = (int64_t)result.iterations * 1000000 / elapsed_us;
+    if (result.audio_ms > 0) {
+        // 实时倍数保留一位小数
+        uint32_t realtime = (int64_t)result.audio_ms * 10000 / elapsed_us;
+        ESP_LOGI(TAG, "%-12s %6d iters %8lu us/iter %8lu /s  realtime x%lu.%lu", name, result.iterations,
+            per_iteration_us, per_second, realtime / 10, realtime % 10);
+    } else {
+        ESP_LOGI(TAG, "%-12s %6d iters %8lu us/iter %8lu /s", name, result.iterations, per_iteration_us, per_second);
+    }
+}
+
+void Benchmark::RegisterConsoleCommand() {
+    const esp_console_cmd_t cmd = {
+        .command = "bench",
+        .help = "Run benchmarks with synthetic input: bench [opus_encode|opus_decode|resample|mcp_parse|chat_parse|chat_cjson|posture|eye|all] [iterations]",
+        .hint = nullptr,
+        .func = [](int argc, char** argv) -> int {
+            const char* name = argc > 1 && strcmp(argv[1], "all") != 0 ? argv[1] : nullptr;
+            int iterations = argc > 2 ? atoi(argv[2]) : 0;
+            return Benchmark::GetInstance().Start(name, iterations) ? 0 : 1;
+        },
+        .argtable = nullptr,
+    };
+    esp_err_t ret = esp_console_cmd_register(&cmd);
+    if (ret != ESP_OK) {
+        ESP_LOGD(TAG, "Console is not available: %s", esp_err_to_name(ret));
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstdint>
+#include <atomic>
+
+/*
+ * 核心模块的基准测试，使用合成输入在设备上运行，打印每个模块的吞吐量：
+ *   opus_encode / opus_decode / resample  60ms 一帧的 16kHz 单声道音频，同时给出实时倍数
+ *   mcp_parse    McpServer 解析一条带参数的通知消息，不产生回复
+ *   mcp_bind     把 12 个属性的 tools/call 参数绑定到预先分配的参数帧
+ *   tools_build  重新序列化 tools/list 的第一页；tools_list 读取缓存的第一页
+ *   chat_parse   用快速路径解析一轮对话的 stt / llm / tts 消息；chat_cjson 用 cJSON 解析同样的消息
+ *   posture      用抖动的 17 个关键点分析坐姿
+ *   eye          渲染并缩放一帧眼球动画
+ *   state_event  向满员的状态订阅者表分发一次状态变化 (不经过事件循环)
+ *   state_post   经默认事件循环投递并分发完一次状态变化，包含 esp_event_post 的复制和堆分配；
+ *                state_post_copy 为原来每次在锁内复制回调 vector 的分发方式
+ * 通过串口命令 bench [模块|all] [次数] 运行，测试在独立的低优先级任务中进行，Opus 编码需要较大的栈。
+ * 开启 CONFIG_USE_TIMELINE_TRACE 时每个模块会记录为一个时间段。
+ * 不依赖外设的模块在主机上也有对应的测试和基准测试，见 host/CMakeLists.txt。
+ */
+struct BenchmarkResult {
+    int iterations;
+    int64_t elapsed_us;
+    uint32_t audio_ms;      // 处理的音频时长，非音频模块为 0
+};
+
+class Benchmark {
+public:
+    static Benchmark& GetInstance() {
+        static Benchmark instance;
+        return instance;
+    }
+    Benchmark(const Benchmark&) = delete;
+    Benchmark& operator=(const Benchmark&) = delete;
+
+    void RegisterConsoleCommand();
+    // 在后台任务中运行，name 为 nullptr 时运行所有模块，iterations 为 0 时使用各模块的默认次数
+    bool Start(const char* name, int iterations);
+    // 在当前任务中运行，返回运行的模块数
+    int Run(const char* name, int iterations);
+
+private:
+    Benchmark() = default;
+
+    std::atomic<bool> running_{false};
+    char name_[16] = {};
+    int iterations_ = 0;
+
+    void PrintResult(const char* name, const BenchmarkResult& result);
+};
+
+#endif // BENCHMARK_H
@@ -3,6 +3,7 @@
 #include "display/lcd_display.h"
 #include "system_reset.h"
 #include "application.h"
+#include "settings.h"
 #include "button.h"
 #include "config.h"
 #include "power_save_timer.h"
@@ -65,6 +66,7 @@ private:
                     /* 低于某个电量，会自动关机 */
                     if (self->power_manager_->low_voltage_ < 2630 && self->power_status_ == kDeviceBatterySupply) {
                         esp_timer_stop(self->power_manager_->timer_handle_);
+                        Settings::Flush();
 
                         esp_io_expander_set_dir(self->io_exp_handle, XIO_CHG_CTRL, IO_EXPANDER_OUTPUT);
                         esp_io_expander_set_level(self->io_exp_handle, XIO_CHG_CTRL, 0);
@@ -3,10 +3,19 @@
 #include "display.h"
 #include "assets/lang_config.h"
 #include "settings.h"
+#include "http_pool.h"
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <wifi_station.h>
+#include <ssid_manager.h>
 
 static const char *TAG = "DualNetworkBoard";
 
+#define NETWORK_PATH_PROBES_PER_ROUND 3
+#define NETWORK_PATH_PROBE_CONNECT_ID 4
+// 备用模组在这段时间内没有注册上网络 (如未插 SIM 卡) 就放弃链路选择
+#define NETWORK_PATH_STANDBY_TIMEOUT_MS 60000
+
 DualNetworkBoard::DualNetworkBoard(gpio_num_t ml307_tx_pin, gpio_num_t ml307_rx_pin, gpio_num_t ml307_dtr_pin, int32_t default_net_type) 
     : Board(), 
       ml307_tx_pin_(ml307_tx_pin), 
@@ -70,18 +79,161 @@ void DualNetworkBoard::StartNetwork() {
         display->SetStatus(Lang::Strings::DETECTING_MODULE);
     }
     current_board_->StartNetwork();
+
+#if CONFIG_USE_NETWORK_PATH_SELECTION
+    xTaskCreate([](void* arg) {
+        auto board = (DualNetworkBoard*)arg;
+        board->PathMonitorTask();
+        vTaskDelete(NULL);
+    }, "path_monitor", 4096, this, 2, nullptr);
+#endif
+}
+
+NetworkType DualNetworkBoard::GetActiveNetworkType() const {
+    if (active_path_ == 0) {
+        return network_type_;
+    }
+    return network_type_ == NetworkType::WIFI ? NetworkType::ML307 : NetworkType::WIFI;
+}
+
+Board& DualNetworkBoard::GetActiveBoard() const {
+    if (active_path_ == 1 && standby_board_ != nullptr) {
+        return *standby_board_;
+    }
+    return *current_board_;
+}
+
+bool DualNetworkBoard::StartStandbyNetwork() {
+    // 启动成功后才赋给 standby_board_，其他任务不会看到启动到一半的备用链路
+    std::unique_ptr<Board> standby_board;
+    if (network_type_ == NetworkType::ML307) {
+        // 备用 WiFi 只连接已保存的热点，连不上也不进入配网模式，由 WifiStation 在后台重试
+        Settings settings("wifi", false);
+        if (settings.GetInt("force_ap") == 1 || SsidManager::GetInstance().GetSsidList().empty()) {
+            ESP_LOGI(TAG, "No WiFi configured, path selection disabled");
+            return false;
+        }
+        standby_board = std::make_unique<WifiBoard>();
+        WifiStation::GetInstance().Start();
+    } else {
+        // 备用模组不使用 Ml307Board::StartNetwork，没有 SIM 卡时它会一直报警，掉线时还会结束当前会话
+        auto ml307_board = std::make_unique<Ml307Board>(ml307_tx_pin_, ml307_rx_pin_, ml307_dtr_pin_);
+        if (!ml307_board->StartStandbyNetwork(NETWORK_PATH_STANDBY_TIMEOUT_MS)) {
+            ESP_LOGI(TAG, "Standby modem unavailable, path selection disabled");
+            return false;
+        }
+        standby_board = std::move(ml307_board);
+    }
+    standby_board_ = std::move(standby_board);
+    ESP_LOGI(TAG, "Standby network %s started", standby_board_->GetBoardType().c_str());
+    return true;
+}
+
+// 探测对象是实际的会话服务器，取 websocket 地址或 mqtt 地址，都没有时使用 OTA 地址
+static bool GetProbeTarget(std::string& host, int& port) {
+    std::string url = Settings("websocket", false).GetString("url");
+    if (url.empty()) {
+        url = Settings("mqtt", false).GetString("endpoint");
+        port = 8883;
+    }
+    if (url.empty()) {
+        url = CONFIG_OTA_URL;
+    }
+
+    size_t host_start = url.find("://");
+    if (host_start != std::string::npos) {
+        port = url.compare(0, host_start, "wss") == 0 || url.compare(0, host_start, "https") == 0 ? 443 : 80;
+        host_start += 3;
+    } else {
+        host_start = 0;
+    }
+    size_t host_end = url.find_first_of(":/", host_start);
+    host = url.substr(host_start, host_end == std::string::npos ? std::string::npos : host_end - host_start);
+    if (host_end != std::string::npos && url[host_end] == ':') {
+        port = atoi(url.c_str() + host_end + 1);
+    }
+    return !host.empty() && port > 0;
+}
+
+// 用 TCP 建连时间近似 RTT
+class TcpPathProber : public PathProber {
+public:
+    TcpPathProber(NetworkInterface* const* networks, const std::string& host, int port)
+        : networks_(networks), host_(host), port_(port) {}
+
+    bool Connect(int path, uint32_t& rtt_ms) override {
+        if (networks_[path] == nullptr) {
+            return false;
+        }
+        auto tcp = networks_[path]->CreateTcp(NETWORK_PATH_PROBE_CONNECT_ID);
+        int64_t start_time = esp_timer_get_time();
+        if (tcp == nullptr || !tcp->Connect(host_, port_)) {
+            return false;
+        }
+        rtt_ms = (esp_timer_get_time() - start_time) / 1000;
+        tcp->Disconnect();
+        return true;
+    }
+
+private:
+    NetworkInterface* const* networks_;
+    std::string host_;
+    int port_;
+};
+
+void DualNetworkBoard::PathMonitorTask() {
+    if (!StartStandbyNetwork()) {
+        return;
+    }
+
+    auto& app = Application::GetInstance();
+    const std::string names[] = { current_board_->GetBoardType(), standby_board_->GetBoardType() };
+    path_selector_.Reset(0);
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_NETWORK_PATH_PROBE_INTERVAL_S * 1000));
+        // 只在空闲时探测，不和会话抢带宽
+        if (app.GetDeviceState() != kDeviceStateIdle) {
+            continue;
+        }
+        std::string host;
+        int port = 0;
+        if (!GetProbeTarget(host, port)) {
+            continue;
+        }
+
+        NetworkInterface* const networks[NetworkPathSelector::kPathCount] = { current_board_->GetNetwork(), standby_board_->GetNetwork() };
+        TcpPathProber prober(networks, host, port);
+        for (int path = 0; path < NetworkPathSelector::kPathCount; path++) {
+            auto result = NetworkPathSelector::Probe(prober, path, NETWORK_PATH_PROBES_PER_ROUND);
+            path_selector_.Report(path, result);
+            auto& quality = path_selector_.quality(path);
+            ESP_LOGI(TAG, "Probe %s via %s: %lu/%lu ok, rtt %lu ms, srtt %lu ms, loss %lu permille",
+                host.c_str(), names[path].c_str(), result.probes - result.failures, result.probes, result.rtt_ms,
+                quality.srtt_ms, quality.loss_permille);
+        }
+
+        // 切换只影响之后新建的连接，正在进行的会话不受影响
+        if (path_selector_.Select()) {
+            active_path_ = path_selector_.active_path();
+            HttpPool::GetInstance().Clear();
+            ESP_LOGI(TAG, "Switch active network path to %s", names[active_path_].c_str());
+        }
+    }
 }
 
 NetworkInterface* DualNetworkBoard::GetNetwork() {
-    return current_board_->GetNetwork();
+    return GetActiveBoard().GetNetwork();
 }
 
 const char* DualNetworkBoard::GetNetworkStateIcon() {
-    return current_board_->GetNetworkStateIcon();
+    return GetActiveBoard().GetNetworkStateIcon();
 }
 
 void DualNetworkBoard::SetPowerSaveMode(bool enabled) {
     current_board_->SetPowerSaveMode(enabled);
+    if (standby_board_ != nullptr) {
+        standby_board_->SetPowerSaveMode(enabled);
+    }
 }
 
 std::string DualNetworkBoard::GetBoardJson() {   
@@ -4,7 +4,9 @@
 #include "board.h"
 #include "wifi_board.h"
 #include "ml307_board.h"
+#include "network_path_selector.h"
 #include <memory>
+#include <atomic>
 
 //enum NetworkType
 enum class NetworkType {
@@ -32,6 +34,15 @@ private:
 
     // 初始化当前网络类型对应的板卡
     void InitializeCurrentBoard();
+
+    // 备用链路，空闲时探测两条链路，会话开始时使用较快的一条 (CONFIG_USE_NETWORK_PATH_SELECTION)
+    std::unique_ptr<Board> standby_board_;
+    std::atomic<int> active_path_ = 0;  // 0: current_board_, 1: standby_board_
+    NetworkPathSelector path_selector_;
+
+    bool StartStandbyNetwork();
+    void PathMonitorTask();
+    Board& GetActiveBoard() const;
  
 public:
     DualNetworkBoard(gpio_num_t ml307_tx_pin, gpio_num_t ml307_rx_pin, gpio_num_t ml307_dtr_pin = GPIO_NUM_NC, int32_t default_net_type = 1);
@@ -42,6 +53,9 @@ public:
     
     // 获取当前网络类型
     NetworkType GetNetworkType() const { return network_type_; }
+
+    // 获取实际用于通信的网络类型，开启链路选择时可能与 GetNetworkType 不同
+    NetworkType GetActiveNetworkType() const;
     
     // 获取当前活动的板卡引用
     Board& GetCurrentBoard() const { return *current_board_; }
@@ -3,6 +3,8 @@
 #include "display.h"
 #include "board.h"
 #include "system_info.h"
+#include "memory_placement.h"
+#include "task_planner.h"
 
 #include <esp_log.h>
 #include <esp_heap_caps.h>
@@ -60,7 +62,7 @@ Esp32Camera::Esp32Camera(const camera_config_t& config) {
 
     preview_image_.header.stride = preview_image_.header.w * 2;
     preview_image_.data_size = preview_image_.header.w * preview_image_.header.h * 2;
-    preview_image_.data = (uint8_t*)heap_caps_malloc(preview_image_.data_size, MALLOC_CAP_SPIRAM);
+    preview_image_.data = (uint8_t*)memory_placement_malloc(MEMORY_BUFFER_CAMERA_PREVIEW, preview_image_.data_size);
     if (preview_image_.data == nullptr) {
         ESP_LOGE(TAG, "Failed to allocate memory for preview image");
         return;
@@ -73,7 +75,7 @@ Esp32Camera::~Esp32Camera() {
         fb_ = nullptr;
     }
     if (preview_image_.data) {
-        heap_caps_free((void*)preview_image_.data);
+        memory_placement_free((void*)preview_image_.data);
         preview_image_.data = nullptr;
     }
     esp_camera_deinit();
@@ -196,7 +198,7 @@ std::string Esp32Camera::Explain(const std::string& question) {
     }
 
     // We spawn a thread to encode the image to JPEG
-    encoder_thread_ = std::thread([this, jpeg_queue]() {
+    encoder_thread_ = TaskPlanner::GetInstance().CreateThread(kTaskRoleCameraEncoder, "jpeg_encoder", 0, [this, jpeg_queue]() {
         frame2jpg_cb(fb_, 80, [](void* arg, size_t index, const void* data, size_t len) -> unsigned int {
             auto jpeg_queue = (QueueHandle_t)arg;
             JpegChunk chunk = {
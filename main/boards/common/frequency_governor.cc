@@ -0,0 +1,121 @@
+#include "frequency_governor.h"
+#include "metrics.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include <algorithm>
+
+#define TAG "FrequencyGovernor"
+
+#define GOVERNOR_MIN_FREQ_MHZ 40
+#define GOVERNOR_LOW_FREQ_MHZ 80
+#define GOVERNOR_MEDIUM_FREQ_MHZ 160
+
+FrequencyGovernor::FrequencyGovernor() {
+    auto& metrics = MetricsRegistry::GetInstance();
+    level_time_counters_[kFrequencyLevelSleep] = metrics.AddCounter("cpu.sleep_ms");
+    level_time_counters_[kFrequencyLevelLow] = metrics.AddCounter("cpu.low_ms");
+    level_time_counters_[kFrequencyLevelMedium] = metrics.AddCounter("cpu.medium_ms");
+    level_time_counters_[kFrequencyLevelHigh] = metrics.AddCounter("cpu.high_ms");
+    level_gauge_ = metrics.AddGauge("cpu.level");
+}
+
+void FrequencyGovernor::Configure(int cpu_max_freq) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cpu_max_freq_ = cpu_max_freq;
+    if (no_light_sleep_lock_ == nullptr) {
+        esp_err_t ret = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "governor", &no_light_sleep_lock_);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to create light sleep lock: %s", esp_err_to_name(ret));
+        }
+    }
+    applied_level_ = kFrequencyLevelCount;
+    Apply();
+}
+
+void FrequencyGovernor::SetDemand(PowerDemand demand, bool active) {
+    uint32_t previous = active ? demands_.fetch_or(demand) : demands_.fetch_and(~demand);
+    if (((previous & demand) != 0) == active) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    Apply();
+}
+
+void FrequencyGovernor::SetSleepMode(bool sleep) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sleep_ = sleep;
+    Apply();
+}
+
+void FrequencyGovernor::Tick() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Apply();
+    for (int i = 0; i < kFrequencyLevelCount; i++) {
+        uint32_t time_ms = policy_.time_in_level_ms((FrequencyLevel)i);
+        level_time_counters_[i]->Add(time_ms - reported_time_ms_[i]);
+        reported_time_ms_[i] = time_ms;
+    }
+}
+
+FrequencyLevel FrequencyGovernor::level() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return policy_.level();
+}
+
+void FrequencyGovernor::Apply() {
+    uint32_t demands = demands_.load();
+    uint32_t now_ms = esp_timer_get_time() / 1000;
+    // 调试级别的日志即为策略的输入序列，可以用主机上的 frequency_replay 回放
+    ESP_LOGD(TAG, "trace %lu 0x%02lx %d", now_ms, demands, sleep_);
+    auto level = policy_.Update(demands, sleep_, now_ms);
+    level_gauge_->Set(level);
+
+    if (cpu_max_freq_ == -1) {
+        return;
+    }
+
+    bool audio = (demands & (kPowerDemandAudioInput | kPowerDemandAudioOutput)) != 0;
+    if (no_light_sleep_lock_ != nullptr && audio != no_light_sleep_locked_) {
+        if (audio) {
+            esp_pm_lock_acquire(no_light_sleep_lock_);
+        } else {
+            esp_pm_lock_release(no_light_sleep_lock_);
+        }
+        no_light_sleep_locked_ = audio;
+    }
+
+    if (level == applied_level_) {
+        return;
+    }
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = cpu_max_freq_,
+        .min_freq_mhz = cpu_max_freq_,
+        .light_sleep_enable = false,
+    };
+    switch (level) {
+        case kFrequencyLevelSleep:
+            pm_config.min_freq_mhz = GOVERNOR_MIN_FREQ_MHZ;
+            pm_config.light_sleep_enable = true;
+            break;
+        case kFrequencyLevelLow:
+            pm_config.max_freq_mhz = std::min(cpu_max_freq_, GOVERNOR_LOW_FREQ_MHZ);
+            pm_config.min_freq_mhz = GOVERNOR_MIN_FREQ_MHZ;
+            break;
+        case kFrequencyLevelMedium:
+            pm_config.max_freq_mhz = std::min(cpu_max_freq_, GOVERNOR_MEDIUM_FREQ_MHZ);
+            pm_config.min_freq_mhz = GOVERNOR_LOW_FREQ_MHZ;
+            break;
+        default:
+            break;
+    }
+    esp_err_t ret = esp_pm_configure(&pm_config);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to configure %s level: %s", FrequencyLevelName(level), esp_err_to_name(ret));
+        return;
+    }
+    applied_level_ = level;
+    ESP_LOGI(TAG, "Level %s: %d ~ %d MHz, light sleep %s", FrequencyLevelName(level), pm_config.min_freq_mhz,
+        pm_config.max_freq_mhz, pm_config.light_sleep_enable ? "on" : "off");
+}
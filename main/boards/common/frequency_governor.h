@@ -0,0 +1,59 @@
+#ifndef FREQUENCY_GOVERNOR_H
+#define FREQUENCY_GOVERNOR_H
+
+#include "frequency_policy.h"
+
+#include <atomic>
+#include <mutex>
+
+#include <esp_pm.h>
+
+class MetricCounter;
+class MetricGauge;
+
+/*
+ * 根据负载需求调整 CPU 频率。Application (设备状态)、AudioService (编解码器开关)、
+ * 眼球动画和 MJPEG 播放器报告需求，FrequencyPolicy 决定级别，这里换算成 esp_pm 的频率范围：
+ *   sleep   最高频率 ~ 40MHz，允许自动 light sleep (与原 PowerSaveTimer 休眠时相同)
+ *   low     80 ~ 40MHz
+ *   medium  160 ~ 80MHz
+ *   high    固定最高频率 (与原 PowerSaveTimer 唤醒时相同)
+ * 音频需求存在时持有 NO_LIGHT_SLEEP 锁，避免 I2S 被打断。
+ * 只有板卡在 PowerSaveTimer 中指定了最高频率时才调用 esp_pm，否则只统计各级别的时间 (指标 cpu.*_ms)。
+ */
+class FrequencyGovernor {
+public:
+    static FrequencyGovernor& GetInstance() {
+        static FrequencyGovernor instance;
+        return instance;
+    }
+    FrequencyGovernor(const FrequencyGovernor&) = delete;
+    FrequencyGovernor& operator=(const FrequencyGovernor&) = delete;
+
+    void Configure(int cpu_max_freq);
+    void SetDemand(PowerDemand demand, bool active);
+    void SetSleepMode(bool sleep);
+    // 每秒调用一次，处理延迟降频并更新统计
+    void Tick();
+    FrequencyLevel level();
+
+private:
+    FrequencyGovernor();
+
+    std::mutex mutex_;
+    FrequencyPolicy policy_;
+    std::atomic<uint32_t> demands_{0};
+    bool sleep_ = false;
+    int cpu_max_freq_ = -1;
+    FrequencyLevel applied_level_ = kFrequencyLevelCount;
+    esp_pm_lock_handle_t no_light_sleep_lock_ = nullptr;
+    bool no_light_sleep_locked_ = false;
+
+    MetricCounter* level_time_counters_[kFrequencyLevelCount];
+    MetricGauge* level_gauge_;
+    uint32_t reported_time_ms_[kFrequencyLevelCount] = {};
+
+    void Apply();
+};
+
+#endif // FREQUENCY_GOVERNOR_H
@@ -0,0 +1,47 @@
+#include "frequency_policy.h"
+
+const char* FrequencyLevelName(FrequencyLevel level) {
+    static const char* const kLevelNames[] = {"sleep", "low", "medium", "high"};
+    return level < kFrequencyLevelCount ? kLevelNames[level] : "unknown";
+}
+
+FrequencyLevel FrequencyPolicy::RequiredLevel(uint32_t demands, bool sleep) {
+    if (demands & (kPowerDemandAudioInput | kPowerDemandAudioOutput | kPowerDemandVideo)) {
+        return kFrequencyLevelHigh;
+    }
+    if (demands & (kPowerDemandAnimation | kPowerDemandNetwork)) {
+        return kFrequencyLevelMedium;
+    }
+    return sleep ? kFrequencyLevelSleep : kFrequencyLevelLow;
+}
+
+FrequencyLevel FrequencyPolicy::Update(uint32_t demands, bool sleep, uint32_t now_ms) {
+    if (started_) {
+        time_in_level_ms_[level_] += now_ms - last_update_ms_;
+    }
+    started_ = true;
+    last_update_ms_ = now_ms;
+
+    FrequencyLevel required = RequiredLevel(demands, sleep);
+    if (required >= level_) {
+        level_ = required;
+        last_demand_ms_ = now_ms;
+    } else if (sleep) {
+        level_ = required;
+    } else if (now_ms - last_demand_ms_ >= downscale_hold_ms_) {
+        level_ = (FrequencyLevel)(level_ - 1);
+        last_demand_ms_ = now_ms;
+    }
+    return level_;
+}
+
+FrequencyLevel FrequencyPolicy::Replay(const std::vector<FrequencyTraceSample>& trace, std::vector<FrequencyTransition>* transitions) {
+    for (auto& sample : trace) {
+        FrequencyLevel from = level_;
+        FrequencyLevel to = Update(sample.demands, sample.sleep, sample.time_ms);
+        if (transitions != nullptr && to != from) {
+            transitions->push_back({sample.time_ms, sample.demands, sample.sleep, from, to});
+        }
+    }
+    return level_;
+}
@@ -0,0 +1,70 @@
+#ifndef FREQUENCY_POLICY_H
+#define FREQUENCY_POLICY_H
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * CPU 调频策略，只包含策略，不依赖 FreeRTOS 和 esp_pm，可以在主机上用记录的状态序列回放。
+ *
+ * 输入为各模块报告的负载需求和是否处于休眠，输出为频率级别。
+ * 有需求时立即升到所需级别，需求消失后保持 downscale_hold_ms 才逐级降低，避免频繁切换；
+ * 进入休眠时直接降到最低。
+ */
+enum PowerDemand : uint32_t {
+    kPowerDemandAudioInput = 1 << 0,    // 录音、AFE、唤醒词
+    kPowerDemandAudioOutput = 1 << 1,   // 解码播放
+    kPowerDemandVideo = 1 << 2,         // MJPEG 解码播放
+    kPowerDemandAnimation = 1 << 3,     // 眼球动画
+    kPowerDemandNetwork = 1 << 4,       // 连接、激活、升级
+};
+
+enum FrequencyLevel {
+    kFrequencyLevelSleep,   // 允许自动 light sleep
+    kFrequencyLevelLow,
+    kFrequencyLevelMedium,
+    kFrequencyLevelHigh,
+    kFrequencyLevelCount,
+};
+
+struct FrequencyTraceSample {
+    uint32_t time_ms;
+    uint32_t demands;
+    bool sleep;
+};
+
+// 回放时记录的级别变化，以及引起变化的需求
+struct FrequencyTransition {
+    uint32_t time_ms;
+    uint32_t demands;
+    bool sleep;
+    FrequencyLevel from;
+    FrequencyLevel to;
+};
+
+const char* FrequencyLevelName(FrequencyLevel level);
+
+class FrequencyPolicy {
+public:
+    explicit FrequencyPolicy(uint32_t downscale_hold_ms = 3000) : downscale_hold_ms_(downscale_hold_ms) {}
+
+    static FrequencyLevel RequiredLevel(uint32_t demands, bool sleep);
+
+    // 返回更新后的级别，并累计上一级别停留的时间
+    FrequencyLevel Update(uint32_t demands, bool sleep, uint32_t now_ms);
+    // 回放记录的状态序列，返回最后的级别，transitions 不为空时追加每次级别变化
+    FrequencyLevel Replay(const std::vector<FrequencyTraceSample>& trace, std::vector<FrequencyTransition>* transitions = nullptr);
+
+    FrequencyLevel level() const { return level_; }
+    uint32_t time_in_level_ms(FrequencyLevel level) const { return time_in_level_ms_[level]; }
+
+private:
+    uint32_t downscale_hold_ms_;
+    FrequencyLevel level_ = kFrequencyLevelHigh;
+    bool started_ = false;
+    uint32_t last_update_ms_ = 0;
+    uint32_t last_demand_ms_ = 0;
+    uint32_t time_in_level_ms_[kFrequencyLevelCount] = {};
+};
+
+#endif // FREQUENCY_POLICY_H
@@ -26,6 +26,7 @@ void Ml307Board::StartNetwork() {
     while (true) {
         modem_ = AtModem::Detect(tx_pin_, rx_pin_, dtr_pin_, 921600);
         if (modem_ != nullptr) {
+            network_ = std::make_unique<PooledNetwork>(modem_.get());
             break;
         }
         vTaskDelay(pdMS_TO_TICKS(1000));
@@ -68,8 +69,38 @@ void Ml307Board::StartNetwork() {
     ESP_LOGI(TAG, "ML307 ICCID: %s", iccid.c_str());
 }
 
+bool Ml307Board::StartStandbyNetwork(int timeout_ms) {
+    int64_t deadline = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    while (true) {
+        modem_ = AtModem::Detect(tx_pin_, rx_pin_, dtr_pin_, 921600);
+        if (modem_ != nullptr) {
+            network_ = std::make_unique<PooledNetwork>(modem_.get());
+            break;
+        }
+        if (esp_timer_get_time() >= deadline) {
+            ESP_LOGW(TAG, "Standby modem not detected");
+            return false;
+        }
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+
+    // The primary network owns the session, the standby modem only logs its state
+    modem_->OnNetworkStateChanged([](bool network_ready) {
+        ESP_LOGI(TAG, "Standby network is %s", network_ready ? "ready" : "down");
+    });
+
+    int remaining_ms = (deadline - esp_timer_get_time()) / 1000;
+    auto result = modem_->WaitForNetworkReady(remaining_ms > 0 ? remaining_ms : 1);
+    if (result != NetworkStatus::Ready) {
+        ESP_LOGW(TAG, "Standby network not ready: %d", (int)result);
+        return false;
+    }
+    ESP_LOGI(TAG, "ML307 Revision: %s", modem_->GetModuleRevision().c_str());
+    return true;
+}
+
 NetworkInterface* Ml307Board::GetNetwork() {
-    return modem_.get();
+    return network_.get();
 }
 
 const char* Ml307Board::GetNetworkStateIcon() {
@@ -4,11 +4,13 @@
 #include <memory>
 #include <at_modem.h>
 #include "board.h"
+#include "http_pool.h"
 
 
 class Ml307Board : public Board {
 protected:
     std::unique_ptr<AtModem> modem_;
+    std::unique_ptr<PooledNetwork> network_;    // 包装 modem_，Http 请求复用连接
     gpio_num_t tx_pin_;
     gpio_num_t rx_pin_;
     gpio_num_t dtr_pin_;
@@ -19,6 +21,8 @@ public:
     Ml307Board(gpio_num_t tx_pin, gpio_num_t rx_pin, gpio_num_t dtr_pin = GPIO_NUM_NC);
     virtual std::string GetBoardType() override;
     virtual void StartNetwork() override;
+    // 作为双网络板卡的备用链路启动: 不提示、不修改显示和设备状态，timeout_ms 内未就绪则放弃
+    bool StartStandbyNetwork(int timeout_ms);
     virtual NetworkInterface* GetNetwork() override;
     virtual const char* GetNetworkStateIcon() override;
     virtual void SetPowerSaveMode(bool enabled) override;
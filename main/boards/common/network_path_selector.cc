@@ -0,0 +1,85 @@
+#include "network_path_selector.h"
+
+#include <algorithm>
+
+// 1% 丢包约等于 20ms RTT
+#define PATH_LOSS_PENALTY_MS_PER_PERMILLE 2
+// 候选链路得分需低于当前链路的 70% 才考虑切换
+#define PATH_SWITCH_RATIO_PERCENT 70
+#define PATH_SWITCH_ROUNDS 2
+#define PATH_UNREACHABLE_SCORE UINT32_MAX
+
+void NetworkPathSelector::Reset(int active_path) {
+    for (auto& quality : quality_) {
+        quality = PathQuality();
+    }
+    active_path_ = active_path;
+    better_rounds_ = 0;
+}
+
+PathProbeResult NetworkPathSelector::Probe(PathProber& prober, int path, uint32_t probes) {
+    PathProbeResult result;
+    uint32_t total_rtt_ms = 0;
+    for (uint32_t i = 0; i < probes; i++) {
+        result.probes++;
+        uint32_t rtt_ms = 0;
+        if (!prober.Connect(path, rtt_ms)) {
+            result.failures++;
+            continue;
+        }
+        total_rtt_ms += rtt_ms;
+    }
+    if (result.failures < result.probes) {
+        result.rtt_ms = total_rtt_ms / (result.probes - result.failures);
+    }
+    return result;
+}
+
+void NetworkPathSelector::Report(int path, const PathProbeResult& result) {
+    auto& quality = quality_[path];
+    quality.rounds++;
+    if (result.probes == 0) {
+        quality.reachable = false;
+        return;
+    }
+
+    uint32_t loss = result.failures * 1000 / result.probes;
+    quality.loss_permille = quality.rounds == 1 ? loss : (quality.loss_permille + loss) / 2;
+    quality.reachable = result.failures < result.probes;
+    if (quality.reachable) {
+        quality.srtt_ms = quality.srtt_ms == 0 ? result.rtt_ms : (quality.srtt_ms * 3 + result.rtt_ms) / 4;
+    }
+}
+
+uint32_t NetworkPathSelector::Score(int path) const {
+    auto& quality = quality_[path];
+    if (!quality.reachable) {
+        return PATH_UNREACHABLE_SCORE;
+    }
+    return quality.srtt_ms + quality.loss_permille * PATH_LOSS_PENALTY_MS_PER_PERMILLE;
+}
+
+bool NetworkPathSelector::Select() {
+    int candidate = 1 - active_path_;
+    uint32_t active_score = Score(active_path_);
+    uint32_t candidate_score = Score(candidate);
+    if (candidate_score == PATH_UNREACHABLE_SCORE) {
+        better_rounds_ = 0;
+        return false;
+    }
+
+    if (active_score == PATH_UNREACHABLE_SCORE) {
+        better_rounds_ = PATH_SWITCH_ROUNDS;
+    } else if ((uint64_t)candidate_score * 100 < (uint64_t)active_score * PATH_SWITCH_RATIO_PERCENT) {
+        better_rounds_++;
+    } else {
+        better_rounds_ = 0;
+    }
+
+    if (better_rounds_ < PATH_SWITCH_ROUNDS) {
+        return false;
+    }
+    active_path_ = candidate;
+    better_rounds_ = 0;
+    return true;
+}
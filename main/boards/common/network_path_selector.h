@@ -0,0 +1,58 @@
+#ifndef NETWORK_PATH_SELECTOR_H
+#define NETWORK_PATH_SELECTOR_H
+
+#include <cstdint>
+
+/*
+ * 双网络链路选择，只包含策略，不依赖 FreeRTOS 和网络接口，探测通过调用方提供的 PathProber 完成。
+ *
+ * 每轮探测后对每条链路上报一次结果 (成功次数、失败次数、平均 RTT)，
+ * 按平滑 RTT 加上丢包惩罚打分。候选链路连续若干轮明显优于当前链路才切换，
+ * 当前链路不可达时立即切换，避免两条链路相近时来回抖动。
+ */
+struct PathProbeResult {
+    uint32_t probes = 0;
+    uint32_t failures = 0;
+    uint32_t rtt_ms = 0;            // 成功探测的平均 RTT
+};
+
+// 对单条链路建立一次连接，设备上用 NetworkInterface 的 TCP 建连实现，主机测试用模拟链路
+class PathProber {
+public:
+    virtual ~PathProber() = default;
+    // 返回是否连接成功，成功时 rtt_ms 为建连耗时
+    virtual bool Connect(int path, uint32_t& rtt_ms) = 0;
+};
+
+struct PathQuality {
+    bool reachable = false;
+    uint32_t srtt_ms = 0;
+    uint32_t loss_permille = 0;
+    uint32_t rounds = 0;
+};
+
+class NetworkPathSelector {
+public:
+    static constexpr int kPathCount = 2;
+
+    NetworkPathSelector() = default;
+
+    // 对一条链路连续探测 probes 次，失败计为丢包
+    static PathProbeResult Probe(PathProber& prober, int path, uint32_t probes);
+
+    void Report(int path, const PathProbeResult& result);
+    // 根据最近的探测结果决定使用哪条链路，返回 true 表示发生了切换
+    bool Select();
+    void Reset(int active_path);
+
+    int active_path() const { return active_path_; }
+    const PathQuality& quality(int path) const { return quality_[path]; }
+    uint32_t Score(int path) const;
+
+private:
+    PathQuality quality_[kPathCount];
+    int active_path_ = 0;
+    int better_rounds_ = 0;
+};
+
+#endif // NETWORK_PATH_SELECTOR_H
@@ -1,5 +1,7 @@
 #include "power_save_timer.h"
 #include "application.h"
+#include "frequency_governor.h"
+#include "settings.h"
 
 #include <esp_log.h>
 
@@ -19,6 +21,11 @@ PowerSaveTimer::PowerSaveTimer(int cpu_max_freq, int seconds_to_sleep, int secon
         .skip_unhandled_events = true,
     };
     ESP_ERROR_CHECK(esp_timer_create(&timer_args, &power_save_timer_));
+
+    // 频率由 FrequencyGovernor 根据负载调整，这里只负责休眠
+    if (cpu_max_freq_ != -1) {
+        FrequencyGovernor::GetInstance().Configure(cpu_max_freq_);
+    }
 }
 
 PowerSaveTimer::~PowerSaveTimer() {
@@ -66,18 +73,12 @@ void PowerSaveTimer::PowerSaveCheck() {
             if (on_enter_sleep_mode_) {
                 on_enter_sleep_mode_();
             }
-
-            if (cpu_max_freq_ != -1) {
-                esp_pm_config_t pm_config = {
-                    .max_freq_mhz = cpu_max_freq_,
-                    .min_freq_mhz = 40,
-                    .light_sleep_enable = true,
-                };
-                esp_pm_configure(&pm_config);
-            }
+            FrequencyGovernor::GetInstance().SetSleepMode(true);
         }
     }
     if (seconds_to_shutdown_ != -1 && ticks_ >= seconds_to_shutdown_ && on_shutdown_request_) {
+        // 板卡通常在回调中深度睡眠或关闭电源，先提交设置
+        Settings::Flush();
         on_shutdown_request_();
     }
 }
@@ -86,15 +87,7 @@ void PowerSaveTimer::WakeUp() {
     ticks_ = 0;
     if (in_sleep_mode_) {
         in_sleep_mode_ = false;
-
-        if (cpu_max_freq_ != -1) {
-            esp_pm_config_t pm_config = {
-                .max_freq_mhz = cpu_max_freq_,
-                .min_freq_mhz = cpu_max_freq_,
-                .light_sleep_enable = false,
-            };
-            esp_pm_configure(&pm_config);
-        }
+        FrequencyGovernor::GetInstance().SetSleepMode(false);
 
         if (on_exit_sleep_mode_) {
             on_exit_sleep_mode_();
@@ -2,6 +2,7 @@
 #include "application.h"
 #include "board.h"
 #include "display.h"
+#include "settings.h"
 
 #include <esp_log.h>
 #include <esp_sleep.h>
@@ -95,6 +96,7 @@ void SleepTimer::CheckTimer() {
         }
     }
     if (seconds_to_deep_sleep_ != -1 && ticks_ >= seconds_to_deep_sleep_) {
+        Settings::Flush();
         if (on_enter_deep_sleep_mode_) {
             on_enter_deep_sleep_mode_();
         }
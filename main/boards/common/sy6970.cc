@@ -1,6 +1,7 @@
 #include "sy6970.h"
 #include "board.h"
 #include "display.h"
+#include "settings.h"
 
 #include <esp_log.h>
 
@@ -61,5 +62,6 @@ int Sy6970::GetBatteryLevel() {
 }
 
 void Sy6970::PowerOff() {
+    Settings::Flush();
     WriteReg(0x09, 0B01100100);
 }
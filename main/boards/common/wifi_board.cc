@@ -6,6 +6,7 @@
 #include "font_awesome_symbols.h"
 #include "settings.h"
 #include "assets/lang_config.h"
+#include "http_pool.h"
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
@@ -119,7 +120,8 @@ void WifiBoard::StartNetwork() {
 
 NetworkInterface* WifiBoard::GetNetwork() {
     static EspNetwork network;
-    return &network;
+    static PooledNetwork pooled_network(&network);
+    return &pooled_network;
 }
 
 const char* WifiBoard::GetNetworkStateIcon() {
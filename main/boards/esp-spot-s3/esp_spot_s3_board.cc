@@ -1,6 +1,7 @@
 #include "wifi_board.h"
 #include "codecs/es8311_audio_codec.h"
 #include "application.h"
+#include "settings.h"
 #include "button.h"
 #include "config.h"
 #include "sdkconfig.h"
@@ -103,6 +104,7 @@ private:
                     ESP_LOGW(TAG, "Key button long pressed the second time within 5s, shutting down...");
                     led->SetSingleColor(0, {0, 0, 0});
 
+                    Settings::Flush();
                     gpio_hold_dis(MCU_VCC_CTL);
                     gpio_set_level(MCU_VCC_CTL, 0);
 
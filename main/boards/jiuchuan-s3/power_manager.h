@@ -8,6 +8,7 @@
 #include "power_controller.h"
 #include <driver/rtc_io.h>
 #include <esp_sleep.h>
+#include "settings.h"
 
 #define JIUCHUAN_ADC_UNIT (ADC_UNIT_1)
 #define JIUCHUAN_ADC_BITWIDTH (ADC_BITWIDTH_12)
@@ -164,6 +165,7 @@ public:
                 case PowerState::SHUTDOWN: {
 
                     ESP_LOGD(TAG, "关机");
+                    Settings::Flush();
                     
                 //取消 PWR_EN 使能
                     /* 防止关机后误唤醒 */
@@ -5,6 +5,7 @@
 #include "display/lcd_display.h"
 #include "font_awesome_symbols.h"
 #include "application.h"
+#include "settings.h"
 #include "knob.h"
 #include "config.h"
 #include "led/single_led.h"
@@ -445,6 +446,7 @@ private:
             .func_w_context = [](void *context,int argc, char** argv) -> int {
                 auto self = static_cast<SensecapWatcher*>(context);
                 self->GetBacklight()->SetBrightness(0);
+                Settings::Flush();
                 self->IoExpanderSetLevel(BSP_PWR_SYSTEM, 0);
                 return 0;
             },
@@ -1,5 +1,6 @@
 #include "wifi_board.h"
 #include "application.h"
+#include "settings.h"
 #include "button.h"
 #include "config.h"
 #include "codecs/box_audio_codec.h"
@@ -179,6 +180,7 @@ private:
             if(pwr_flag == 1)
             {
                 pwr_flag = 0;
+                Settings::Flush();
                 esp_err_t ret;
                 ret = esp_io_expander_set_level(io_expander, IO_EXPANDER_PIN_NUM_6, 0);
                 ESP_ERROR_CHECK(ret);
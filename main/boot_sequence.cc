@@ -0,0 +1,117 @@
+#include "boot_sequence.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
+
+#include <cassert>
+
+#define TAG "BootSequence"
+
+#define BOOT_TIMELINE_WIDTH 32
+
+BootSequence::BootSequence() {
+    event_group_ = xEventGroupCreate();
+    phases_.reserve(BOOT_MAX_PHASES);
+}
+
+BootSequence::~BootSequence() {
+    if (event_group_ != nullptr) {
+        vEventGroupDelete(event_group_);
+    }
+}
+
+int BootSequence::AddPhase(const char* name, std::initializer_list<int> dependencies, std::function<void()> callback,
+    uint32_t stack_size) {
+    int index = phases_.size();
+    assert(index < BOOT_MAX_PHASES);
+
+    uint32_t mask = 0;
+    for (int dependency : dependencies) {
+        assert(dependency >= 0 && dependency < index);
+        mask |= 1 << dependency;
+    }
+    phases_.push_back(Phase{this, index, name, mask, std::move(callback), stack_size, 0, 0});
+    return index;
+}
+
+void BootSequence::RunPhase(Phase& phase) {
+    phase.start_ms = (esp_timer_get_time() - start_time_us_) / 1000;
+    ESP_LOGI(TAG, "Phase %s started", phase.name);
+    phase.callback();
+    phase.end_ms = (esp_timer_get_time() - start_time_us_) / 1000;
+    ESP_LOGI(TAG, "Phase %s done in %d ms", phase.name, phase.end_ms - phase.start_ms);
+}
+
+void BootSequence::Run(bool parallel) {
+    start_time_us_ = esp_timer_get_time();
+    uint32_t all = (1 << phases_.size()) - 1;
+    uint32_t started = 0;
+    uint32_t done = 0;
+
+    while (done != all) {
+        int ready[BOOT_MAX_PHASES];
+        int ready_count = 0;
+        for (auto& phase : phases_) {
+            uint32_t bit = 1 << phase.index;
+            if ((started & bit) == 0 && (phase.dependencies & done) == phase.dependencies) {
+                ready[ready_count++] = phase.index;
+            }
+        }
+
+        // 没有其它阶段在运行时，唯一可执行的阶段直接在当前任务中执行
+        bool running = (started & ~done) != 0;
+        if (ready_count > 0 && (!parallel || (ready_count == 1 && !running))) {
+            auto& phase = phases_[ready[0]];
+            started |= 1 << phase.index;
+            RunPhase(phase);
+            done |= 1 << phase.index;
+            continue;
+        }
+
+        for (int i = 0; i < ready_count; i++) {
+            auto& phase = phases_[ready[i]];
+            started |= 1 << phase.index;
+            BaseType_t ret = xTaskCreate([](void* arg) {
+                auto phase = (Phase*)arg;
+                phase->owner->RunPhase(*phase);
+                xEventGroupSetBits(phase->owner->event_group_, 1 << phase->index);
+                vTaskDelete(NULL);
+            }, phase.name, phase.stack_size, &phase, uxTaskPriorityGet(NULL), nullptr);
+            if (ret != pdPASS) {
+                ESP_LOGW(TAG, "Failed to create task for phase %s, running it inline", phase.name);
+                RunPhase(phase);
+                xEventGroupSetBits(event_group_, 1 << phase.index);
+            }
+        }
+
+        uint32_t pending = started & ~done;
+        if (pending == 0) {
+            ESP_LOGE(TAG, "No phase can be started, check the dependencies");
+            break;
+        }
+        EventBits_t bits = xEventGroupWaitBits(event_group_, pending, pdFALSE, pdFALSE, portMAX_DELAY);
+        done |= bits & pending;
+    }
+
+    total_ms_ = (esp_timer_get_time() - start_time_us_) / 1000;
+}
+
+void BootSequence::PrintTimeline() {
+    ESP_LOGI(TAG, "Boot timeline, total %d ms:", total_ms_);
+    int total = total_ms_ > 0 ? total_ms_ : 1;
+    for (auto& phase : phases_) {
+        char bar[BOOT_TIMELINE_WIDTH + 1];
+        int begin = phase.start_ms * BOOT_TIMELINE_WIDTH / total;
+        int end = phase.end_ms * BOOT_TIMELINE_WIDTH / total;
+        if (end == begin && end < BOOT_TIMELINE_WIDTH) {
+            end++;
+        }
+        for (int i = 0; i < BOOT_TIMELINE_WIDTH; i++) {
+            bar[i] = i >= begin && i < end ? '#' : '.';
+        }
+        bar[BOOT_TIMELINE_WIDTH] = '\0';
+        ESP_LOGI(TAG, "  %-10s %6d %6d %6d ms |%s|", phase.name, phase.start_ms, phase.end_ms,
+            phase.end_ms - phase.start_ms, bar);
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef BOOT_SEQUENCE_H
+#define BOOT_SEQUENCE_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+/*
+ * 启动流程按依赖关系拆成若干阶段，依赖都完成的阶段在各自的任务中并行执行，
+ * 例如联网的同时加载唤醒词模型、初始化摄像头。
+ * 只有一个阶段可以执行时直接在调用者的任务中执行，不额外创建任务。
+ * 记录每个阶段的开始和结束时间，Run 结束后可打印启动时间线。
+ */
+#define BOOT_MAX_PHASES 16
+
+class BootSequence {
+public:
+    BootSequence();
+    ~BootSequence();
+
+    // 返回阶段编号，依赖只能是之前添加的阶段，因此添加顺序就是顺序执行时的顺序
+    int AddPhase(const char* name, std::initializer_list<int> dependencies, std::function<void()> callback,
+        uint32_t stack_size = CONFIG_ESP_MAIN_TASK_STACK_SIZE);
+    // 阻塞直到所有阶段完成，parallel 为 false 时按添加顺序逐个执行
+    void Run(bool parallel = true);
+    void PrintTimeline();
+
+private:
+    struct Phase {
+        BootSequence* owner;
+        int index;
+        const char* name;
+        uint32_t dependencies;
+        std::function<void()> callback;
+        uint32_t stack_size;
+        int start_ms;
+        int end_ms;
+    };
+
+    std::vector<Phase> phases_;
+    EventGroupHandle_t event_group_ = nullptr;
+    int64_t start_time_us_ = 0;
+    int total_ms_ = 0;
+
+    void RunPhase(Phase& phase);
+};
+
+#endif // BOOT_SEQUENCE_H
@@ -1,28 +1,71 @@
 #include "device_state_event.h"
 
+#include <esp_log.h>
+
+#define TAG "DeviceStateEvent"
+
 ESP_EVENT_DEFINE_BASE(XIAOZHI_STATE_EVENTS);
 
-DeviceStateEventManager& DeviceStateEventManager::GetInstance() {
-    static DeviceStateEventManager instance;
-    return instance;
+bool StateChangeSubscribers::Add(std::function<void(DeviceState, DeviceState)> callback, uint32_t state_mask) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int count = count_.load(std::memory_order_relaxed);
+    if (count >= DEVICE_STATE_MAX_SUBSCRIBERS) {
+        return false;
+    }
+    // 先写入空位，再发布计数，分发方看到新计数时订阅者已经完整
+    subscribers_[count] = {std::move(callback), state_mask};
+    count_.store(count + 1, std::memory_order_release);
+    state_mask_.fetch_or(state_mask, std::memory_order_release);
+    return true;
 }
 
-void DeviceStateEventManager::RegisterStateChangeCallback(std::function<void(DeviceState, DeviceState)> callback) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    callbacks_.push_back(callback);
+int StateChangeSubscribers::Dispatch(DeviceState previous_state, DeviceState current_state) const {
+    int count = count_.load(std::memory_order_acquire);
+    uint32_t mask = DEVICE_STATE_MASK(current_state);
+    int called = 0;
+    for (int i = 0; i < count; i++) {
+        auto& subscriber = subscribers_[i];
+        if (subscriber.state_mask & mask) {
+            subscriber.callback(previous_state, current_state);
+            called++;
+        }
+    }
+    return called;
 }
 
-void DeviceStateEventManager::PostStateChangeEvent(DeviceState previous_state, DeviceState current_state) {
+bool StateChangeSubscribers::Post(esp_event_base_t base, int32_t id, DeviceState previous_state, DeviceState current_state) const {
+    if (!Wants(current_state)) {
+        return false;
+    }
     device_state_event_data_t event_data = {
         .previous_state = previous_state,
         .current_state = current_state
     };
-    esp_event_post(XIAOZHI_STATE_EVENTS, XIAOZHI_STATE_CHANGED_EVENT, &event_data, sizeof(event_data), portMAX_DELAY);
+    return esp_event_post(base, id, &event_data, sizeof(event_data), portMAX_DELAY) == ESP_OK;
 }
 
-std::vector<std::function<void(DeviceState, DeviceState)>> DeviceStateEventManager::GetCallbacks() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return callbacks_;
+void StateChangeSubscribers::EventHandler(void* handler_args, esp_event_base_t, int32_t, void* event_data) {
+    auto* data = static_cast<device_state_event_data_t*>(event_data);
+    auto* subscribers = static_cast<StateChangeSubscribers*>(handler_args);
+    subscribers->Dispatch(data->previous_state, data->current_state);
+}
+
+DeviceStateEventManager& DeviceStateEventManager::GetInstance() {
+    static DeviceStateEventManager instance;
+    return instance;
+}
+
+bool DeviceStateEventManager::RegisterStateChangeCallback(std::function<void(DeviceState, DeviceState)> callback,
+    uint32_t state_mask) {
+    if (!subscribers_.Add(std::move(callback), state_mask)) {
+        ESP_LOGE(TAG, "Too many state change subscribers");
+        return false;
+    }
+    return true;
+}
+
+void DeviceStateEventManager::PostStateChangeEvent(DeviceState previous_state, DeviceState current_state) {
+    subscribers_.Post(XIAOZHI_STATE_EVENTS, XIAOZHI_STATE_CHANGED_EVENT, previous_state, current_state);
 }
 
 DeviceStateEventManager::DeviceStateEventManager() {
@@ -31,16 +74,10 @@ DeviceStateEventManager::DeviceStateEventManager() {
         ESP_ERROR_CHECK(err);
     }
 
-    ESP_ERROR_CHECK(esp_event_handler_register(XIAOZHI_STATE_EVENTS, XIAOZHI_STATE_CHANGED_EVENT, 
-        [](void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
-            auto* data = static_cast<device_state_event_data_t*>(event_data);
-            auto& manager = DeviceStateEventManager::GetInstance();
-            for (const auto& callback : manager.GetCallbacks()) {
-                callback(data->previous_state, data->current_state);
-            }
-        }, nullptr));
+    ESP_ERROR_CHECK(esp_event_handler_register(XIAOZHI_STATE_EVENTS, XIAOZHI_STATE_CHANGED_EVENT,
+        StateChangeSubscribers::EventHandler, &subscribers_));
 }
 
 DeviceStateEventManager::~DeviceStateEventManager() {
     esp_event_handler_unregister(XIAOZHI_STATE_EVENTS, XIAOZHI_STATE_CHANGED_EVENT, nullptr);
-}
\ No newline at end of file
+}
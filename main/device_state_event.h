@@ -3,7 +3,7 @@
 
 #include <esp_event.h>
 #include <functional>
-#include <vector>
+#include <atomic>
 #include <mutex>
 #include "device_state.h"
 
@@ -18,22 +18,60 @@ struct device_state_event_data_t {
     DeviceState current_state;
 };
 
+#define DEVICE_STATE_MAX_SUBSCRIBERS 16
+#define DEVICE_STATE_MASK(state) (1u << (state))
+#define DEVICE_STATE_MASK_ALL 0xFFFFFFFFu
+
+/*
+ * 状态变化的订阅者表。固定大小、只追加：注册时加锁写入空位后再发布计数，
+ * 分发时只读取已发布的订阅者，不加锁也不复制 std::function。
+ * 每个订阅者带有关心的目标状态掩码，只在切换到这些状态时被调用。
+ */
+class StateChangeSubscribers {
+public:
+    bool Add(std::function<void(DeviceState, DeviceState)> callback, uint32_t state_mask);
+    // 返回被调用的订阅者个数
+    int Dispatch(DeviceState previous_state, DeviceState current_state) const;
+    bool Wants(DeviceState current_state) const {
+        return (state_mask_.load(std::memory_order_acquire) & DEVICE_STATE_MASK(current_state)) != 0;
+    }
+    // 有订阅者关心目标状态时投递到默认事件循环，返回是否投递
+    bool Post(esp_event_base_t base, int32_t id, DeviceState previous_state, DeviceState current_state) const;
+    // 注册到事件循环的处理函数，handler_args 为 StateChangeSubscribers*
+    static void EventHandler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data);
+
+private:
+    struct Subscriber {
+        std::function<void(DeviceState, DeviceState)> callback;
+        uint32_t state_mask;
+    };
+
+    Subscriber subscribers_[DEVICE_STATE_MAX_SUBSCRIBERS];
+    std::atomic<int> count_{0};
+    std::atomic<uint32_t> state_mask_{0};   // 所有订阅者掩码的并集
+    std::mutex mutex_;
+};
+
+/*
+ * 状态变化通过默认事件循环异步分发给订阅者。没有订阅者关心目标状态时不投递事件。
+ * 分发不复制订阅者也不分配内存，但投递时 esp_event_post 仍会复制事件数据并在堆上分配事件。
+ */
 class DeviceStateEventManager {
 public:
     static DeviceStateEventManager& GetInstance();
     DeviceStateEventManager(const DeviceStateEventManager&) = delete;
     DeviceStateEventManager& operator=(const DeviceStateEventManager&) = delete;
 
-    void RegisterStateChangeCallback(std::function<void(DeviceState, DeviceState)> callback);
+    // state_mask 为 DEVICE_STATE_MASK 的组合，订阅者已满时返回 false
+    bool RegisterStateChangeCallback(std::function<void(DeviceState, DeviceState)> callback,
+        uint32_t state_mask = DEVICE_STATE_MASK_ALL);
     void PostStateChangeEvent(DeviceState previous_state, DeviceState current_state);
-    std::vector<std::function<void(DeviceState, DeviceState)>> GetCallbacks();
 
 private:
     DeviceStateEventManager();
     ~DeviceStateEventManager();
 
-    std::vector<std::function<void(DeviceState, DeviceState)>> callbacks_;
-    std::mutex mutex_;
+    StateChangeSubscribers subscribers_;
 };
 
-#endif // _DEVICE_STATE_EVENT_H_ 
\ No newline at end of file
+#endif // _DEVICE_STATE_EVENT_H_ 
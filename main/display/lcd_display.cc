@@ -13,6 +13,10 @@
 
 #include "board.h"
 #include "mjpeg_player_port.h"
+#include "timeline_trace.h"
+#include "memory_placement.h"
+#include "frequency_governor.h"
+#include "task_planner.h"
 
 #define TAG "LcdDisplay"
 
@@ -68,6 +72,18 @@ const ThemeColors LIGHT_THEME = {
 
 LV_FONT_DECLARE(font_awesome_30_4);
 
+#if CONFIG_USE_TIMELINE_TRACE
+// 一次刷新包括渲染和把脏区域送到屏幕
+static void AddTraceEvents(lv_display_t* display) {
+    lv_display_add_event_cb(display, [](lv_event_t* e) {
+        TRACE_BEGIN("display_refresh");
+    }, LV_EVENT_REFR_START, nullptr);
+    lv_display_add_event_cb(display, [](lv_event_t* e) {
+        TRACE_END("display_refresh");
+    }, LV_EVENT_REFR_READY, nullptr);
+}
+#endif
+
 LcdDisplay::LcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handle_t panel, DisplayFonts fonts, int width, int height)
     : panel_io_(panel_io), panel_(panel), fonts_(fonts) {
     width_ = width;
@@ -105,7 +121,8 @@ SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
 
     ESP_LOGI(TAG, "Initialize LVGL port");
     lvgl_port_cfg_t port_cfg = ESP_LVGL_PORT_INIT_CONFIG();
-    port_cfg.task_priority = 4;       // 提高LVGL任务优先级
+    port_cfg.task_priority = TaskPlanner::GetInstance().Get(kTaskRoleLvgl).priority;
+    port_cfg.task_affinity = TaskPlanner::GetInstance().Get(kTaskRoleLvgl).core;
     port_cfg.timer_period_ms = 16;    // 16ms = 62.5 FPS，支持更高帧率
     lvgl_port_init(&port_cfg);
 
@@ -127,8 +144,8 @@ SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
         },
         .color_format = LV_COLOR_FORMAT_RGB565,
         .flags = {
-            .buff_dma = 1,
-            .buff_spiram = 0,
+            .buff_dma = memory_placement_region(MEMORY_BUFFER_DISPLAY_DRAW) == MEMORY_REGION_DMA,
+            .buff_spiram = memory_placement_region(MEMORY_BUFFER_DISPLAY_DRAW) == MEMORY_REGION_PSRAM,
             .sw_rotate = 0,
             .swap_bytes = 1,
             .full_refresh = 0,
@@ -167,7 +184,8 @@ RgbLcdDisplay::RgbLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
 
     ESP_LOGI(TAG, "Initialize LVGL port");
     lvgl_port_cfg_t port_cfg = ESP_LVGL_PORT_INIT_CONFIG();
-    port_cfg.task_priority = 4;       // 提高LVGL任务优先级
+    port_cfg.task_priority = TaskPlanner::GetInstance().Get(kTaskRoleLvgl).priority;
+    port_cfg.task_affinity = TaskPlanner::GetInstance().Get(kTaskRoleLvgl).core;
     port_cfg.timer_period_ms = 16;    // 16ms = 62.5 FPS，支持更高帧率
     lvgl_port_init(&port_cfg);
 
@@ -227,7 +245,8 @@ MipiLcdDisplay::MipiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel
 
     ESP_LOGI(TAG, "Initialize LVGL port");
     lvgl_port_cfg_t port_cfg = ESP_LVGL_PORT_INIT_CONFIG();
-    port_cfg.task_priority = 4;       // 提高LVGL任务优先级
+    port_cfg.task_priority = TaskPlanner::GetInstance().Get(kTaskRoleLvgl).priority;
+    port_cfg.task_affinity = TaskPlanner::GetInstance().Get(kTaskRoleLvgl).core;
     port_cfg.timer_period_ms = 16;    // 16ms = 62.5 FPS，支持更高帧率
     lvgl_port_init(&port_cfg);
 
@@ -248,8 +267,8 @@ MipiLcdDisplay::MipiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel
             .mirror_y = mirror_y,
         },
         .flags = {
-            .buff_dma = true,
-            .buff_spiram =false,
+            .buff_dma = memory_placement_region(MEMORY_BUFFER_DISPLAY_DRAW) == MEMORY_REGION_DMA,
+            .buff_spiram = memory_placement_region(MEMORY_BUFFER_DISPLAY_DRAW) == MEMORY_REGION_PSRAM,
             .sw_rotate = false,
         },
     };
@@ -309,6 +328,9 @@ void LcdDisplay::Unlock() {
 #if CONFIG_USE_WECHAT_MESSAGE_STYLE
 void LcdDisplay::SetupUI() {
     DisplayLockGuard lock(this);
+#if CONFIG_USE_TIMELINE_TRACE
+    AddTraceEvents(display_);
+#endif
 
     auto screen = lv_screen_active();
     lv_obj_set_style_text_font(screen, fonts_.text_font, 0);
@@ -646,11 +668,7 @@ void LcdDisplay::SetPreviewImage(const lv_img_dsc_t* img_dsc) {
         copied_img_dsc->data_size = img_dsc->data_size;
         
         // Copy the image data
-        uint8_t* copied_data = (uint8_t*)heap_caps_malloc(img_dsc->data_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-        if (copied_data == nullptr) {
-            // Fallback to internal RAM if SPIRAM allocation fails
-            copied_data = (uint8_t*)heap_caps_malloc(img_dsc->data_size, MALLOC_CAP_8BIT);
-        }
+        uint8_t* copied_data = (uint8_t*)memory_placement_malloc(MEMORY_BUFFER_IMAGE, img_dsc->data_size);
         if (copied_data == nullptr) {
             ESP_LOGE(TAG, "Failed to allocate memory for image data (size: %lu bytes)", img_dsc->data_size);
             heap_caps_free(copied_img_dsc);
@@ -684,7 +702,7 @@ void LcdDisplay::SetPreviewImage(const lv_img_dsc_t* img_dsc) {
         lv_obj_add_event_cb(preview_image, [](lv_event_t* e) {
             lv_img_dsc_t* copied_img_dsc = (lv_img_dsc_t*)lv_event_get_user_data(e);
             if (copied_img_dsc != nullptr) {
-                heap_caps_free((void*)copied_img_dsc->data);
+                memory_placement_free((void*)copied_img_dsc->data);
                 heap_caps_free(copied_img_dsc);
             }
         }, LV_EVENT_DELETE, (void*)copied_img_dsc);
@@ -721,7 +739,7 @@ void LcdDisplay::SetupEyeCanvas()
     eye_animation_->setEyelidGap(0);
 
     // 创建画布缓冲区
-    eye_canvas_buf_ = heap_caps_malloc(REAL_SCREEN_WIDTH * REAL_SCREEN_HEIGHT * 2, MALLOC_CAP_SPIRAM);
+    eye_canvas_buf_ = memory_placement_malloc(MEMORY_BUFFER_EYE_CANVAS, REAL_SCREEN_WIDTH * REAL_SCREEN_HEIGHT * 2);
     if (eye_canvas_buf_ == nullptr)
     {
         ESP_LOGE(TAG, "Failed to allocate eye canvas buffer");
@@ -742,7 +760,7 @@ void LcdDisplay::SetupEyeCanvas()
     {
         ESP_LOGE(TAG, "Failed to create eye canvas");
         // free(eye_draw_buf_);
-        free(eye_canvas_buf_);
+        memory_placement_free(eye_canvas_buf_);
         return;
     }
 
@@ -794,6 +812,7 @@ void LcdDisplay::StartEyeAnimation()
     {
         // 启动定时器,33ms间隔(约30fps)
         esp_timer_start_periodic(eye_timer_, 30 * 1000); // 微秒为单位
+        FrequencyGovernor::GetInstance().SetDemand(kPowerDemandAnimation, true);
     }
 }
 
@@ -802,6 +821,7 @@ void LcdDisplay::StopEyeAnimation()
     if (eye_timer_)
     {
         esp_timer_stop(eye_timer_);
+        FrequencyGovernor::GetInstance().SetDemand(kPowerDemandAnimation, false);
     }
 }
 void LcdDisplay::changeEyeStyle()
@@ -844,6 +864,9 @@ uint8_t LcdDisplay::getCurrentEyeType()
 }
 void LcdDisplay::SetupUI() {
     DisplayLockGuard lock(this);
+#if CONFIG_USE_TIMELINE_TRACE
+    AddTraceEvents(display_);
+#endif
 
     auto screen = lv_screen_active();
     lv_obj_set_style_text_font(screen, fonts_.text_font, 0);
@@ -3,8 +3,11 @@
 #include "esp_system.h"
 #include "esp_log.h"
 #include "esp_random.h"
+#include "metrics.h"
+#include "memory_placement.h"
 #include <string.h>
 #include <algorithm> // 添加这行来使用 std::min
+#include <new>
 
 
 #define pgm_read_byte(addr) (*(const unsigned char *)(addr))
@@ -73,15 +76,21 @@ EyeAnimation::EyeAnimation()
       screen_width_(defaulteye_SCREEN_WIDTH), 
       screen_height_(defaulteye_SCREEN_HEIGHT)
 {
-    render_buffer_ = new uint16_t[screen_width_ * screen_height_];
-
-    scaled_buffer_ = new uint16_t[REAL_SCREEN_WIDTH * REAL_SCREEN_HEIGHT]; // 分配缩放后的缓冲区
+    render_buffer_ = (uint16_t*)memory_placement_malloc(MEMORY_BUFFER_EYE_FRAME, screen_width_ * screen_height_ * sizeof(uint16_t));
+
+    scaled_buffer_ = (uint16_t*)memory_placement_malloc(MEMORY_BUFFER_EYE_FRAME, REAL_SCREEN_WIDTH * REAL_SCREEN_HEIGHT * sizeof(uint16_t)); // 分配缩放后的缓冲区
+    if (render_buffer_ == nullptr || scaled_buffer_ == nullptr) {
+        // 与原来使用 new 时一样，分配失败时抛出异常
+        memory_placement_free(render_buffer_);
+        memory_placement_free(scaled_buffer_);
+        throw std::bad_alloc();
+    }
 }
 
 EyeAnimation::~EyeAnimation()
 {
-    delete[] render_buffer_;
-    delete[] scaled_buffer_;
+    memory_placement_free(render_buffer_);
+    memory_placement_free(scaled_buffer_);
 }
 
 void EyeAnimation::switchEyeType(EyeType type)
@@ -343,7 +352,7 @@ void EyeAnimation::begin()
     eyes_.push_back(eye);
 }
 
-void EyeAnimation::drawEye(uint8_t eye_index,
+void EyeAnimation::drawEye(uint8_t /* eye_index */,
                            uint32_t iScale,        // 虹膜缩放比例
                            uint32_t scleraX,       // 眼球X坐标
                            uint32_t scleraY,       // 眼球Y坐标
@@ -445,9 +454,9 @@ void EyeAnimation::update()
     static uint32_t eyeMoveStartTime = 0;
     static int32_t eyeMoveDuration = 0;
     static uint8_t currentEye = 0;
-    static uint32_t last_eye_switch = 0; // 添加眼球切换计时器
 
     // 每2秒切换一次眼球类型
+    // static uint32_t last_eye_switch = 0; // 添加眼球切换计时器
     // if (t - last_eye_switch >= 5000000)
     // { // 2000000 微秒 = 2秒
     //     current_eye_type_ = static_cast<EyeType>((static_cast<int>(current_eye_type_) + 1) % MAX_EYE_TYPE);
@@ -652,16 +661,9 @@ void EyeAnimation::update()
 
     drawEye(currentEye, iris_scale_, eyeX, eyeY, uThreshold, lThreshold);
     scaleBuffer();
-    // 添加性能测试代码
-    static uint32_t frame_count = 0;
-    static uint32_t last_fps_update = 0;
-    frame_count++;
-    if (t - last_fps_update >= 1000000)
-    { // 每秒更新一次
-        ESP_LOGI("EyeAnimation", "FPS: %ld", frame_count);
-        frame_count = 0;
-        last_fps_update = t;
-    }
+    // 帧率由指标汇总按每秒速率输出
+    static MetricCounter* frame_counter = MetricsRegistry::GetInstance().AddCounter("eye.frames");
+    frame_counter->Add();
 }
 // 添加情感控制相关函数实现
 void EyeAnimation::setEmotion(EmotionState emotion) {
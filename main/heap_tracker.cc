@@ -0,0 +1,364 @@
+#include "heap_tracker.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <esp_memory_utils.h>
+#include <esp_console.h>
+#include <cJSON.h>
+
+#include <cstring>
+
+#define TAG "HeapTracker"
+
+#define HEAP_TRACKER_TABLE_MASK (HEAP_TRACKER_TABLE_SIZE - 1)
+// 线性探测表超过 3/4 后探测变长，不再记录新的分配
+#define HEAP_TRACKER_TABLE_LIMIT (HEAP_TRACKER_TABLE_SIZE * 3 / 4)
+#define HEAP_TRACKER_MAX_SIZE 0x7FFFFF
+// 槽位 0 由 pthread 使用，标签缓存放在最后一个槽位，值为 tag + 1，0 表示尚未按任务名解析
+#define HEAP_TRACKER_TLS_INDEX (CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS - 1)
+
+static const char* const kHeapTagNames[kHeapTagCount] = {
+    "other", "main", "audio", "network", "json", "display", "mjpeg", "camera", "mcp",
+};
+
+// 按任务名前缀归类，未列出的任务 (IDF 内部任务等) 记为 other
+static const struct {
+    const char* prefix;
+    HeapTag tag;
+} kTaskTags[] = {
+    { "main", kHeapTagMain },
+    { "audio_", kHeapTagAudio },
+    { "opus_codec", kHeapTagAudio },
+    { "encode_detect", kHeapTagAudio },
+    { "tiT", kHeapTagNetwork },
+    { "wifi", kHeapTagNetwork },
+    { "udp_send", kHeapTagNetwork },
+    { "channel_open", kHeapTagNetwork },
+    { "path_monitor", kHeapTagNetwork },
+    { "taskLVGL", kHeapTagDisplay },
+    { "video task", kHeapTagDisplay },
+    { "mjpeg_player", kHeapTagMjpeg },
+    { "posture", kHeapTagCamera },
+    { "cam", kHeapTagCamera },
+    { "tool_call", kHeapTagMcp },
+};
+
+static const struct {
+    const char* name;
+    uint32_t caps;
+} kHeapCaps[] = {
+    { "internal", MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT },
+    { "dma", MALLOC_CAP_DMA },
+    { "spiram", MALLOC_CAP_SPIRAM },
+};
+
+// 钩子在 Start 之前就会被调用，不能依赖 GetInstance 中静态变量的初始化
+static HeapTracker* s_tracker = nullptr;
+
+#if CONFIG_USE_HEAP_TRACKER
+extern "C" void IRAM_ATTR esp_heap_trace_alloc_hook(void* ptr, size_t size, uint32_t caps) {
+    if (s_tracker != nullptr) {
+        s_tracker->OnAlloc(ptr, size);
+    }
+}
+
+extern "C" void IRAM_ATTR esp_heap_trace_free_hook(void* ptr) {
+    if (s_tracker != nullptr) {
+        s_tracker->OnFree(ptr);
+    }
+}
+#endif
+
+HeapTagScope::HeapTagScope(HeapTag tag) {
+    if (s_tracker == nullptr) {
+        return;
+    }
+    active_ = true;
+    previous_ = pvTaskGetThreadLocalStoragePointer(nullptr, HEAP_TRACKER_TLS_INDEX);
+    vTaskSetThreadLocalStoragePointer(nullptr, HEAP_TRACKER_TLS_INDEX, (void*)(uintptr_t)(tag + 1));
+}
+
+HeapTagScope::~HeapTagScope() {
+    if (active_) {
+        vTaskSetThreadLocalStoragePointer(nullptr, HEAP_TRACKER_TLS_INDEX, previous_);
+    }
+}
+
+void HeapTracker::Start() {
+    if (s_tracker != nullptr) {
+        return;
+    }
+
+    // 钩子可能在关闭缓存时被调用，追踪表必须在内部 SRAM
+    table_ = (Entry*)heap_caps_calloc(HEAP_TRACKER_TABLE_SIZE, sizeof(Entry), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (table_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate tracking table");
+        return;
+    }
+    ESP_LOGI(TAG, "Tracking allocations, table uses %u bytes", (unsigned)(HEAP_TRACKER_TABLE_SIZE * sizeof(Entry)));
+
+    heap_caps_register_failed_alloc_callback([](size_t size, uint32_t caps, const char* function_name) {
+        HeapTracker::GetInstance().OnAllocFailed(size, caps);
+    });
+
+    last_snapshot_time_us_ = esp_timer_get_time();
+    s_tracker = this;
+    RegisterConsoleCommand();
+}
+
+HeapTag IRAM_ATTR HeapTracker::CurrentTag() {
+    if (xPortInIsrContext()) {
+        return kHeapTagOther;
+    }
+    uintptr_t cached = (uintptr_t)pvTaskGetThreadLocalStoragePointer(nullptr, HEAP_TRACKER_TLS_INDEX);
+    if (cached != 0) {
+        return (HeapTag)(cached - 1);
+    }
+
+    // 每个任务只在第一次分配时按任务名匹配一次
+    HeapTag tag = kHeapTagOther;
+    const char* name = pcTaskGetName(nullptr);
+    for (auto& task_tag : kTaskTags) {
+        if (strncmp(name, task_tag.prefix, strlen(task_tag.prefix)) == 0) {
+            tag = task_tag.tag;
+            break;
+        }
+    }
+    vTaskSetThreadLocalStoragePointer(nullptr, HEAP_TRACKER_TLS_INDEX, (void*)(uintptr_t)(tag + 1));
+    return tag;
+}
+
+uint32_t IRAM_ATTR HeapTracker::Slot(void* ptr) const {
+    return (((uint32_t)(uintptr_t)ptr >> 2) * 2654435761u) & HEAP_TRACKER_TABLE_MASK;
+}
+
+void IRAM_ATTR HeapTracker::OnAlloc(void* ptr, size_t size) {
+    if (ptr == nullptr || table_ == nullptr) {
+        return;
+    }
+    uint32_t stored_size = size > HEAP_TRACKER_MAX_SIZE ? HEAP_TRACKER_MAX_SIZE : size;
+    bool spiram = esp_ptr_external_ram(ptr);
+    HeapTag tag = CurrentTag();
+
+    portENTER_CRITICAL_SAFE(&lock_);
+    auto& stats = stats_[tag];
+    stats.allocs++;
+    stats.alloc_bytes += size;
+    if (table_count_ >= HEAP_TRACKER_TABLE_LIMIT) {
+        untracked_allocs_++;
+        portEXIT_CRITICAL_SAFE(&lock_);
+        return;
+    }
+
+    uint32_t i = Slot(ptr);
+    while (table_[i].ptr != nullptr) {
+        i = (i + 1) & HEAP_TRACKER_TABLE_MASK;
+    }
+    table_[i].ptr = ptr;
+    table_[i].size = stored_size;
+    table_[i].spiram = spiram;
+    table_[i].tag = tag;
+    table_count_++;
+
+    stats.live_blocks++;
+    if (spiram) {
+        stats.live_spiram += stored_size;
+    } else {
+        stats.live_internal += stored_size;
+        if (stats.live_internal > stats.peak_internal) {
+            stats.peak_internal = stats.live_internal;
+        }
+    }
+    portEXIT_CRITICAL_SAFE(&lock_);
+}
+
+void IRAM_ATTR HeapTracker::OnFree(void* ptr) {
+    if (ptr == nullptr || table_ == nullptr) {
+        return;
+    }
+
+    portENTER_CRITICAL_SAFE(&lock_);
+    uint32_t i = Slot(ptr);
+    while (table_[i].ptr != ptr) {
+        if (table_[i].ptr == nullptr) {
+            // Allocated before Start or while the table was full
+            portEXIT_CRITICAL_SAFE(&lock_);
+            return;
+        }
+        i = (i + 1) & HEAP_TRACKER_TABLE_MASK;
+    }
+
+    auto& stats = stats_[table_[i].tag];
+    stats.live_blocks--;
+    if (table_[i].spiram) {
+        stats.live_spiram -= table_[i].size;
+    } else {
+        stats.live_internal -= table_[i].size;
+    }
+    table_count_--;
+
+    // 线性探测的删除：把后面同一探测链上的条目前移，不需要墓碑
+    uint32_t j = i;
+    while (true) {
+        j = (j + 1) & HEAP_TRACKER_TABLE_MASK;
+        if (table_[j].ptr == nullptr) {
+            break;
+        }
+        uint32_t home = Slot(table_[j].ptr);
+        bool stays = i <= j ? (home > i && home <= j) : (home > i || home <= j);
+        if (!stays) {
+            table_[i] = table_[j];
+            i = j;
+        }
+    }
+    table_[i].ptr = nullptr;
+    portEXIT_CRITICAL_SAFE(&lock_);
+}
+
+// 可能在中断中调用，只记录，由 CheckLowMemory 打印
+void HeapTracker::OnAllocFailed(size_t size, uint32_t caps) {
+    last_failed_size_ = size;
+    last_failed_caps_ = caps;
+    failed_allocs_++;
+}
+
+void HeapTracker::CheckLowMemory() {
+    uint32_t failed_allocs = failed_allocs_.load();
+    if (failed_allocs != reported_failed_allocs_) {
+        ESP_LOGW(TAG, "%lu allocation(s) failed, last %lu bytes caps 0x%lx", failed_allocs - reported_failed_allocs_,
+            last_failed_size_, last_failed_caps_);
+        reported_failed_allocs_ = failed_allocs;
+        PrintSnapshot();
+        return;
+    }
+
+    // 低于阈值时打印一次，恢复到阈值的 1.5 倍以上后重新触发
+    size_t free_sram = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    size_t threshold = CONFIG_HEAP_TRACKER_LOW_MEMORY_KB * 1024;
+    if (!low_memory_reported_ && free_sram < threshold) {
+        ESP_LOGW(TAG, "Low internal memory: %u bytes free", (unsigned)free_sram);
+        low_memory_reported_ = true;
+        PrintSnapshot();
+    } else if (low_memory_reported_ && free_sram > threshold * 3 / 2) {
+        low_memory_reported_ = false;
+    }
+}
+
+void HeapTracker::TakeSnapshot(Snapshot& snapshot) {
+    portENTER_CRITICAL(&lock_);
+    memcpy(snapshot.tags, stats_, sizeof(stats_));
+    snapshot.tracked_blocks = table_count_;
+    snapshot.untracked_allocs = untracked_allocs_;
+    portEXIT_CRITICAL(&lock_);
+
+    int64_t now = esp_timer_get_time();
+    uint32_t elapsed_ms = (now - last_snapshot_time_us_) / 1000;
+    last_snapshot_time_us_ = now;
+    for (int i = 0; i < kHeapTagCount; i++) {
+        auto& stats = snapshot.tags[i];
+        snapshot.allocs_per_s[i] = elapsed_ms > 0 ? (uint64_t)(stats.allocs - last_allocs_[i]) * 1000 / elapsed_ms : 0;
+        snapshot.bytes_per_s[i] = elapsed_ms > 0 ? (uint64_t)(stats.alloc_bytes - last_alloc_bytes_[i]) * 1000 / elapsed_ms : 0;
+        last_allocs_[i] = stats.allocs;
+        last_alloc_bytes_[i] = stats.alloc_bytes;
+    }
+}
+
+void HeapTracker::PrintSnapshot() {
+    for (auto& heap : kHeapCaps) {
+        multi_heap_info_t info;
+        heap_caps_get_info(&info, heap.caps);
+        if (info.total_free_bytes + info.total_allocated_bytes == 0) {
+            continue;
+        }
+        uint32_t fragmentation = info.total_free_bytes > 0 ? 100 - info.largest_free_block * 100 / info.total_free_bytes : 0;
+        ESP_LOGI(TAG, "%-8s free=%u largest=%u frag=%lu%% min_free=%u blocks=%u", heap.name,
+            (unsigned)info.total_free_bytes, (unsigned)info.largest_free_block, fragmentation,
+            (unsigned)info.minimum_free_bytes, (unsigned)info.free_blocks);
+    }
+
+    if (table_ == nullptr) {
+        return;
+    }
+    Snapshot snapshot;
+    TakeSnapshot(snapshot);
+    for (int i = 0; i < kHeapTagCount; i++) {
+        auto& stats = snapshot.tags[i];
+        if (stats.allocs == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "%-8s live=%lu psram=%lu peak=%lu blocks=%lu rate=%lu/s %lu B/s", kHeapTagNames[i],
+            stats.live_internal, stats.live_spiram, stats.peak_internal, stats.live_blocks,
+            snapshot.allocs_per_s[i], snapshot.bytes_per_s[i]);
+    }
+    ESP_LOGI(TAG, "tracked=%lu untracked=%lu failed=%lu", snapshot.tracked_blocks, snapshot.untracked_allocs,
+        failed_allocs_.load());
+}
+
+std::string HeapTracker::GetSnapshotJson() {
+    cJSON* root = cJSON_CreateObject();
+    cJSON* heaps = cJSON_CreateArray();
+    for (auto& heap : kHeapCaps) {
+        multi_heap_info_t info;
+        heap_caps_get_info(&info, heap.caps);
+        if (info.total_free_bytes + info.total_allocated_bytes == 0) {
+            continue;
+        }
+        cJSON* item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "caps", heap.name);
+        cJSON_AddNumberToObject(item, "free", info.total_free_bytes);
+        cJSON_AddNumberToObject(item, "largest_free_block", info.largest_free_block);
+        cJSON_AddNumberToObject(item, "min_free", info.minimum_free_bytes);
+        cJSON_AddNumberToObject(item, "fragmentation_percent", info.total_free_bytes > 0 ?
+            100 - info.largest_free_block * 100 / info.total_free_bytes : 0);
+        cJSON_AddItemToArray(heaps, item);
+    }
+    cJSON_AddItemToObject(root, "heaps", heaps);
+
+    if (table_ != nullptr) {
+        Snapshot snapshot;
+        TakeSnapshot(snapshot);
+        cJSON* tags = cJSON_CreateArray();
+        for (int i = 0; i < kHeapTagCount; i++) {
+            auto& stats = snapshot.tags[i];
+            if (stats.allocs == 0) {
+                continue;
+            }
+            cJSON* item = cJSON_CreateObject();
+            cJSON_AddStringToObject(item, "tag", kHeapTagNames[i]);
+            cJSON_AddNumberToObject(item, "live_internal", stats.live_internal);
+            cJSON_AddNumberToObject(item, "live_spiram", stats.live_spiram);
+            cJSON_AddNumberToObject(item, "peak_internal", stats.peak_internal);
+            cJSON_AddNumberToObject(item, "live_blocks", stats.live_blocks);
+            cJSON_AddNumberToObject(item, "allocs_per_s", snapshot.allocs_per_s[i]);
+            cJSON_AddNumberToObject(item, "bytes_per_s", snapshot.bytes_per_s[i]);
+            cJSON_AddItemToArray(tags, item);
+        }
+        cJSON_AddItemToObject(root, "tags", tags);
+        cJSON_AddNumberToObject(root, "untracked_allocs", snapshot.untracked_allocs);
+    }
+    cJSON_AddNumberToObject(root, "failed_allocs", failed_allocs_.load());
+
+    char* json = cJSON_PrintUnformatted(root);
+    std::string result(json);
+    cJSON_free(json);
+    cJSON_Delete(root);
+    return result;
+}
+
+void HeapTracker::RegisterConsoleCommand() {
+    const esp_console_cmd_t cmd = {
+        .command = "heap",
+        .help = "Print heap fragmentation and live bytes of each subsystem",
+        .hint = nullptr,
+        .func = [](int argc, char** argv) -> int {
+            HeapTracker::GetInstance().PrintSnapshot();
+            return 0;
+        },
+        .argtable = nullptr,
+    };
+    esp_err_t ret = esp_console_cmd_register(&cmd);
+    if (ret != ESP_OK) {
+        ESP_LOGD(TAG, "Console is not available: %s", esp_err_to_name(ret));
+    }
+}
@@ -0,0 +1,120 @@
+#ifndef HEAP_TRACKER_H
+#define HEAP_TRACKER_H
+
+#include <string>
+#include <atomic>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+/*
+ * 内存分配追踪，需要开启 CONFIG_HEAP_USE_HOOKS。
+ *
+ * - 通过 IDF 的分配钩子记录每个分配的大小和子系统标签，按标签统计当前占用 (内部 SRAM / PSRAM)、
+ *   峰值和分配速率。标签默认由分配所在的任务名决定，共用任务中的代码可以用 HeapTagScope 临时指定。
+ *   当前标签缓存在任务的线程局部存储中 (最后一个槽位)，钩子中只读一次指针，任务名只在第一次分配时匹配。
+ * - 各类内存 (内部、DMA、PSRAM) 的剩余、最大空闲块和碎片率。
+ * - 快照可以通过 MCP 工具 self.system.get_heap、串口命令 heap 获取，
+ *   内部 SRAM 低于 CONFIG_HEAP_TRACKER_LOW_MEMORY_KB 或出现分配失败时自动打印。
+ *
+ * 追踪表固定放在内部 SRAM，表满后的分配不再记录 (计入 untracked)，Start 之前的分配也不记录。
+ */
+#define HEAP_TRACKER_TABLE_SIZE 2048
+
+enum HeapTag : uint8_t {
+    kHeapTagOther,
+    kHeapTagMain,
+    kHeapTagAudio,
+    kHeapTagNetwork,
+    kHeapTagJson,
+    kHeapTagDisplay,
+    kHeapTagMjpeg,
+    kHeapTagCamera,
+    kHeapTagMcp,
+    kHeapTagCount
+};
+
+struct HeapTagStats {
+    uint32_t live_internal = 0;
+    uint32_t live_spiram = 0;
+    uint32_t peak_internal = 0;
+    uint32_t live_blocks = 0;
+    uint32_t allocs = 0;            // 累计分配次数
+    uint32_t alloc_bytes = 0;       // 累计分配字节数
+};
+
+// 在当前任务内临时把分配归到指定标签，离开作用域后恢复
+class HeapTagScope {
+public:
+    explicit HeapTagScope(HeapTag tag);
+    ~HeapTagScope();
+    HeapTagScope(const HeapTagScope&) = delete;
+    HeapTagScope& operator=(const HeapTagScope&) = delete;
+
+private:
+    bool active_ = false;           // 追踪未启动时什么也不做
+    void* previous_ = nullptr;      // 外层缓存的标签，离开时原样写回
+};
+
+class HeapTracker {
+public:
+    static HeapTracker& GetInstance() {
+        static HeapTracker instance;
+        return instance;
+    }
+    HeapTracker(const HeapTracker&) = delete;
+    HeapTracker& operator=(const HeapTracker&) = delete;
+
+    void Start();
+    // 每 10 秒由时钟定时器调用，内存不足或有分配失败时打印快照
+    void CheckLowMemory();
+    void PrintSnapshot();
+    std::string GetSnapshotJson();
+
+    // 以下由分配钩子调用，可能处于中断上下文
+    void OnAlloc(void* ptr, size_t size);
+    void OnFree(void* ptr);
+    void OnAllocFailed(size_t size, uint32_t caps);
+
+private:
+    struct Entry {
+        void* ptr;
+        uint32_t size : 23;
+        uint32_t spiram : 1;
+        uint32_t tag : 8;
+    };
+
+    struct Snapshot {
+        HeapTagStats tags[kHeapTagCount];
+        uint32_t tracked_blocks;
+        uint32_t untracked_allocs;
+        uint32_t allocs_per_s[kHeapTagCount];
+        uint32_t bytes_per_s[kHeapTagCount];
+    };
+
+    HeapTracker() = default;
+
+    portMUX_TYPE lock_ = portMUX_INITIALIZER_UNLOCKED;
+    Entry* table_ = nullptr;
+    uint32_t table_count_ = 0;
+    uint32_t untracked_allocs_ = 0;
+    HeapTagStats stats_[kHeapTagCount];
+
+    std::atomic<uint32_t> failed_allocs_ = 0;
+    volatile uint32_t last_failed_size_ = 0;
+    volatile uint32_t last_failed_caps_ = 0;
+    uint32_t reported_failed_allocs_ = 0;
+    bool low_memory_reported_ = false;
+
+    // 用于计算分配速率
+    uint32_t last_allocs_[kHeapTagCount] = {};
+    uint32_t last_alloc_bytes_[kHeapTagCount] = {};
+    int64_t last_snapshot_time_us_ = 0;
+
+    HeapTag CurrentTag();
+    uint32_t Slot(void* ptr) const;
+    void TakeSnapshot(Snapshot& snapshot);
+    void RegisterConsoleCommand();
+};
+
+#endif // HEAP_TRACKER_H
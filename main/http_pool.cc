@@ -0,0 +1,570 @@
+#include "http_pool.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#define TAG "HttpPool"
+
+// 服务器通常在 60 秒左右关闭空闲连接，提前放弃以免复用到已被关闭的连接
+#define HTTP_POOL_IDLE_TIMEOUT_MS 30000
+#define HTTP_POOL_DEFAULT_TIMEOUT_MS 30000
+// 接收回调不能阻塞，读取方跟不上时先缓存，超过该大小则放弃本次请求，避免下载固件时占满内存
+#define HTTP_POOL_RX_BUFFER_LIMIT (64 * 1024)
+
+// 一条 TCP/TLS 连接，接收回调只访问本结构，连接可以在请求之间转交
+struct HttpConnection {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::string rx;
+    bool in_use = true;
+    bool disconnected = false;
+    bool stale = false;             // 空闲期间收到数据，连接状态未知
+    bool overflowed = false;        // 接收缓存超过上限，数据已丢失
+    size_t received = 0;            // 当前请求收到的字节数，用于判断能否重发
+    int64_t idle_since_us = 0;
+    std::unique_ptr<Tcp> tcp;       // 最后声明，最先销毁，之后不会再有回调
+};
+
+static void DiscardConnection(std::unique_ptr<HttpConnection> connection) {
+    if (connection == nullptr) {
+        return;
+    }
+    {
+        // 之后收到的数据只标记 stale，不再缓存
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        connection->in_use = false;
+    }
+    connection->tcp->Disconnect();
+}
+
+static std::string ToLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::tolower(c); });
+    return text;
+}
+
+class PooledHttp : public Http {
+public:
+    PooledHttp(NetworkInterface* network, int connect_id) : network_(network), connect_id_(connect_id) {
+    }
+
+    ~PooledHttp() {
+        Close();
+    }
+
+    void SetTimeout(int timeout_ms) override {
+        timeout_ms_ = timeout_ms;
+    }
+
+    void SetHeader(const std::string& key, const std::string& value) override {
+        headers_[key] = value;
+    }
+
+    void SetContent(std::string&& content) override {
+        content_ = std::move(content);
+    }
+
+    bool Open(const std::string& method, const std::string& url) override {
+        Close();
+        if (!ParseUrl(url)) {
+            ESP_LOGE(TAG, "Invalid URL: %s", url.c_str());
+            return false;
+        }
+        method_ = method;
+        request_chunked_ = false;
+        for (auto& header : headers_) {
+            if (ToLower(header.first) == "transfer-encoding" && ToLower(header.second).find("chunked") != std::string::npos) {
+                request_chunked_ = true;
+            }
+        }
+
+        auto connection = HttpPool::GetInstance().Acquire(key_);
+        bool reused = connection != nullptr;
+        bool retry = false;
+        bool opened = OpenOn(std::move(connection), reused, retry);
+        if (!opened && retry) {
+            // The server closed the idle connection before answering, the request was not processed
+            ESP_LOGW(TAG, "Reused connection to %s was closed, reconnecting", key_.c_str());
+            opened = OpenOn(nullptr, false, retry);
+        }
+        return opened;
+    }
+
+    void Close() override {
+        if (connection_ == nullptr) {
+            return;
+        }
+        bool reusable = body_complete_ && keep_alive_ && (!request_chunked_ || request_done_);
+        if (reusable) {
+            std::lock_guard<std::mutex> lock(connection_->mutex);
+            // 响应之后多出的数据说明双方对报文边界的理解不一致，不能复用
+            reusable = !connection_->disconnected && !connection_->overflowed && connection_->rx.empty();
+            connection_->in_use = false;
+        }
+        if (reusable) {
+            HttpPool::GetInstance().Release(key_, std::move(connection_));
+        } else {
+            DiscardConnection(std::move(connection_));
+        }
+    }
+
+    int Read(char* buffer, size_t buffer_size) override {
+        if (connection_ == nullptr || (!headers_received_ && !ReadResponseHead())) {
+            return -1;
+        }
+        if (body_complete_) {
+            return 0;
+        }
+
+        auto& rx = connection_->rx;
+        std::unique_lock<std::mutex> lock(connection_->mutex);
+        if (body_mode_ == kBodyChunked && chunk_remaining_ == 0) {
+            if (!ReadChunkHeader(lock)) {
+                return -1;
+            }
+            if (body_complete_) {
+                return 0;
+            }
+        }
+        if (!Wait(lock, [&rx]() { return !rx.empty(); })) {
+            if (body_mode_ == kBodyUntilClose && connection_->disconnected && !connection_->overflowed) {
+                body_complete_ = true;
+                return 0;
+            }
+            return -1;
+        }
+
+        size_t length = std::min(buffer_size, rx.size());
+        if (body_mode_ == kBodyLength) {
+            length = std::min(length, body_remaining_);
+        } else if (body_mode_ == kBodyChunked) {
+            length = std::min(length, chunk_remaining_);
+        }
+        memcpy(buffer, rx.data(), length);
+        rx.erase(0, length);
+
+        if (body_mode_ == kBodyLength) {
+            body_remaining_ -= length;
+            body_complete_ = body_remaining_ == 0;
+        } else if (body_mode_ == kBodyChunked) {
+            chunk_remaining_ -= length;
+        }
+        return length;
+    }
+
+    int Write(const char* buffer, size_t buffer_size) override {
+        if (connection_ == nullptr || request_done_) {
+            return -1;
+        }
+        if (!request_chunked_) {
+            return Send(std::string(buffer, buffer_size)) ? buffer_size : -1;
+        }
+        if (buffer_size == 0) {
+            request_done_ = true;
+            return Send("0\r\n\r\n") ? 0 : -1;
+        }
+        char size_line[16];
+        snprintf(size_line, sizeof(size_line), "%x\r\n", (unsigned)buffer_size);
+        std::string chunk;
+        chunk.reserve(strlen(size_line) + buffer_size + 2);
+        chunk.append(size_line);
+        chunk.append(buffer, buffer_size);
+        chunk.append("\r\n");
+        return Send(chunk) ? buffer_size : -1;
+    }
+
+    int GetStatusCode() override {
+        if (connection_ != nullptr && !headers_received_) {
+            ReadResponseHead();
+        }
+        return status_code_;
+    }
+
+    std::string GetResponseHeader(const std::string& key) const override {
+        auto it = response_headers_.find(ToLower(key));
+        return it != response_headers_.end() ? it->second : "";
+    }
+
+    size_t GetBodyLength() override {
+        if (connection_ != nullptr && !headers_received_) {
+            ReadResponseHead();
+        }
+        return content_length_;
+    }
+
+    std::string ReadAll() override {
+        std::string body;
+        body.reserve(content_length_);
+        char buffer[512];
+        while (true) {
+            int ret = Read(buffer, sizeof(buffer));
+            if (ret <= 0) {
+                break;
+            }
+            body.append(buffer, ret);
+        }
+        return body;
+    }
+
+private:
+    enum BodyMode {
+        kBodyLength,
+        kBodyChunked,
+        kBodyUntilClose,
+    };
+
+    NetworkInterface* network_;
+    int connect_id_;
+    int timeout_ms_ = HTTP_POOL_DEFAULT_TIMEOUT_MS;
+    std::map<std::string, std::string> headers_;
+    std::string content_;
+
+    // 当前请求
+    std::string method_;
+    bool ssl_ = false;
+    std::string host_;
+    std::string host_header_;
+    int port_ = 0;
+    std::string path_;
+    std::string key_;
+    std::unique_ptr<HttpConnection> connection_;
+    bool request_chunked_ = false;
+    bool request_done_ = false;
+
+    // 当前响应
+    int status_code_ = -1;
+    std::map<std::string, std::string> response_headers_;    // 键为小写
+    bool headers_received_ = false;
+    bool keep_alive_ = false;
+    BodyMode body_mode_ = kBodyLength;
+    size_t content_length_ = 0;
+    size_t body_remaining_ = 0;
+    size_t chunk_remaining_ = 0;
+    bool chunk_crlf_pending_ = false;
+    bool body_complete_ = false;
+
+    // scheme://host[:port][/path], connections are only shared by the same connect id
+    bool ParseUrl(const std::string& url) {
+        size_t scheme_end = url.find("://");
+        if (scheme_end == std::string::npos) {
+            return false;
+        }
+        std::string scheme = ToLower(url.substr(0, scheme_end));
+        if (scheme != "http" && scheme != "https") {
+            return false;
+        }
+        ssl_ = scheme == "https";
+        size_t host_start = scheme_end + 3;
+        size_t path_start = url.find('/', host_start);
+        host_header_ = url.substr(host_start, path_start == std::string::npos ? std::string::npos : path_start - host_start);
+        path_ = path_start == std::string::npos ? "/" : url.substr(path_start);
+        size_t colon = host_header_.find(':');
+        host_ = host_header_.substr(0, colon);
+        port_ = colon == std::string::npos ? (ssl_ ? 443 : 80) : atoi(host_header_.c_str() + colon + 1);
+        if (host_.empty() || port_ <= 0) {
+            return false;
+        }
+        key_ = std::to_string(connect_id_) + "|" + scheme + "://" + host_ + ":" + std::to_string(port_);
+        return true;
+    }
+
+    std::unique_ptr<HttpConnection> Connect() {
+        auto connection = std::make_unique<HttpConnection>();
+        connection->tcp = ssl_ ? network_->CreateSsl(connect_id_) : network_->CreateTcp(connect_id_);
+        if (connection->tcp == nullptr) {
+            return nullptr;
+        }
+        auto raw = connection.get();
+        connection->tcp->OnStream([raw](const std::string& data) {
+            std::unique_lock<std::mutex> lock(raw->mutex);
+            if (!raw->in_use) {
+                raw->stale = true;
+                return;
+            }
+            raw->received += data.size();
+            if (raw->overflowed || raw->rx.size() + data.size() > HTTP_POOL_RX_BUFFER_LIMIT) {
+                raw->overflowed = true;
+                raw->rx.clear();
+            } else {
+                raw->rx.append(data);
+            }
+            raw->cv.notify_all();
+        });
+        connection->tcp->OnDisconnected([raw]() {
+            std::lock_guard<std::mutex> lock(raw->mutex);
+            raw->disconnected = true;
+            raw->cv.notify_all();
+        });
+        if (!connection->tcp->Connect(host_, port_)) {
+            DiscardConnection(std::move(connection));
+            return nullptr;
+        }
+        return connection;
+    }
+
+    // retry 返回 true 表示复用的连接在收到任何响应数据之前就断开了，服务器没有处理请求，可以换新连接重发
+    bool OpenOn(std::unique_ptr<HttpConnection> connection, bool reused, bool& retry) {
+        int64_t start_time = esp_timer_get_time();
+        status_code_ = -1;
+        response_headers_.clear();
+        headers_received_ = false;
+        keep_alive_ = false;
+        content_length_ = 0;
+        body_remaining_ = 0;
+        chunk_remaining_ = 0;
+        chunk_crlf_pending_ = false;
+        body_complete_ = false;
+        request_done_ = false;
+
+        retry = false;
+        connection_ = connection != nullptr ? std::move(connection) : Connect();
+        if (connection_ != nullptr) {
+            std::lock_guard<std::mutex> lock(connection_->mutex);
+            connection_->received = 0;
+        }
+        // 分块上传时请求体由 Write 发送，响应头在 GetStatusCode 时读取
+        bool opened = connection_ != nullptr && SendRequestHead() && (request_chunked_ || ReadResponseHead());
+        if (!opened && connection_ != nullptr) {
+            if (reused) {
+                // 超时 (连接仍在) 或已收到部分响应时服务器可能已经处理了请求，不能重发
+                std::lock_guard<std::mutex> lock(connection_->mutex);
+                retry = connection_->disconnected && connection_->received == 0;
+            }
+            DiscardConnection(std::move(connection_));
+        }
+
+        int open_ms = (esp_timer_get_time() - start_time) / 1000;
+        HttpPool::GetInstance().RecordOpen(key_, reused, opened, open_ms);
+        ESP_LOGI(TAG, "%s %s: %s connection, open %d ms%s", method_.c_str(), key_.c_str(),
+            reused ? "reused" : "new", open_ms, opened ? "" : " (failed)");
+        return opened;
+    }
+
+    bool Send(const std::string& data) {
+        return connection_->tcp->Send(data) > 0;
+    }
+
+    bool SendRequestHead() {
+        std::string request;
+        request.reserve(256 + (request_chunked_ ? 0 : content_.size()));
+        request += method_ + " " + path_ + " HTTP/1.1\r\n";
+        request += "Host: " + host_header_ + "\r\n";
+        for (auto& header : headers_) {
+            request += header.first + ": " + header.second + "\r\n";
+        }
+        if (!request_chunked_ && (!content_.empty() || method_ == "POST" || method_ == "PUT")) {
+            request += "Content-Length: " + std::to_string(content_.size()) + "\r\n";
+        }
+        request += "\r\n";
+        if (!request_chunked_) {
+            // Keep the content, it is needed again if the reused connection fails
+            request += content_;
+        }
+        return Send(request);
+    }
+
+    // 等待 ready 成立，超时或连接断开时返回 false，调用时需持有连接的锁
+    template <typename Predicate>
+    bool Wait(std::unique_lock<std::mutex>& lock, Predicate ready) {
+        auto connection = connection_.get();
+        connection->cv.wait_for(lock, std::chrono::milliseconds(timeout_ms_), [connection, &ready]() {
+            return ready() || connection->disconnected || connection->overflowed;
+        });
+        if (connection->overflowed) {
+            ESP_LOGE(TAG, "Receive buffer of %s overflowed", key_.c_str());
+            return false;
+        }
+        return ready();
+    }
+
+    bool ReadResponseHead() {
+        auto& rx = connection_->rx;
+        std::unique_lock<std::mutex> lock(connection_->mutex);
+        std::string head;
+        do {
+            size_t head_end = std::string::npos;
+            if (!Wait(lock, [&rx, &head_end]() { return (head_end = rx.find("\r\n\r\n")) != std::string::npos; })) {
+                ESP_LOGE(TAG, "Failed to read response from %s", key_.c_str());
+                return false;
+            }
+            head = rx.substr(0, head_end);
+            rx.erase(0, head_end + 4);
+            // HTTP/1.1 200 OK
+            size_t code_start = head.find(' ');
+            status_code_ = code_start == std::string::npos ? -1 : atoi(head.c_str() + code_start + 1);
+        } while (status_code_ == 100);
+        lock.unlock();
+
+        keep_alive_ = head.compare(0, 8, "HTTP/1.1") == 0;
+        size_t line_start = head.find("\r\n");
+        while (line_start != std::string::npos) {
+            line_start += 2;
+            size_t line_end = head.find("\r\n", line_start);
+            std::string line = head.substr(line_start, line_end == std::string::npos ? std::string::npos : line_end - line_start);
+            size_t colon = line.find(':');
+            if (colon != std::string::npos) {
+                size_t value_start = line.find_first_not_of(' ', colon + 1);
+                response_headers_[ToLower(line.substr(0, colon))] = value_start == std::string::npos ? "" : line.substr(value_start);
+            }
+            line_start = line_end;
+        }
+        headers_received_ = true;
+
+        if (ToLower(GetResponseHeader("Connection")) == "close") {
+            keep_alive_ = false;
+        }
+        auto content_length = GetResponseHeader("Content-Length");
+        if (ToLower(GetResponseHeader("Transfer-Encoding")).find("chunked") != std::string::npos) {
+            body_mode_ = kBodyChunked;
+        } else if (!content_length.empty()) {
+            body_mode_ = kBodyLength;
+            content_length_ = strtoul(content_length.c_str(), nullptr, 10);
+            body_remaining_ = content_length_;
+        } else if (method_ == "HEAD" || status_code_ == 204 || status_code_ == 304) {
+            body_mode_ = kBodyLength;
+        } else {
+            body_mode_ = kBodyUntilClose;
+            keep_alive_ = false;
+        }
+        body_complete_ = body_mode_ == kBodyLength && body_remaining_ == 0;
+        return true;
+    }
+
+    // 读取下一块的长度行，最后一块之后读完 trailer，调用时需持有连接的锁
+    bool ReadChunkHeader(std::unique_lock<std::mutex>& lock) {
+        auto& rx = connection_->rx;
+        if (chunk_crlf_pending_) {
+            if (!Wait(lock, [&rx]() { return rx.size() >= 2; })) {
+                return false;
+            }
+            rx.erase(0, 2);
+            chunk_crlf_pending_ = false;
+        }
+
+        size_t line_end = std::string::npos;
+        if (!Wait(lock, [&rx, &line_end]() { return (line_end = rx.find("\r\n")) != std::string::npos; })) {
+            return false;
+        }
+        chunk_remaining_ = strtoul(rx.c_str(), nullptr, 16);
+        rx.erase(0, line_end + 2);
+        chunk_crlf_pending_ = chunk_remaining_ > 0;
+
+        while (chunk_remaining_ == 0) {
+            if (!Wait(lock, [&rx, &line_end]() { return (line_end = rx.find("\r\n")) != std::string::npos; })) {
+                return false;
+            }
+            rx.erase(0, line_end + 2);
+            if (line_end == 0) {
+                body_complete_ = true;
+                break;
+            }
+        }
+        return true;
+    }
+};
+
+HttpPool::HttpPool() {
+}
+
+HttpPool::~HttpPool() {
+    Clear();
+}
+
+std::unique_ptr<Http> HttpPool::CreateHttp(NetworkInterface* network, int connect_id) {
+    return std::make_unique<PooledHttp>(network, connect_id);
+}
+
+std::unique_ptr<Http> PooledNetwork::CreateHttp(int connect_id) {
+    return HttpPool::GetInstance().CreateHttp(network_, connect_id);
+}
+
+std::unique_ptr<HttpConnection> HttpPool::Acquire(const std::string& key) {
+    std::unique_ptr<HttpConnection> connection;
+    std::vector<std::unique_ptr<HttpConnection>> expired;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int64_t now = esp_timer_get_time();
+        for (auto it = idle_.begin(); it != idle_.end();) {
+            if (now - it->second->idle_since_us > HTTP_POOL_IDLE_TIMEOUT_MS * 1000LL) {
+                expired.push_back(std::move(it->second));
+                it = idle_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        auto it = idle_.find(key);
+        if (it != idle_.end()) {
+            connection = std::move(it->second);
+            idle_.erase(it);
+        }
+    }
+    for (auto& item : expired) {
+        DiscardConnection(std::move(item));
+    }
+
+    if (connection != nullptr) {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        if (!connection->disconnected && !connection->stale) {
+            connection->in_use = true;
+            return connection;
+        }
+    }
+    DiscardConnection(std::move(connection));
+    return nullptr;
+}
+
+void HttpPool::Release(const std::string& key, std::unique_ptr<HttpConnection> connection) {
+    connection->idle_since_us = esp_timer_get_time();
+    std::unique_ptr<HttpConnection> replaced;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& slot = idle_[key];
+        replaced = std::move(slot);
+        slot = std::move(connection);
+    }
+    DiscardConnection(std::move(replaced));
+}
+
+void HttpPool::RecordOpen(const std::string& key, bool reused, bool success, int open_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& stats = stats_[key];
+    stats.requests++;
+    if (!success) {
+        stats.failures++;
+    } else if (reused) {
+        stats.reused++;
+        stats.reuse_open_ms += open_ms;
+    } else {
+        stats.connections++;
+        stats.connect_open_ms += open_ms;
+    }
+}
+
+void HttpPool::Clear() {
+    std::map<std::string, std::unique_ptr<HttpConnection>> idle;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle.swap(idle_);
+    }
+    for (auto& it : idle) {
+        DiscardConnection(std::move(it.second));
+    }
+}
+
+void HttpPool::PrintStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& it : stats_) {
+        auto& s = it.second;
+        ESP_LOGI(TAG, "%s: requests=%lu new=%lu (avg %lu ms) reused=%lu (avg %lu ms) failed=%lu", it.first.c_str(),
+            s.requests, s.connections, s.connections > 0 ? (uint32_t)(s.connect_open_ms / s.connections) : 0,
+            s.reused, s.reused > 0 ? (uint32_t)(s.reuse_open_ms / s.reused) : 0, s.failures);
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef HTTP_POOL_H
+#define HTTP_POOL_H
+
+#include <http.h>
+#include <network_interface.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/*
+ * HttpPool 按 connect_id + scheme://host:port 缓存已完成请求的 TCP/TLS 连接，在空闲超时前
+ * 交给下一次对同一 host 的请求复用，避免激活轮询等场景每次都重新握手。
+ *
+ * esp-ml307 的 HttpClient 每次 Open 都会新建 Tcp/Ssl 连接，复用 Http 对象并不能保留连接，
+ * 因此 CreateHttp 返回的 Http 直接在 NetworkInterface 的 Tcp/Ssl 上收发 HTTP/1.1 请求，
+ * 支持 Content-Length 和 chunked 响应，设置 Transfer-Encoding: chunked 时 Write 按块发送请求体。
+ * 板卡的 GetNetwork 返回 PooledNetwork，调用者照常使用 NetworkInterface::CreateHttp 即可。
+ *
+ * 接收回调运行在 transport 的接收任务中 (ML307 上是所有连接共用的 AT 接收任务)，不能阻塞，
+ * 数据先缓存，缓存超过上限说明读取方跟不上，直接让本次请求失败。
+ * 复用的连接在收到任何响应数据之前被服务器关闭时才换新连接重发，超时或已收到数据时不重发，避免重复提交。
+ *
+ * 复用条件: 响应体已读完、服务器没有返回 Connection: close、连接空闲期间没有断开或收到数据。
+ * 调用者需在每条路径上读完响应并 Close，否则连接不会回到池中。
+ * 每个 host 统计新建连接数、复用数和 Open 耗时，用于评估复用的收益。
+ */
+struct HttpPoolStats {
+    uint32_t requests = 0;
+    uint32_t connections = 0;
+    uint32_t reused = 0;
+    uint32_t failures = 0;
+    uint64_t connect_open_ms = 0;   // 新建连接的 Open 总耗时 (含握手和等待响应头)
+    uint64_t reuse_open_ms = 0;     // 复用连接的 Open 总耗时
+};
+
+struct HttpConnection;
+
+// 包装板卡的网络接口，CreateHttp 返回连接池中的 Http，其他接口直接转发
+class PooledNetwork : public NetworkInterface {
+public:
+    explicit PooledNetwork(NetworkInterface* network) : network_(network) {}
+
+    std::unique_ptr<Http> CreateHttp(int connect_id = -1) override;
+    std::unique_ptr<Tcp> CreateTcp(int connect_id = -1) override { return network_->CreateTcp(connect_id); }
+    std::unique_ptr<Tcp> CreateSsl(int connect_id = -1) override { return network_->CreateSsl(connect_id); }
+    std::unique_ptr<Udp> CreateUdp(int connect_id = -1) override { return network_->CreateUdp(connect_id); }
+    std::unique_ptr<Mqtt> CreateMqtt(int connect_id = -1) override { return network_->CreateMqtt(connect_id); }
+    std::unique_ptr<WebSocket> CreateWebSocket(int connect_id = -1) override { return network_->CreateWebSocket(connect_id); }
+
+private:
+    NetworkInterface* network_;
+};
+
+class HttpPool {
+public:
+    static HttpPool& GetInstance() {
+        static HttpPool instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    HttpPool(const HttpPool&) = delete;
+    HttpPool& operator=(const HttpPool&) = delete;
+
+    std::unique_ptr<Http> CreateHttp(NetworkInterface* network, int connect_id);
+    void Clear();
+    void PrintStats();
+
+private:
+    friend class PooledHttp;
+
+    // HttpConnection 只在 http_pool.cc 中定义
+    HttpPool();
+    ~HttpPool();
+
+    std::mutex mutex_;
+    std::map<std::string, std::unique_ptr<HttpConnection>> idle_;
+    std::map<std::string, HttpPoolStats> stats_;
+
+    std::unique_ptr<HttpConnection> Acquire(const std::string& key);
+    void Release(const std::string& key, std::unique_ptr<HttpConnection> connection);
+    void RecordOpen(const std::string& key, bool reused, bool success, int open_ms);
+};
+
+#endif // HTTP_POOL_H
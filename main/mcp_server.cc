@@ -8,17 +8,28 @@
 #include <esp_app_desc.h>
 #include <algorithm>
 #include <cstring>
-#include <esp_pthread.h>
 
 #include "application.h"
 #include "display.h"
 #include "board.h"
+#if CONFIG_USE_TASK_PROFILER
+#include "task_profiler.h"
+#endif
+#if CONFIG_USE_HEAP_TRACKER
+#include "heap_tracker.h"
+#endif
+#include "timeline_trace.h"
+#include "metrics.h"
 
 #define TAG "MCP"
 
-#define DEFAULT_TOOLCALL_STACK_SIZE 6144
-
-McpServer::McpServer() {
+McpServer::McpServer() : tool_pool_([this](int id, const std::string& message, bool error) {
+    if (error) {
+        ReplyError(id, message);
+    } else {
+        ReplyResult(id, message);
+    }
+}) {
 }
 
 McpServer::~McpServer() {
@@ -100,11 +111,75 @@ void McpServer::AddCommonTools() {
                 }
                 auto question = properties["question"].value<std::string>();
                 return camera->Explain(question);
-            });
+            }, kMcpToolStackLarge);
     }
 
+    AddTool("self.system.get_metrics",
+        "Get the performance metrics of the device: event counters (audio frames, animation frames, posture detections), "
+        "gauges (free heap) and latency histograms (frame interval, inference time, in milliseconds).\n"
+        "Use this tool only when the user asks about device performance or debugging.",
+        PropertyList(),
+        [](const PropertyList& properties) -> ReturnValue {
+            return MetricsRegistry::GetInstance().GetJson();
+        });
+
+    AddTool("self.system.get_tool_stats",
+        "Get the statistics of MCP tool calls on the device: calls, rejections, timeouts, cancellations, "
+        "queue wait and run time (milliseconds) of each tool.\n"
+        "Use this tool only when the user asks about device performance or debugging.",
+        PropertyList(),
+        [this](const PropertyList& properties) -> ReturnValue {
+            return tool_pool_.GetStatsJson();
+        });
+
+#if CONFIG_USE_TASK_PROFILER
+    AddTool("self.system.get_profile",
+        "Get the recent CPU usage (percent of all cores), minimum free stack (bytes), core and priority of each task on the device.\n"
+        "Use this tool only when the user asks about device performance or debugging.\n"
+        "Args:\n"
+        "  `samples`: Number of recent samples to return, the newest first.",
+        PropertyList({
+            Property("samples", kPropertyTypeInteger, 1, 1, PROFILER_HISTORY_SIZE)
+        }),
+        [](const PropertyList& properties) -> ReturnValue {
+            return TaskProfiler::GetInstance().GetProfileJson(properties["samples"].value<int>());
+        });
+#endif
+
+#if CONFIG_USE_HEAP_TRACKER
+    AddTool("self.system.get_heap",
+        "Get the heap snapshot of the device: free memory, largest free block and fragmentation of each heap, "
+        "live bytes and allocation rate of each subsystem.\n"
+        "Use this tool only when the user asks about device memory usage or debugging.",
+        PropertyList(),
+        [](const PropertyList& properties) -> ReturnValue {
+            return HeapTracker::GetInstance().GetSnapshotJson();
+        });
+#endif
+
+#if CONFIG_USE_TIMELINE_TRACE
+    AddTool("self.system.save_trace",
+        "Save the recent timeline trace of the audio, network, display and camera pipeline to the SD card "
+        "in Chrome trace format, for analysing stalls in Perfetto.\n"
+        "Use this tool only when the user asks to capture a trace or debug stuttering.\n"
+        "Args:\n"
+        "  `path`: File path on the SD card.",
+        PropertyList({
+            Property("path", kPropertyTypeString, std::string("/sdcard/trace.json"))
+        }),
+        [](const PropertyList& properties) -> ReturnValue {
+            auto path = properties["path"].value<std::string>();
+            int count = TimelineTrace::GetInstance().Save(path);
+            if (count < 0) {
+                return "{\"success\": false, \"message\": \"Failed to save trace, is the SD card mounted?\"}";
+            }
+            return "{\"success\": true, \"events\": " + std::to_string(count) + "}";
+        });
+#endif
+
     // Restore the original tools list to the end of the tools list
     tools_.insert(tools_.end(), original_tools.begin(), original_tools.end());
+    InvalidateToolsList();
 }
 
 void McpServer::AddTool(McpTool* tool) {
@@ -116,14 +191,22 @@ void McpServer::AddTool(McpTool* tool) {
 
     ESP_LOGI(TAG, "Add tool: %s", tool->name().c_str());
     tools_.push_back(tool);
+    InvalidateToolsList();
 }
 
-void McpServer::AddTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback) {
-    AddTool(new McpTool(name, description, properties, callback));
+void McpServer::AddTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback,
+    McpToolStackClass stack_class) {
+    AddTool(new McpTool(name, description, properties, callback, stack_class));
 }
 
 void McpServer::ParseMessage(const std::string& message) {
-    cJSON* json = cJSON_Parse(message.c_str());
+    cJSON* json;
+    {
+#if CONFIG_USE_HEAP_TRACKER
+        HeapTagScope scope(kHeapTagJson);
+#endif
+        json = cJSON_Parse(message.c_str());
+    }
     if (json == nullptr) {
         ESP_LOGE(TAG, "Failed to parse MCP message: %s", message.c_str());
         return;
@@ -167,6 +250,14 @@ void McpServer::ParseMessage(const cJSON* json) {
     }
     
     auto method_str = std::string(method->valuestring);
+    if (method_str == "notifications/cancelled") {
+        auto params = cJSON_GetObjectItem(json, "params");
+        auto request_id = cJSON_IsObject(params) ? cJSON_GetObjectItem(params, "requestId") : nullptr;
+        if (cJSON_IsNumber(request_id)) {
+            tool_pool_.Cancel(request_id->valueint);
+        }
+        return;
+    }
     if (method_str.find("notifications") == 0) {
         return;
     }
@@ -230,7 +321,7 @@ void McpServer::ParseMessage(const cJSON* json) {
             ReplyError(id_int, "Invalid stackSize");
             return;
         }
-        DoToolCall(id_int, std::string(tool_name->valuestring), tool_arguments, stack_size ? stack_size->valueint : DEFAULT_TOOLCALL_STACK_SIZE);
+        DoToolCall(id_int, std::string(tool_name->valuestring), tool_arguments, stack_size ? stack_size->valueint : MCP_TOOL_NORMAL_STACK_SIZE);
     } else {
         ESP_LOGE(TAG, "Method not implemented: %s", method_str.c_str());
         ReplyError(id_int, "Method not implemented: " + method_str);
@@ -254,54 +345,27 @@ void McpServer::ReplyError(int id, const std::string& message) {
     Application::GetInstance().SendMcpMessage(payload);
 }
 
-void McpServer::GetToolsList(int id, const std::string& cursor) {
-    const int max_payload_size = 8000;
-    std::string json = "{\"tools\":[";
-    
-    bool found_cursor = cursor.empty();
-    auto it = tools_.begin();
-    std::string next_cursor = "";
-    
-    while (it != tools_.end()) {
-        // 如果我们还没有找到起始位置，继续搜索
-        if (!found_cursor) {
-            if ((*it)->name() == cursor) {
-                found_cursor = true;
-            } else {
-                ++it;
-                continue;
-            }
-        }
-        
-        // 添加tool前检查大小
-        std::string tool_json = (*it)->to_json() + ",";
-        if (json.length() + tool_json.length() + 30 > max_payload_size) {
-            // 如果添加这个tool会超出大小限制，设置next_cursor并退出循环
-            next_cursor = (*it)->name();
-            break;
-        }
-        
-        json += tool_json;
-        ++it;
-    }
-    
-    if (json.back() == ',') {
-        json.pop_back();
-    }
-    
-    if (json.back() == '[' && !tools_.empty()) {
-        // 如果没有添加任何tool，返回错误
-        ESP_LOGE(TAG, "tools/list: Failed to add tool %s because of payload size limit", next_cursor.c_str());
-        ReplyError(id, "Failed to add tool " + next_cursor + " because of payload size limit");
-        return;
+void McpServer::InvalidateToolsList() {
+    std::lock_guard<std::mutex> lock(tools_list_mutex_);
+    tools_list_.Clear();
+}
+
+bool McpServer::GetToolsListJson(const std::string& cursor, std::string& json) {
+    std::lock_guard<std::mutex> lock(tools_list_mutex_);
+    if (tools_list_.empty()) {
+        tools_list_.Build(tools_);
+        ESP_LOGI(TAG, "tools/list: %u tools in %u pages", (unsigned)tools_.size(), (unsigned)tools_list_.page_count());
     }
+    return tools_list_.Find(cursor, json);
+}
 
-    if (next_cursor.empty()) {
-        json += "]}";
-    } else {
-        json += "],\"nextCursor\":\"" + next_cursor + "\"}";
+void McpServer::GetToolsList(int id, const std::string& cursor) {
+    std::string json;
+    if (!GetToolsListJson(cursor, json)) {
+        ESP_LOGE(TAG, "tools/list: %s", json.c_str());
+        ReplyError(id, json);
+        return;
     }
-    
     ReplyResult(id, json);
 }
 
@@ -317,51 +381,20 @@ void McpServer::DoToolCall(int id, const std::string& tool_name, const cJSON* to
         return;
     }
 
-    PropertyList arguments = (*tool_iter)->properties();
-    try {
-        for (auto& argument : arguments) {
-            bool found = false;
-            if (cJSON_IsObject(tool_arguments)) {
-                auto value = cJSON_GetObjectItem(tool_arguments, argument.name().c_str());
-                if (argument.type() == kPropertyTypeBoolean && cJSON_IsBool(value)) {
-                    argument.set_value<bool>(value->valueint == 1);
-                    found = true;
-                } else if (argument.type() == kPropertyTypeInteger && cJSON_IsNumber(value)) {
-                    argument.set_value<int>(value->valueint);
-                    found = true;
-                } else if (argument.type() == kPropertyTypeString && cJSON_IsString(value)) {
-                    argument.set_value<std::string>(value->valuestring);
-                    found = true;
-                }
-            }
-
-            if (!argument.has_default_value() && !found) {
-                ESP_LOGE(TAG, "tools/call: Missing valid argument: %s", argument.name().c_str());
-                ReplyError(id, "Missing valid argument: " + argument.name());
-                return;
-            }
-        }
-    } catch (const std::exception& e) {
-        ESP_LOGE(TAG, "tools/call: %s", e.what());
-        ReplyError(id, e.what());
+    // 工具声明的栈类别和请求的 stackSize 取较大者
+    auto stack_class = (*tool_iter)->stack_class();
+    if (stack_size > MCP_TOOL_LARGE_STACK_SIZE) {
+        ESP_LOGE(TAG, "tools/call: stackSize %d is too large", stack_size);
+        ReplyError(id, "stackSize is too large: " + std::to_string(stack_size));
         return;
+    } else if (stack_size > MCP_TOOL_NORMAL_STACK_SIZE) {
+        stack_class = kMcpToolStackLarge;
     }
 
-    // Start a task to receive data with stack size
-    esp_pthread_cfg_t cfg = esp_pthread_get_default_config();
-    cfg.thread_name = "tool_call";
-    cfg.stack_size = stack_size;
-    cfg.prio = 1;
-    esp_pthread_set_cfg(&cfg);
-
-    // Use a thread to call the tool to avoid blocking the main thread
-    tool_call_thread_ = std::thread([this, id, tool_iter, arguments = std::move(arguments)]() {
-        try {
-            ReplyResult(id, (*tool_iter)->Call(arguments));
-        } catch (const std::exception& e) {
-            ESP_LOGE(TAG, "tools/call: %s", e.what());
-            ReplyError(id, e.what());
-        }
-    });
-    tool_call_thread_.detach();
+    // 参数绑定到调用槽的参数帧后在工作任务中调用工具，避免阻塞主线程
+    std::string error;
+    if (!tool_pool_.Submit(id, *tool_iter, tool_arguments, stack_class, error)) {
+        ESP_LOGE(TAG, "tools/call: %s", error.c_str());
+        ReplyError(id, error);
+    }
 }
\ No newline at end of file
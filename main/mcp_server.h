@@ -8,10 +8,13 @@
 #include <variant>
 #include <optional>
 #include <stdexcept>
-#include <thread>
+#include <mutex>
 
 #include <cJSON.h>
 
+#include "mcp_tool_pool.h"
+#include "mcp_tools_list.h"
+
 // 添加类型别名
 using ReturnValue = std::variant<bool, int, std::string>;
 
@@ -21,9 +24,19 @@ enum PropertyType {
     kPropertyTypeString
 };
 
+// FNV-1a，属性按名称的哈希查找，只有哈希相同时才比较字符串
+inline uint32_t PropertyNameHash(const char* name) {
+    uint32_t hash = 2166136261u;
+    while (*name != '\0') {
+        hash = (hash ^ (uint8_t)*name++) * 16777619u;
+    }
+    return hash;
+}
+
 class Property {
 private:
     std::string name_;
+    uint32_t name_hash_;
     PropertyType type_;
     std::variant<bool, int, std::string> value_;
     bool has_default_value_;
@@ -33,24 +46,24 @@ private:
 public:
     // Required field constructor
     Property(const std::string& name, PropertyType type)
-        : name_(name), type_(type), has_default_value_(false) {}
+        : name_(name), name_hash_(PropertyNameHash(name.c_str())), type_(type), has_default_value_(false) {}
 
     // Optional field constructor with default value
     template<typename T>
     Property(const std::string& name, PropertyType type, const T& default_value)
-        : name_(name), type_(type), has_default_value_(true) {
+        : name_(name), name_hash_(PropertyNameHash(name.c_str())), type_(type), has_default_value_(true) {
         value_ = default_value;
     }
 
     Property(const std::string& name, PropertyType type, int min_value, int max_value)
-        : name_(name), type_(type), has_default_value_(false), min_value_(min_value), max_value_(max_value) {
+        : name_(name), name_hash_(PropertyNameHash(name.c_str())), type_(type), has_default_value_(false), min_value_(min_value), max_value_(max_value) {
         if (type != kPropertyTypeInteger) {
             throw std::invalid_argument("Range limits only apply to integer properties");
         }
     }
 
     Property(const std::string& name, PropertyType type, int default_value, int min_value, int max_value)
-        : name_(name), type_(type), has_default_value_(true), min_value_(min_value), max_value_(max_value) {
+        : name_(name), name_hash_(PropertyNameHash(name.c_str())), type_(type), has_default_value_(true), min_value_(min_value), max_value_(max_value) {
         if (type != kPropertyTypeInteger) {
             throw std::invalid_argument("Range limits only apply to integer properties");
         }
@@ -61,6 +74,7 @@ public:
     }
 
     inline const std::string& name() const { return name_; }
+    inline uint32_t name_hash() const { return name_hash_; }
     inline PropertyType type() const { return type_; }
     inline bool has_default_value() const { return has_default_value_; }
     inline bool has_range() const { return min_value_.has_value() && max_value_.has_value(); }
@@ -86,7 +100,37 @@ public:
         value_ = value;
     }
 
-    std::string to_json() const {
+    inline bool Accepts(const cJSON* value) const {
+        return (type_ == kPropertyTypeBoolean && cJSON_IsBool(value)) ||
+            (type_ == kPropertyTypeInteger && cJSON_IsNumber(value)) ||
+            (type_ == kPropertyTypeString && cJSON_IsString(value));
+    }
+
+    // 不抛出异常的赋值，value 的类型需先用 Accepts 检查，超出范围时返回 false 和错误信息，供参数绑定使用
+    bool Bind(const cJSON* value, std::string& error) {
+        if (type_ == kPropertyTypeBoolean) {
+            value_ = (bool)cJSON_IsTrue(value);
+        } else if (type_ == kPropertyTypeInteger) {
+            if (min_value_.has_value() && value->valueint < min_value_.value()) {
+                error = "Value is below minimum allowed: " + std::to_string(min_value_.value());
+                return false;
+            }
+            if (max_value_.has_value() && value->valueint > max_value_.value()) {
+                error = "Value exceeds maximum allowed: " + std::to_string(max_value_.value());
+                return false;
+            }
+            value_ = value->valueint;
+        } else {
+            if (auto string_value = std::get_if<std::string>(&value_)) {
+                string_value->assign(value->valuestring);
+            } else {
+                value_ = std::string(value->valuestring);
+            }
+        }
+        return true;
+    }
+
+    cJSON* to_cjson() const {
         cJSON *json = cJSON_CreateObject();
         
         if (type_ == kPropertyTypeBoolean) {
@@ -111,7 +155,11 @@ public:
                 cJSON_AddStringToObject(json, "default", value<std::string>().c_str());
             }
         }
-        
+        return json;
+    }
+
+    std::string to_json() const {
+        cJSON *json = to_cjson();
         char *json_str = cJSON_PrintUnformatted(json);
         std::string result(json_str);
         cJSON_free(json_str);
@@ -121,26 +169,50 @@ public:
     }
 };
 
+// 参数绑定用 64 位掩码记录已提供的参数
+#define MCP_MAX_TOOL_PROPERTIES 64
+
 class PropertyList {
 private:
     std::vector<Property> properties_;
 
 public:
     PropertyList() = default;
-    PropertyList(const std::vector<Property>& properties) : properties_(properties) {}
+    PropertyList(const std::vector<Property>& properties) : properties_(properties) {
+        if (properties_.size() > MCP_MAX_TOOL_PROPERTIES) {
+            throw std::invalid_argument("Too many properties");
+        }
+    }
     void AddProperty(const Property& property) {
+        if (properties_.size() >= MCP_MAX_TOOL_PROPERTIES) {
+            throw std::invalid_argument("Too many properties");
+        }
         properties_.push_back(property);
     }
 
-    const Property& operator[](const std::string& name) const {
-        for (const auto& property : properties_) {
-            if (property.name() == name) {
-                return property;
+    // 返回属性的序号，不存在时返回 -1
+    int IndexOf(const char* name) const {
+        uint32_t hash = PropertyNameHash(name);
+        for (size_t i = 0; i < properties_.size(); i++) {
+            if (properties_[i].name_hash() == hash && properties_[i].name() == name) {
+                return i;
             }
         }
-        throw std::runtime_error("Property not found: " + name);
+        return -1;
+    }
+
+    const Property& operator[](const std::string& name) const {
+        int index = IndexOf(name.c_str());
+        if (index < 0) {
+            throw std::runtime_error("Property not found: " + name);
+        }
+        return properties_[index];
     }
 
+    inline size_t size() const { return properties_.size(); }
+    inline Property& at(size_t index) { return properties_[index]; }
+    inline const Property& at(size_t index) const { return properties_[index]; }
+
     auto begin() { return properties_.begin(); }
     auto end() { return properties_.end(); }
 
@@ -154,14 +226,16 @@ public:
         return required;
     }
 
-    std::string to_json() const {
+    cJSON* to_cjson() const {
         cJSON *json = cJSON_CreateObject();
-        
         for (const auto& property : properties_) {
-            cJSON *prop_json = cJSON_Parse(property.to_json().c_str());
-            cJSON_AddItemToObject(json, property.name().c_str(), prop_json);
+            cJSON_AddItemToObject(json, property.name().c_str(), property.to_cjson());
         }
-        
+        return json;
+    }
+
+    std::string to_json() const {
+        cJSON *json = to_cjson();
         char *json_str = cJSON_PrintUnformatted(json);
         std::string result(json_str);
         cJSON_free(json_str);
@@ -177,18 +251,51 @@ private:
     std::string description_;
     PropertyList properties_;
     std::function<ReturnValue(const PropertyList&)> callback_;
+    McpToolStackClass stack_class_;
 
 public:
     McpTool(const std::string& name, 
             const std::string& description, 
             const PropertyList& properties, 
-            std::function<ReturnValue(const PropertyList&)> callback)
+            std::function<ReturnValue(const PropertyList&)> callback,
+            McpToolStackClass stack_class = kMcpToolStackNormal)
         : name_(name), 
         description_(description), 
         properties_(properties), 
-        callback_(callback) {}
+        callback_(callback),
+        stack_class_(stack_class) {}
 
     inline const std::string& name() const { return name_; }
+    inline McpToolStackClass stack_class() const { return stack_class_; }
+
+    /*
+     * 在一次遍历 arguments 的过程中按哈希找到对应属性并赋值 (名称区分大小写)，结果写入调用者预先分配的 frame，
+     * 复制默认值时复用 frame 已有的内存。参数缺失、类型不符或超出范围时返回 false 和错误信息，不抛出异常。
+     */
+    bool BindArguments(const cJSON* arguments, PropertyList& frame, std::string& error) const {
+        frame = properties_;
+        uint64_t bound = 0;
+        if (cJSON_IsObject(arguments)) {
+            for (const cJSON* item = arguments->child; item != nullptr; item = item->next) {
+                // 未知或类型不符的参数与未提供相同，可选参数使用默认值
+                int index = frame.IndexOf(item->string);
+                if (index < 0 || !frame.at(index).Accepts(item)) {
+                    continue;
+                }
+                if (!frame.at(index).Bind(item, error)) {
+                    return false;
+                }
+                bound |= 1ull << index;
+            }
+        }
+        for (size_t i = 0; i < frame.size(); i++) {
+            if (!frame.at(i).has_default_value() && (bound & (1ull << i)) == 0) {
+                error = "Missing valid argument: " + frame.at(i).name();
+                return false;
+            }
+        }
+        return true;
+    }
     inline const std::string& description() const { return description_; }
     inline const PropertyList& properties() const { return properties_; }
 
@@ -202,8 +309,7 @@ public:
         cJSON *input_schema = cJSON_CreateObject();
         cJSON_AddStringToObject(input_schema, "type", "object");
         
-        cJSON *properties = cJSON_Parse(properties_.to_json().c_str());
-        cJSON_AddItemToObject(input_schema, "properties", properties);
+        cJSON_AddItemToObject(input_schema, "properties", properties_.to_cjson());
         
         if (!required.empty()) {
             cJSON *required_array = cJSON_CreateArray();
@@ -258,9 +364,14 @@ public:
 
     void AddCommonTools();
     void AddTool(McpTool* tool);
-    void AddTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback);
+    void AddTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback,
+        McpToolStackClass stack_class = kMcpToolStackNormal);
     void ParseMessage(const cJSON* json);
     void ParseMessage(const std::string& message);
+    // tools/list 的 result，按 cursor 返回缓存的分页，cursor 无效或工具超过大小限制时返回 false 和错误信息
+    bool GetToolsListJson(const std::string& cursor, std::string& json);
+    // 工具列表变化后调用，下次请求时重新生成
+    void InvalidateToolsList();
 
 private:
     McpServer();
@@ -275,7 +386,9 @@ private:
     void DoToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments, int stack_size);
 
     std::vector<McpTool*> tools_;
-    std::thread tool_call_thread_;
+    McpToolPool tool_pool_;
+    std::mutex tools_list_mutex_;
+    McpToolsList tools_list_;     // 为空表示需要重新生成
 };
 
 #endif // MCP_SERVER_H
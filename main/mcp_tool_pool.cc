@@ -0,0 +1,271 @@
+#include "mcp_tool_pool.h"
+#include "mcp_server.h"
+#include "metrics.h"
+#include "task_planner.h"
+
+#include <esp_log.h>
+#include <cJSON.h>
+
+#include <algorithm>
+
+#define TAG "McpToolPool"
+
+struct McpToolCall {
+    int id;
+    McpTool* tool;
+    PropertyList arguments;
+    int64_t enqueue_time_us;
+    int64_t start_time_us;      // 0 表示仍在排队
+    bool cancelled;
+    bool timed_out;
+    bool in_use;
+};
+
+McpToolPool::McpToolPool(ReplyCallback reply) : reply_(std::move(reply)) {
+    classes_[kMcpToolStackNormal] = {this, "tool_call", MCP_TOOL_NORMAL_STACK_SIZE, MCP_TOOL_NORMAL_WORKERS, 0, nullptr};
+    classes_[kMcpToolStackLarge] = {this, "tool_call_large", MCP_TOOL_LARGE_STACK_SIZE, MCP_TOOL_LARGE_WORKERS, 0, nullptr};
+    for (auto& worker_class : classes_) {
+        worker_class.queue = xQueueCreate(MCP_TOOL_QUEUE_LENGTH, sizeof(McpToolCall*));
+    }
+    calls_ = new McpToolCall[MCP_TOOL_MAX_CALLS]();
+
+    auto& metrics = MetricsRegistry::GetInstance();
+    calls_counter_ = metrics.AddCounter("mcp.tool_calls");
+    rejected_counter_ = metrics.AddCounter("mcp.tool_rejected");
+    wait_histogram_ = metrics.AddHistogram("mcp.tool_wait_ms", {1, 5, 20, 100, 500, 2000, 10000});
+    run_histogram_ = metrics.AddHistogram("mcp.tool_run_ms", {5, 20, 100, 500, 1000, 3000, 10000, 30000});
+
+    esp_timer_create_args_t watchdog_timer_args = {
+        .callback = [](void* arg) {
+            ((McpToolPool*)arg)->CheckTimeouts();
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "mcp_tool_watchdog",
+        .skip_unhandled_events = true,
+    };
+    esp_timer_create(&watchdog_timer_args, &watchdog_timer_);
+
+    StartWorkers(classes_[kMcpToolStackNormal]);
+}
+
+McpToolPool::~McpToolPool() {
+    if (watchdog_timer_ != nullptr) {
+        esp_timer_stop(watchdog_timer_);
+        esp_timer_delete(watchdog_timer_);
+    }
+    delete[] calls_;
+}
+
+void McpToolPool::StartWorkers(WorkerClass& worker_class) {
+    auto& planner = TaskPlanner::GetInstance();
+    while (worker_class.started < worker_class.worker_count) {
+        if (planner.CreateTask(kTaskRoleMcpTool, [](void* arg) {
+            auto worker_class = (WorkerClass*)arg;
+            worker_class->pool->WorkerTask(*worker_class);
+            vTaskDelete(NULL);
+        }, worker_class.name, worker_class.stack_size, &worker_class, nullptr) != pdPASS) {
+            break;
+        }
+        worker_class.started++;
+    }
+}
+
+bool McpToolPool::Submit(int id, McpTool* tool, const cJSON* arguments, McpToolStackClass stack_class, std::string& error) {
+    auto& worker_class = classes_[stack_class];
+    McpToolCall* call = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        StartWorkers(worker_class);
+        auto& stats = stats_[tool];
+        stats.calls++;
+        for (int i = 0; i < MCP_TOOL_MAX_CALLS; i++) {
+            if (!calls_[i].in_use) {
+                call = &calls_[i];
+                break;
+            }
+        }
+        if (call == nullptr) {
+            stats.rejected++;
+        } else {
+            call->id = id;
+            call->tool = tool;
+            call->enqueue_time_us = esp_timer_get_time();
+            call->start_time_us = 0;
+            call->cancelled = false;
+            call->timed_out = false;
+            call->in_use = true;
+            if (!esp_timer_is_active(watchdog_timer_)) {
+                esp_timer_start_periodic(watchdog_timer_, 1000000);
+            }
+        }
+    }
+    calls_counter_->Add(1);
+    if (call == nullptr) {
+        ESP_LOGW(TAG, "Rejected %s: no free call slot", tool->name().c_str());
+        rejected_counter_->Add(1);
+        error = "Too many tool calls in progress";
+        return false;
+    }
+
+    // 调用槽在加入队列前只属于当前任务，可以在锁外绑定参数
+    if (!tool->BindArguments(arguments, call->arguments, error)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ReleaseCall(call);
+        return false;
+    }
+
+    if (worker_class.started == 0 || xQueueSend(worker_class.queue, &call, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Rejected %s: %s queue is full", tool->name().c_str(), worker_class.name);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_[tool].rejected++;
+            ReleaseCall(call);
+        }
+        rejected_counter_->Add(1);
+        error = "Too many tool calls in progress";
+        return false;
+    }
+    return true;
+}
+
+void McpToolPool::Cancel(int id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int i = 0; i < MCP_TOOL_MAX_CALLS; i++) {
+        auto call = &calls_[i];
+        if (call->in_use && call->id == id && !call->cancelled && !call->timed_out) {
+            call->cancelled = true;
+            stats_[call->tool].cancelled++;
+            ESP_LOGI(TAG, "Cancelled %s (id %d)", call->tool->name().c_str(), id);
+        }
+    }
+}
+
+void McpToolPool::WorkerTask(WorkerClass& worker_class) {
+    while (true) {
+        McpToolCall* call = nullptr;
+        if (xQueueReceive(worker_class.queue, &call, portMAX_DELAY) == pdTRUE) {
+            Run(call);
+        }
+    }
+}
+
+void McpToolPool::Run(McpToolCall* call) {
+    int64_t start_time = esp_timer_get_time();
+    uint32_t wait_ms = (start_time - call->enqueue_time_us) / 1000;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // 排队期间被取消或已超时 (看门狗已回复错误) 的调用直接丢弃
+        if (call->cancelled || call->timed_out) {
+            ReleaseCall(call);
+            return;
+        }
+        call->start_time_us = start_time;
+    }
+    wait_histogram_->Record(wait_ms);
+
+    std::string result;
+    bool error = false;
+    try {
+        result = call->tool->Call(call->arguments);
+    } catch (const std::exception& e) {
+        ESP_LOGE(TAG, "tools/call: %s", e.what());
+        result = e.what();
+        error = true;
+    }
+    uint32_t run_ms = (esp_timer_get_time() - start_time) / 1000;
+    run_histogram_->Record(run_ms);
+
+    int id = call->id;
+    auto tool = call->tool;
+    bool reply;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& stats = stats_[tool];
+        stats.completed++;
+        stats.total_wait_ms += wait_ms;
+        stats.max_wait_ms = std::max(stats.max_wait_ms, wait_ms);
+        stats.total_run_ms += run_ms;
+        stats.max_run_ms = std::max(stats.max_run_ms, run_ms);
+        reply = !call->cancelled && !call->timed_out;
+        ReleaseCall(call);
+    }
+    if (reply) {
+        reply_(id, result, error);
+    } else {
+        ESP_LOGW(TAG, "Dropped result of %s (id %d) after %lu ms", tool->name().c_str(), id, run_ms);
+    }
+}
+
+// 需持有 mutex_，参数帧保留在槽中，下次绑定时复用内存
+void McpToolPool::ReleaseCall(McpToolCall* call) {
+    call->in_use = false;
+    for (int i = 0; i < MCP_TOOL_MAX_CALLS; i++) {
+        if (calls_[i].in_use) {
+            return;
+        }
+    }
+    esp_timer_stop(watchdog_timer_);
+}
+
+void McpToolPool::CheckTimeouts() {
+    std::vector<std::pair<int, std::string>> expired;
+    int64_t now = esp_timer_get_time();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int i = 0; i < MCP_TOOL_MAX_CALLS; i++) {
+            auto call = &calls_[i];
+            if (!call->in_use || call->cancelled || call->timed_out) {
+                continue;
+            }
+            if (call->start_time_us == 0 && now - call->enqueue_time_us > MCP_TOOL_QUEUE_TIMEOUT_MS * 1000LL) {
+                expired.emplace_back(call->id, "Tool call timed out in queue: " + call->tool->name());
+            } else if (call->start_time_us != 0 && now - call->start_time_us > MCP_TOOL_RUN_TIMEOUT_MS * 1000LL) {
+                expired.emplace_back(call->id, "Tool call timed out: " + call->tool->name());
+            } else {
+                continue;
+            }
+            call->timed_out = true;
+            stats_[call->tool].timeouts++;
+        }
+    }
+    for (auto& [id, message] : expired) {
+        ESP_LOGW(TAG, "%s (id %d)", message.c_str(), id);
+        reply_(id, message, true);
+    }
+}
+
+std::string McpToolPool::GetStatsJson() {
+    cJSON* root = cJSON_CreateObject();
+    cJSON* tools = cJSON_CreateArray();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int pending = 0;
+        for (int i = 0; i < MCP_TOOL_MAX_CALLS; i++) {
+            pending += calls_[i].in_use ? 1 : 0;
+        }
+        cJSON_AddNumberToObject(root, "pending", pending);
+        for (auto& [tool, stats] : stats_) {
+            cJSON* item = cJSON_CreateObject();
+            cJSON_AddStringToObject(item, "name", tool->name().c_str());
+            cJSON_AddNumberToObject(item, "calls", stats.calls);
+            cJSON_AddNumberToObject(item, "rejected", stats.rejected);
+            cJSON_AddNumberToObject(item, "timeouts", stats.timeouts);
+            cJSON_AddNumberToObject(item, "cancelled", stats.cancelled);
+            if (stats.completed > 0) {
+                cJSON_AddNumberToObject(item, "avg_wait_ms", stats.total_wait_ms / stats.completed);
+                cJSON_AddNumberToObject(item, "max_wait_ms", stats.max_wait_ms);
+                cJSON_AddNumberToObject(item, "avg_run_ms", stats.total_run_ms / stats.completed);
+                cJSON_AddNumberToObject(item, "max_run_ms", stats.max_run_ms);
+            }
+            cJSON_AddItemToArray(tools, item);
+        }
+    }
+    cJSON_AddItemToObject(root, "tools", tools);
+
+    char* json_str = cJSON_PrintUnformatted(root);
+    std::string result(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+    return result;
+}
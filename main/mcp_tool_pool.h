@@ -0,0 +1,100 @@
+#ifndef MCP_TOOL_POOL_H
+#define MCP_TOOL_POOL_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <functional>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <esp_timer.h>
+#include <cJSON.h>
+
+/*
+ * MCP 工具调用的工作任务池，替代每次 tools/call 创建一个分离线程。
+ * 按栈大小分为两类，每类有固定数量的工作任务和有界队列：
+ *   normal  MCP_TOOL_NORMAL_STACK_SIZE，启动时创建
+ *   large   MCP_TOOL_LARGE_STACK_SIZE，拍照识别等工具或请求的 stackSize 较大时使用，第一次使用时创建
+ * 每个调用使用预先分配的调用槽，参数直接绑定到槽中的参数帧，不再为每次调用复制工具的属性表。
+ * 没有空闲调用槽或队列已满时直接拒绝；排队超过 MCP_TOOL_QUEUE_TIMEOUT_MS 或运行超过 MCP_TOOL_RUN_TIMEOUT_MS 时回复超时错误，
+ * 运行中的工具无法中断，完成后结果被丢弃。notifications/cancelled 取消的调用不再回复。
+ * 每个工具的排队时间、运行时间、拒绝和超时次数可以通过 GetStatsJson 查询。
+ */
+#define MCP_TOOL_NORMAL_STACK_SIZE 6144
+#define MCP_TOOL_LARGE_STACK_SIZE 12288
+#define MCP_TOOL_NORMAL_WORKERS 2
+#define MCP_TOOL_LARGE_WORKERS 1
+#define MCP_TOOL_QUEUE_LENGTH 4
+#define MCP_TOOL_QUEUE_TIMEOUT_MS 10000
+#define MCP_TOOL_RUN_TIMEOUT_MS 60000
+// 每类最多排队 MCP_TOOL_QUEUE_LENGTH 个并运行 worker 数个调用
+#define MCP_TOOL_MAX_CALLS (MCP_TOOL_QUEUE_LENGTH * 2 + MCP_TOOL_NORMAL_WORKERS + MCP_TOOL_LARGE_WORKERS)
+
+enum McpToolStackClass {
+    kMcpToolStackNormal,
+    kMcpToolStackLarge,
+    kMcpToolStackClassCount,
+};
+
+class McpTool;
+class MetricCounter;
+class MetricHistogram;
+struct McpToolCall;
+
+class McpToolPool {
+public:
+    using ReplyCallback = std::function<void(int id, const std::string& message, bool error)>;
+
+    explicit McpToolPool(ReplyCallback reply);
+    ~McpToolPool();
+
+    // 绑定参数并加入队列，参数无效、没有空闲调用槽或队列已满时返回 false 和错误信息，由调用者回复错误
+    bool Submit(int id, McpTool* tool, const cJSON* arguments, McpToolStackClass stack_class, std::string& error);
+    // 取消排队或运行中的调用
+    void Cancel(int id);
+    std::string GetStatsJson();
+
+private:
+    struct ToolStats {
+        uint32_t calls;
+        uint32_t rejected;
+        uint32_t timeouts;
+        uint32_t cancelled;
+        uint32_t completed;
+        uint32_t total_wait_ms;
+        uint32_t max_wait_ms;
+        uint32_t total_run_ms;
+        uint32_t max_run_ms;
+    };
+
+    struct WorkerClass {
+        McpToolPool* pool;
+        const char* name;
+        uint32_t stack_size;
+        int worker_count;
+        int started;
+        QueueHandle_t queue;
+    };
+
+    ReplyCallback reply_;
+    std::mutex mutex_;
+    WorkerClass classes_[kMcpToolStackClassCount];
+    McpToolCall* calls_;                    // MCP_TOOL_MAX_CALLS 个调用槽，in_use 表示排队或运行中
+    std::map<const McpTool*, ToolStats> stats_;
+    esp_timer_handle_t watchdog_timer_ = nullptr;
+
+    MetricCounter* calls_counter_;
+    MetricCounter* rejected_counter_;
+    MetricHistogram* wait_histogram_;
+    MetricHistogram* run_histogram_;
+
+    void StartWorkers(WorkerClass& worker_class);
+    void WorkerTask(WorkerClass& worker_class);
+    void Run(McpToolCall* call);
+    void ReleaseCall(McpToolCall* call);
+    void CheckTimeouts();
+};
+
+#endif // MCP_TOOL_POOL_H
@@ -0,0 +1,56 @@
+#include "mcp_tools_list.h"
+#include "mcp_server.h"
+
+#include <esp_log.h>
+
+#define TAG "MCP"
+
+// 每页为页尾的 ],"nextCursor":"..."} 预留的长度
+#define TOOLS_LIST_PAGE_RESERVE 31
+
+void McpToolsList::Build(const std::vector<McpTool*>& tools) {
+    const std::string header = "{\"tools\":[";
+    std::string json = header;
+    std::string cursor = "";
+    pages_.clear();
+
+    for (auto tool : tools) {
+        std::string tool_json = tool->to_json();
+        if (json.length() + tool_json.length() + TOOLS_LIST_PAGE_RESERVE <= max_payload_size_) {
+            if (json.length() > header.length()) {
+                json += ",";
+            }
+            json += tool_json;
+            continue;
+        }
+
+        if (json.length() == header.length()) {
+            // 单个工具超过大小限制，请求到这一页时返回错误
+            ESP_LOGE(TAG, "tools/list: Tool %s exceeds the payload size limit", tool->name().c_str());
+            pages_.push_back({cursor, "Failed to add tool " + tool->name() + " because of payload size limit", true});
+            return;
+        }
+        json += "],\"nextCursor\":\"" + tool->name() + "\"}";
+        pages_.push_back({cursor, std::move(json), false});
+        cursor = tool->name();
+        json = header + tool_json;
+        if (json.length() + TOOLS_LIST_PAGE_RESERVE > max_payload_size_) {
+            ESP_LOGE(TAG, "tools/list: Tool %s exceeds the payload size limit", tool->name().c_str());
+            pages_.push_back({cursor, "Failed to add tool " + tool->name() + " because of payload size limit", true});
+            return;
+        }
+    }
+    json += "]}";
+    pages_.push_back({cursor, std::move(json), false});
+}
+
+bool McpToolsList::Find(const std::string& cursor, std::string& json) const {
+    for (auto& page : pages_) {
+        if (page.cursor == cursor) {
+            json = page.json;
+            return !page.error;
+        }
+    }
+    json = "Invalid cursor: " + cursor;
+    return false;
+}
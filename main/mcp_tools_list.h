@@ -0,0 +1,38 @@
+#ifndef MCP_TOOLS_LIST_H
+#define MCP_TOOLS_LIST_H
+
+#include <string>
+#include <vector>
+
+class McpTool;
+
+/*
+ * tools/list 的分页缓存。所有工具序列化一次后按负载大小限制分页，之后按 cursor 直接返回缓存的 result，
+ * 工具列表变化时由 McpServer 清空后重新生成。每页的第一个工具名即为请求该页的 cursor，第一页的 cursor 为空。
+ * 单个工具超过大小限制时，从该工具开始的页返回错误。不加锁，由调用者保护。
+ */
+#define MCP_TOOLS_LIST_MAX_PAYLOAD 8000
+
+class McpToolsList {
+public:
+    explicit McpToolsList(size_t max_payload_size = MCP_TOOLS_LIST_MAX_PAYLOAD) : max_payload_size_(max_payload_size) {}
+
+    void Build(const std::vector<McpTool*>& tools);
+    // 返回 cursor 对应页的 result，cursor 无效或该页出错时返回 false 和错误信息
+    bool Find(const std::string& cursor, std::string& json) const;
+    void Clear() { pages_.clear(); }
+    bool empty() const { return pages_.empty(); }
+    size_t page_count() const { return pages_.size(); }
+
+private:
+    struct Page {
+        std::string cursor;
+        std::string json;
+        bool error;
+    };
+
+    size_t max_payload_size_;
+    std::vector<Page> pages_;
+};
+
+#endif // MCP_TOOLS_LIST_H
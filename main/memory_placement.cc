@@ -0,0 +1,266 @@
+#include "memory_placement.h"
+#include "settings.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <esp_memory_utils.h>
+#include <esp_console.h>
+
+#include <mutex>
+#include <cstring>
+#include <cstdlib>
+
+#define TAG "MemoryPlacement"
+
+struct MemoryPlacementRule {
+    const char* name;
+    memory_region_t preferred;
+    memory_region_t fallback;
+    uint16_t alignment;     // 0 表示不要求对齐
+};
+
+enum MemoryPlacementSource {
+    kPlacementSourceDefault,
+    kPlacementSourceBoard,
+    kPlacementSourceNvs,
+};
+
+struct MemoryPlacementStats {
+    uint32_t allocations;
+    uint32_t failures;
+    uint32_t fallbacks;
+    uint32_t internal_bytes;
+    uint32_t psram_bytes;
+};
+
+/*
+ * 默认值与集中管理之前的分配方式一致：眼球动画的两块缓冲 (各约 100KB) 原来用 new 分配，
+ * 在开启 SPIRAM_MALLOC_ALWAYSINTERNAL 的芯片上落在 PSRAM，内部 RAM 留给 WiFi、AFE 和 DMA。
+ * 需要更快的眼球渲染时由板卡覆盖为 internal。
+ *
+ * 各芯片共用一张表，没有 PSRAM 时在 InitializeRules 中替换为内部 RAM。只有 SD 卡读取缓冲的对齐按芯片区分：
+ * P4 的 L2 Cache 行为 128 字节，SDMMC 只有对齐到 Cache 行的缓冲才能直接 DMA，否则驱动会经过内部的中转缓冲再复制一次；
+ * S3 等芯片的 SDMMC / SPI 只要求 4 字节对齐。
+ */
+#if CONFIG_IDF_TARGET_ESP32P4
+#define MEMORY_PLACEMENT_SD_READ_ALIGNMENT 128
+#else
+#define MEMORY_PLACEMENT_SD_READ_ALIGNMENT 4
+#endif
+
+static const MemoryPlacementRule kDefaultRules[MEMORY_BUFFER_COUNT] = {
+    {"eye_frame",       MEMORY_REGION_PSRAM,    MEMORY_REGION_INTERNAL, 0},
+    {"eye_canvas",      MEMORY_REGION_PSRAM,    MEMORY_REGION_INTERNAL, 0},
+    {"display_draw",    MEMORY_REGION_DMA,      MEMORY_REGION_NONE,     0},
+    {"image",           MEMORY_REGION_PSRAM,    MEMORY_REGION_INTERNAL, 0},
+    {"camera_preview",  MEMORY_REGION_PSRAM,    MEMORY_REGION_NONE,     0},
+    {"mjpeg_cache",     MEMORY_REGION_PSRAM,    MEMORY_REGION_INTERNAL, 0},
+    {"mjpeg_read",      MEMORY_REGION_INTERNAL, MEMORY_REGION_PSRAM,    MEMORY_PLACEMENT_SD_READ_ALIGNMENT},
+    {"wake_word_stack", MEMORY_REGION_PSRAM,    MEMORY_REGION_NONE,     0},
+    {"afe",             MEMORY_REGION_PSRAM,    MEMORY_REGION_NONE,     0},
+    {"posture_image",   MEMORY_REGION_PSRAM,    MEMORY_REGION_INTERNAL, 0},
+    {"session_record",  MEMORY_REGION_PSRAM,    MEMORY_REGION_NONE,     0},
+    {"profiler",        MEMORY_REGION_PSRAM,    MEMORY_REGION_INTERNAL, 0},
+    {"trace",           MEMORY_REGION_PSRAM,    MEMORY_REGION_INTERNAL, 0},
+};
+
+static const char* const kRegionNames[] = {"none", "internal", "dma", "psram"};
+
+static MemoryPlacementRule s_rules[MEMORY_BUFFER_COUNT];
+static MemoryPlacementSource s_sources[MEMORY_BUFFER_COUNT];
+static MemoryPlacementStats s_stats[MEMORY_BUFFER_COUNT];
+static std::once_flag s_init_flag;
+static std::mutex s_stats_mutex;
+
+static int FindRegion(const char* name, size_t length) {
+    for (int i = 0; i < (int)(sizeof(kRegionNames) / sizeof(kRegionNames[0])); i++) {
+        if (strlen(kRegionNames[i]) == length && strncmp(kRegionNames[i], name, length) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int FindBufferClass(const char* name, size_t length) {
+    for (int i = 0; i < MEMORY_BUFFER_COUNT; i++) {
+        if (strlen(kDefaultRules[i].name) == length && strncmp(kDefaultRules[i].name, name, length) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// 解析 "name=region[:fallback],..."
+static void ApplyBoardOverrides(const char* overrides) {
+    const char* item = overrides;
+    while (*item != '\0') {
+        const char* end = strchr(item, ',');
+        size_t length = end != nullptr ? end - item : strlen(item);
+        const char* equal = (const char*)memchr(item, '=', length);
+        if (equal != nullptr) {
+            const char* colon = (const char*)memchr(equal, ':', item + length - equal);
+            const char* region_end = colon != nullptr ? colon : item + length;
+            int buffer_class = FindBufferClass(item, equal - item);
+            int preferred = FindRegion(equal + 1, region_end - equal - 1);
+            int fallback = colon != nullptr ? FindRegion(colon + 1, item + length - colon - 1) : -1;
+            if (buffer_class >= 0 && preferred > MEMORY_REGION_NONE) {
+                s_rules[buffer_class].preferred = (memory_region_t)preferred;
+                if (fallback >= 0) {
+                    s_rules[buffer_class].fallback = (memory_region_t)fallback;
+                }
+                s_sources[buffer_class] = kPlacementSourceBoard;
+            } else {
+                ESP_LOGW(TAG, "Invalid placement override: %.*s", (int)length, item);
+            }
+        }
+        item += length;
+        if (*item == ',') {
+            item++;
+        }
+    }
+}
+
+static void InitializeRules() {
+    memcpy(s_rules, kDefaultRules, sizeof(s_rules));
+    ApplyBoardOverrides(CONFIG_MEMORY_PLACEMENT_OVERRIDES);
+
+    Settings settings("placement");
+    for (int i = 0; i < MEMORY_BUFFER_COUNT; i++) {
+        int region = settings.GetInt(s_rules[i].name, MEMORY_REGION_NONE);
+        if (region > MEMORY_REGION_NONE && region <= MEMORY_REGION_PSRAM) {
+            s_rules[i].preferred = (memory_region_t)region;
+            s_sources[i] = kPlacementSourceNvs;
+        }
+    }
+
+#if !CONFIG_SPIRAM
+    for (auto& rule : s_rules) {
+        if (rule.preferred == MEMORY_REGION_PSRAM) {
+            rule.preferred = MEMORY_REGION_INTERNAL;
+        }
+        if (rule.fallback == MEMORY_REGION_PSRAM || rule.fallback == rule.preferred) {
+            rule.fallback = MEMORY_REGION_NONE;
+        }
+    }
+#endif
+}
+
+static const MemoryPlacementRule& GetRule(memory_buffer_class_t buffer_class) {
+    std::call_once(s_init_flag, InitializeRules);
+    return s_rules[buffer_class];
+}
+
+static uint32_t GetCaps(memory_region_t region) {
+    switch (region) {
+    case MEMORY_REGION_DMA:
+        return MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+    case MEMORY_REGION_PSRAM:
+        return MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
+    default:
+        return MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+    }
+}
+
+static void* Allocate(const MemoryPlacementRule& rule, memory_region_t region, size_t size) {
+    if (rule.alignment > 0) {
+        return heap_caps_aligned_alloc(rule.alignment, size, GetCaps(region));
+    }
+    return heap_caps_malloc(size, GetCaps(region));
+}
+
+extern "C" void* memory_placement_malloc(memory_buffer_class_t buffer_class, size_t size) {
+    auto& rule = GetRule(buffer_class);
+    bool fallback = false;
+    void* ptr = Allocate(rule, rule.preferred, size);
+    if (ptr == nullptr && rule.fallback != MEMORY_REGION_NONE) {
+        ptr = Allocate(rule, rule.fallback, size);
+        fallback = ptr != nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(s_stats_mutex);
+    auto& stats = s_stats[buffer_class];
+    if (ptr == nullptr) {
+        stats.failures++;
+        ESP_LOGE(TAG, "Failed to allocate %u bytes for %s", (unsigned)size, rule.name);
+        return nullptr;
+    }
+    stats.allocations++;
+    if (fallback) {
+        stats.fallbacks++;
+        ESP_LOGW(TAG, "%s: %u bytes fell back to %s", rule.name, (unsigned)size, kRegionNames[rule.fallback]);
+    }
+    if (esp_ptr_external_ram(ptr)) {
+        stats.psram_bytes += size;
+    } else {
+        stats.internal_bytes += size;
+    }
+    return ptr;
+}
+
+extern "C" void* memory_placement_calloc(memory_buffer_class_t buffer_class, size_t count, size_t size) {
+    void* ptr = memory_placement_malloc(buffer_class, count * size);
+    if (ptr != nullptr) {
+        memset(ptr, 0, count * size);
+    }
+    return ptr;
+}
+
+extern "C" void memory_placement_free(void* ptr) {
+    heap_caps_free(ptr);
+}
+
+extern "C" memory_region_t memory_placement_region(memory_buffer_class_t buffer_class) {
+    return GetRule(buffer_class).preferred;
+}
+
+extern "C" void memory_placement_print(void) {
+    static const char* const kSourceNames[] = {"default", "board", "nvs"};
+    std::call_once(s_init_flag, InitializeRules);
+    std::lock_guard<std::mutex> lock(s_stats_mutex);
+    ESP_LOGI(TAG, "%-16s %-8s %-8s %-7s %5s %5s %8s %8s", "buffer", "prefer", "fallback", "source",
+        "count", "fail", "internal", "psram");
+    for (int i = 0; i < MEMORY_BUFFER_COUNT; i++) {
+        auto& rule = s_rules[i];
+        auto& stats = s_stats[i];
+        ESP_LOGI(TAG, "%-16s %-8s %-8s %-7s %5lu %5lu %8lu %8lu", rule.name, kRegionNames[rule.preferred],
+            kRegionNames[rule.fallback], kSourceNames[s_sources[i]], stats.allocations, stats.failures,
+            stats.internal_bytes, stats.psram_bytes);
+    }
+}
+
+extern "C" void memory_placement_register_console_command(void) {
+    const esp_console_cmd_t cmd = {
+        .command = "placement",
+        .help = "Show memory placement of large buffers, or set the preferred memory: placement [buffer internal|dma|psram|default]",
+        .hint = nullptr,
+        .func = [](int argc, char** argv) -> int {
+            if (argc < 3) {
+                memory_placement_print();
+                return 0;
+            }
+            int buffer_class = FindBufferClass(argv[1], strlen(argv[1]));
+            if (buffer_class < 0) {
+                printf("Unknown buffer: %s\n", argv[1]);
+                return 1;
+            }
+            Settings settings("placement", true);
+            if (strcmp(argv[2], "default") == 0) {
+                settings.EraseKey(argv[1]);
+            } else {
+                int region = FindRegion(argv[2], strlen(argv[2]));
+                if (region <= MEMORY_REGION_NONE) {
+                    printf("Unknown memory: %s\n", argv[2]);
+                    return 1;
+                }
+                settings.SetInt(argv[1], region);
+            }
+            printf("Saved, reboot to take effect\n");
+            return 0;
+        },
+        .argtable = nullptr,
+    };
+    esp_err_t ret = esp_console_cmd_register(&cmd);
+    if (ret != ESP_OK) {
+        ESP_LOGD(TAG, "Console is not available: %s", esp_err_to_name(ret));
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef MEMORY_PLACEMENT_H
+#define MEMORY_PLACEMENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+
+/*
+ * 大块缓冲的内存放置策略。每一类缓冲在表中登记首选和回退的内存 (内部 RAM、DMA、PSRAM) 及对齐，
+ * 分配时先尝试首选内存，失败再用回退内存，并统计实际放置的位置，启动完成后打印，便于调整内部 RAM 压力。
+ *
+ * 默认表见 memory_placement.cc，各芯片共用，只有 SD 卡读取缓冲的对齐按芯片区分。覆盖的优先级从低到高：
+ *   1. 板卡在 config.json 的 sdkconfig_append 中设置 CONFIG_MEMORY_PLACEMENT_OVERRIDES，
+ *      例如 "eye_frame=internal,mjpeg_cache=psram:none"，冒号后为回退内存
+ *   2. NVS 命名空间 placement 中以缓冲名为键的首选内存，可以用串口命令 placement <名称> <内存> 修改，重启后生效
+ * 没有 PSRAM 的芯片上 PSRAM 自动替换为内部 RAM。C 文件 (如 MJPEG 播放器) 也可以使用。
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    MEMORY_BUFFER_EYE_FRAME,        // 眼球动画渲染和缩放缓冲
+    MEMORY_BUFFER_EYE_CANVAS,       // 眼球动画的 LVGL 画布
+    MEMORY_BUFFER_DISPLAY_DRAW,     // LVGL 绘制缓冲，由 esp_lvgl_port 分配，只决定 DMA / PSRAM 标志
+    MEMORY_BUFFER_IMAGE,            // 聊天消息中的图片副本
+    MEMORY_BUFFER_CAMERA_PREVIEW,   // 摄像头预览图
+    MEMORY_BUFFER_MJPEG_CACHE,      // MJPEG 播放器的帧缓存
+    MEMORY_BUFFER_MJPEG_READ,       // MJPEG 文件读取的对齐缓冲
+    MEMORY_BUFFER_WAKE_WORD_STACK,  // 唤醒词编码任务的栈
+    MEMORY_BUFFER_AFE,              // AFE 内部缓冲，由 esp-sr 分配，只决定 memory_alloc_mode
+    MEMORY_BUFFER_POSTURE_IMAGE,    // 坐姿检测的图像转换缓冲
+    MEMORY_BUFFER_SESSION_RECORD,   // 会话录制缓冲
+    MEMORY_BUFFER_PROFILER,         // 任务剖析历史
+    MEMORY_BUFFER_TRACE,            // 时间线追踪的事件环形缓冲
+    MEMORY_BUFFER_COUNT,
+} memory_buffer_class_t;
+
+typedef enum {
+    MEMORY_REGION_NONE,             // 仅用于回退，表示不回退
+    MEMORY_REGION_INTERNAL,
+    MEMORY_REGION_DMA,
+    MEMORY_REGION_PSRAM,
+} memory_region_t;
+
+void* memory_placement_malloc(memory_buffer_class_t buffer_class, size_t size);
+void* memory_placement_calloc(memory_buffer_class_t buffer_class, size_t count, size_t size);
+void memory_placement_free(void* ptr);
+// 由其它库分配的缓冲 (LVGL、AFE) 只查询首选内存
+memory_region_t memory_placement_region(memory_buffer_class_t buffer_class);
+// 打印每一类缓冲的策略和实际放置情况
+void memory_placement_print(void);
+void memory_placement_register_console_command(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MEMORY_PLACEMENT_H
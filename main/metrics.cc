@@ -0,0 +1,172 @@
+#include "metrics.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <cJSON.h>
+
+#include <cstring>
+
+#define TAG "Metrics"
+
+#define METRICS_LOG_LINE_SIZE 512
+
+uint32_t MetricHistogram::Average() const {
+    uint32_t count = this->count();
+    return count > 0 ? sum_.load(std::memory_order_relaxed) / count : 0;
+}
+
+uint32_t MetricHistogram::Percentile(uint32_t percent) const {
+    uint32_t total = count();
+    uint32_t count = 0;
+    for (int bucket = 0; bucket < bucket_count_ - 1; bucket++) {
+        count += buckets_[bucket].load(std::memory_order_relaxed);
+        if ((uint64_t)count * 100 >= (uint64_t)total * percent) {
+            return bounds_[bucket];
+        }
+    }
+    return max();
+}
+
+MetricCounter* MetricsRegistry::AddCounter(const char* name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int count = counter_count_.load(std::memory_order_relaxed);
+    for (int i = 0; i < count; i++) {
+        if (strcmp(counters_[i].name_, name) == 0) {
+            return &counters_[i];
+        }
+    }
+    if (count == METRICS_MAX_COUNTERS) {
+        ESP_LOGE(TAG, "Too many counters, %s is not registered", name);
+        return &unused_counter_;
+    }
+    counters_[count].name_ = name;
+    last_counter_values_[count] = 0;
+    counter_count_.store(count + 1, std::memory_order_release);
+    return &counters_[count];
+}
+
+MetricGauge* MetricsRegistry::AddGauge(const char* name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int count = gauge_count_.load(std::memory_order_relaxed);
+    for (int i = 0; i < count; i++) {
+        if (strcmp(gauges_[i].name_, name) == 0) {
+            return &gauges_[i];
+        }
+    }
+    if (count == METRICS_MAX_GAUGES) {
+        ESP_LOGE(TAG, "Too many gauges, %s is not registered", name);
+        return &unused_gauge_;
+    }
+    gauges_[count].name_ = name;
+    gauge_count_.store(count + 1, std::memory_order_release);
+    return &gauges_[count];
+}
+
+MetricHistogram* MetricsRegistry::AddHistogram(const char* name, std::initializer_list<uint32_t> bounds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int count = histogram_count_.load(std::memory_order_relaxed);
+    for (int i = 0; i < count; i++) {
+        if (strcmp(histograms_[i].name_, name) == 0) {
+            return &histograms_[i];
+        }
+    }
+    if (count == METRICS_MAX_HISTOGRAMS || bounds.size() > METRICS_MAX_BUCKETS - 1) {
+        ESP_LOGE(TAG, "Too many histograms or buckets, %s is not registered", name);
+        return &unused_histogram_;
+    }
+    auto& histogram = histograms_[count];
+    histogram.name_ = name;
+    histogram.bucket_count_ = bounds.size() + 1;
+    int i = 0;
+    for (uint32_t bound : bounds) {
+        histogram.bounds_[i++] = bound;
+    }
+    histogram_count_.store(count + 1, std::memory_order_release);
+    return &histogram;
+}
+
+std::string MetricsRegistry::GetJson() {
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "uptime_ms", esp_timer_get_time() / 1000);
+
+    cJSON* counters = cJSON_CreateObject();
+    int counter_count = counter_count_.load(std::memory_order_acquire);
+    for (int i = 0; i < counter_count; i++) {
+        cJSON_AddNumberToObject(counters, counters_[i].name_, counters_[i].Get());
+    }
+    cJSON_AddItemToObject(root, "counters", counters);
+
+    cJSON* gauges = cJSON_CreateObject();
+    int gauge_count = gauge_count_.load(std::memory_order_acquire);
+    for (int i = 0; i < gauge_count; i++) {
+        cJSON_AddNumberToObject(gauges, gauges_[i].name_, gauges_[i].Get());
+    }
+    cJSON_AddItemToObject(root, "gauges", gauges);
+
+    cJSON* histograms = cJSON_CreateObject();
+    int histogram_count = histogram_count_.load(std::memory_order_acquire);
+    for (int i = 0; i < histogram_count; i++) {
+        auto& histogram = histograms_[i];
+        cJSON* item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "count", histogram.count());
+        cJSON_AddNumberToObject(item, "avg", histogram.Average());
+        cJSON_AddNumberToObject(item, "p50", histogram.Percentile(50));
+        cJSON_AddNumberToObject(item, "p90", histogram.Percentile(90));
+        cJSON_AddNumberToObject(item, "p99", histogram.Percentile(99));
+        cJSON_AddNumberToObject(item, "max", histogram.max());
+        cJSON_AddItemToObject(histograms, histogram.name_, item);
+    }
+    cJSON_AddItemToObject(root, "histograms", histograms);
+
+    char* json = cJSON_PrintUnformatted(root);
+    std::string result(json);
+    cJSON_free(json);
+    cJSON_Delete(root);
+    return result;
+}
+
+void MetricsRegistry::LogSummary() {
+    char line[METRICS_LOG_LINE_SIZE];
+    int length = 0;
+    auto append = [&line, &length](const char* format, auto... args) {
+        if (length < METRICS_LOG_LINE_SIZE) {
+            length += snprintf(line + length, METRICS_LOG_LINE_SIZE - length, format, args...);
+        }
+    };
+
+    int64_t now = esp_timer_get_time();
+    uint32_t elapsed_ms = last_log_time_us_ > 0 ? (now - last_log_time_us_) / 1000 : now / 1000;
+    last_log_time_us_ = now;
+
+    int counter_count = counter_count_.load(std::memory_order_acquire);
+    for (int i = 0; i < counter_count; i++) {
+        uint32_t value = counters_[i].Get();
+        uint32_t delta = value - last_counter_values_[i];
+        last_counter_values_[i] = value;
+        if (delta == 0 || elapsed_ms == 0) {
+            continue;
+        }
+        // 保留一位小数
+        uint32_t rate = (uint64_t)delta * 10000 / elapsed_ms;
+        append(" %s=%lu.%lu/s", counters_[i].name_, (unsigned long)(rate / 10), (unsigned long)(rate % 10));
+    }
+
+    int gauge_count = gauge_count_.load(std::memory_order_acquire);
+    for (int i = 0; i < gauge_count; i++) {
+        append(" %s=%ld", gauges_[i].name_, (long)gauges_[i].Get());
+    }
+
+    int histogram_count = histogram_count_.load(std::memory_order_acquire);
+    for (int i = 0; i < histogram_count; i++) {
+        auto& histogram = histograms_[i];
+        if (histogram.count() == 0) {
+            continue;
+        }
+        append(" %s=p50:%lu/p99:%lu/max:%lu", histogram.name_, (unsigned long)histogram.Percentile(50),
+            (unsigned long)histogram.Percentile(99), (unsigned long)histogram.max());
+    }
+
+    if (length > 0) {
+        ESP_LOGI(TAG, "%s", line + 1);
+    }
+}
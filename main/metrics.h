@@ -0,0 +1,115 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+
+/*
+ * 统一的性能指标：计数器、数值和固定分桶的直方图。
+ *
+ * 指标在启动时注册，对象放在注册表内的固定数组中，注册之后不再分配内存；
+ * 更新只是一次原子操作，可以在任意任务中调用。名字必须是字符串常量，重复注册返回同一个指标。
+ * 可通过 MCP 工具 self.system.get_metrics 读取，时钟定时器每 10 秒打印一行汇总，计数器显示为每秒速率。
+ */
+#define METRICS_MAX_COUNTERS 32
+#define METRICS_MAX_GAUGES 16
+#define METRICS_MAX_HISTOGRAMS 8
+#define METRICS_MAX_BUCKETS 12
+
+class MetricCounter {
+public:
+    void Add(uint32_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    uint32_t Get() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    friend class MetricsRegistry;
+    const char* name_ = nullptr;
+    std::atomic<uint32_t> value_{0};
+};
+
+class MetricGauge {
+public:
+    void Set(int32_t value) { value_.store(value, std::memory_order_relaxed); }
+    void Add(int32_t n) { value_.fetch_add(n, std::memory_order_relaxed); }
+    int32_t Get() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    friend class MetricsRegistry;
+    const char* name_ = nullptr;
+    std::atomic<int32_t> value_{0};
+};
+
+class MetricHistogram {
+public:
+    void Record(uint32_t value) {
+        int bucket = 0;
+        while (bucket < bucket_count_ - 1 && value > bounds_[bucket]) {
+            bucket++;
+        }
+        buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+        uint32_t max = max_.load(std::memory_order_relaxed);
+        while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint32_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint32_t max() const { return max_.load(std::memory_order_relaxed); }
+    uint32_t Average() const;
+    // 返回分位数所在桶的上界，落在最后一个桶时返回最大值
+    uint32_t Percentile(uint32_t percent) const;
+
+private:
+    friend class MetricsRegistry;
+    const char* name_ = nullptr;
+    int bucket_count_ = 1;
+    uint32_t bounds_[METRICS_MAX_BUCKETS - 1] = {};     // 第 i 个桶统计 <= bounds_[i] 的值，最后一个桶统计其余
+    std::atomic<uint32_t> buckets_[METRICS_MAX_BUCKETS] = {};
+    std::atomic<uint32_t> count_{0};
+    std::atomic<uint32_t> sum_{0};
+    std::atomic<uint32_t> max_{0};
+};
+
+class MetricsRegistry {
+public:
+    static MetricsRegistry& GetInstance() {
+        static MetricsRegistry instance;
+        return instance;
+    }
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    // 注册表满时返回一个不会被输出的占位指标，调用者不需要判空
+    MetricCounter* AddCounter(const char* name);
+    MetricGauge* AddGauge(const char* name);
+    // bounds 为递增的桶上界，最多 METRICS_MAX_BUCKETS - 1 个
+    MetricHistogram* AddHistogram(const char* name, std::initializer_list<uint32_t> bounds);
+
+    std::string GetJson();
+    // 打印一行汇总，计数器为距上次打印的每秒速率，没有变化的计数器不打印
+    void LogSummary();
+
+private:
+    MetricsRegistry() = default;
+
+    std::mutex mutex_;
+    MetricCounter counters_[METRICS_MAX_COUNTERS];
+    MetricGauge gauges_[METRICS_MAX_GAUGES];
+    MetricHistogram histograms_[METRICS_MAX_HISTOGRAMS];
+    std::atomic<int> counter_count_{0};
+    std::atomic<int> gauge_count_{0};
+    std::atomic<int> histogram_count_{0};
+
+    MetricCounter unused_counter_;
+    MetricGauge unused_gauge_;
+    MetricHistogram unused_histogram_;
+
+    uint32_t last_counter_values_[METRICS_MAX_COUNTERS] = {};
+    int64_t last_log_time_us_ = 0;
+};
+
+#endif // METRICS_H
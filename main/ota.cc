@@ -97,14 +97,13 @@ bool Ota::CheckVersion() {
     }
 
     auto status_code = http->GetStatusCode();
+    data = http->ReadAll();
+    http->Close();
     if (status_code != 200) {
         ESP_LOGE(TAG, "Failed to check version, status code: %d", status_code);
         return false;
     }
 
-    data = http->ReadAll();
-    http->Close();
-
     // Response: { "firmware": { "version": "1.0.0", "url": "http://" } }
     // Parse the JSON response and check if the version is newer
     // If it is, set has_new_version_ to true and store the new version and URL
@@ -462,12 +461,15 @@ esp_err_t Ota::Activate() {
         return ESP_FAIL;
     }
     
+    // 每种状态都读完响应再关闭，激活轮询才能复用同一条连接
     auto status_code = http->GetStatusCode();
+    auto body = http->ReadAll();
+    http->Close();
     if (status_code == 202) {
         return ESP_ERR_TIMEOUT;
     }
     if (status_code != 200) {
-        ESP_LOGE(TAG, "Failed to activate, code: %d, body: %s", status_code, http->ReadAll().c_str());
+        ESP_LOGE(TAG, "Failed to activate, code: %d, body: %s", status_code, body.c_str());
         return ESP_FAIL;
     }
 
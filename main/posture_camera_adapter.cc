@@ -1,4 +1,5 @@
 #include "posture_camera_adapter.h"
+#include "memory_placement.h"
 #include <esp_log.h>
 #include <cstring>
 #include <algorithm>
@@ -13,7 +14,7 @@ PostureCameraAdapter::PostureCameraAdapter(std::shared_ptr<Camera> camera)
 PostureCameraAdapter::~PostureCameraAdapter() {
     ReleaseFrameBuffer();
     if (conversion_buffer_) {
-        free(conversion_buffer_);
+        memory_placement_free(conversion_buffer_);
         conversion_buffer_ = nullptr;
     }
 }
@@ -26,7 +27,7 @@ bool PostureCameraAdapter::Initialize() {
     
     // 分配转换缓冲区（用于格式转换和缩放）
     conversion_buffer_size_ = frame_width_ * frame_height_ * frame_channels_;
-    conversion_buffer_ = (uint8_t*)malloc(conversion_buffer_size_);
+    conversion_buffer_ = (uint8_t*)memory_placement_malloc(MEMORY_BUFFER_POSTURE_IMAGE, conversion_buffer_size_);
     
     if (!conversion_buffer_) {
         ESP_LOGE(TAG, "无法分配转换缓冲区");
@@ -1,4 +1,6 @@
 #include "posture_service.h"
+#include "timeline_trace.h"
+#include "task_planner.h"
 #include <esp_log.h>
 #include <esp_timer.h>
 #include <cstring>
@@ -13,6 +15,12 @@
 const char* PostureService::TAG = "PostureService";
 
 PostureService::PostureService() : detector_(std::make_unique<PostureDetector>()) {
+    auto& metrics = MetricsRegistry::GetInstance();
+    detections_counter_ = metrics.AddCounter("posture.detections");
+    good_posture_counter_ = metrics.AddCounter("posture.good");
+    bad_posture_counter_ = metrics.AddCounter("posture.bad");
+    alerts_counter_ = metrics.AddCounter("posture.alerts");
+    inference_histogram_ = metrics.AddHistogram("posture.inference_ms", {50, 100, 200, 300, 500, 1000, 2000});
     ESP_LOGI(TAG, "坐姿检测服务创建");
 }
 
@@ -64,12 +72,12 @@ bool PostureService::Start() {
     is_running_ = true;
     
     // 创建检测任务
-    BaseType_t result = xTaskCreate(
+    BaseType_t result = TaskPlanner::GetInstance().CreateTask(
+        kTaskRolePosture,
         DetectionTask,
         "posture_detection",
         8192,  // 栈大小
         this,
-        5,     // 优先级
         &detection_task_handle_
     );
     
@@ -153,12 +161,20 @@ PostureResult PostureService::GetLatestResult() const {
 
 PostureService::Statistics PostureService::GetStatistics() const {
     std::lock_guard<std::mutex> lock(stats_mutex_);
-    return statistics_;
+    Statistics statistics;
+    statistics.total_detections = detections_counter_->Get() - statistics_baseline_.total_detections;
+    statistics.good_posture_count = good_posture_counter_->Get() - statistics_baseline_.good_posture_count;
+    statistics.bad_posture_count = bad_posture_counter_->Get() - statistics_baseline_.bad_posture_count;
+    statistics.alerts_triggered = alerts_counter_->Get() - statistics_baseline_.alerts_triggered;
+    return statistics;
 }
 
 void PostureService::ResetStatistics() {
     std::lock_guard<std::mutex> lock(stats_mutex_);
-    statistics_ = Statistics{};
+    statistics_baseline_.total_detections = detections_counter_->Get();
+    statistics_baseline_.good_posture_count = good_posture_counter_->Get();
+    statistics_baseline_.bad_posture_count = bad_posture_counter_->Get();
+    statistics_baseline_.alerts_triggered = alerts_counter_->Get();
     ESP_LOGI(TAG, "统计信息已重置");
 }
 
@@ -174,7 +190,11 @@ void PostureService::RunDetection() {
     
     while (is_running_) {
         if (config_.enable_detection) {
+            TRACE_BEGIN("posture_inference");
+            int64_t start_time = esp_timer_get_time();
             PostureResult result = DetectPosture();
+            inference_histogram_->Record((esp_timer_get_time() - start_time) / 1000);
+            TRACE_END("posture_inference");
             ProcessResult(result);
             
             // 调用回调函数
@@ -192,22 +212,18 @@ void PostureService::RunDetection() {
 
 void PostureService::ProcessResult(const PostureResult& result) {
     // 更新统计信息
-    {
-        std::lock_guard<std::mutex> lock(stats_mutex_);
-        statistics_.total_detections++;
+    detections_counter_->Add();
+    if (result.posture_type == PostureType::NORMAL) {
+        good_posture_counter_->Add();
+        consecutive_bad_posture_count_ = 0;  // 重置连续不良姿势计数
+    } else if (result.posture_type != PostureType::UNKNOWN) {
+        bad_posture_counter_->Add();
         
-        if (result.posture_type == PostureType::NORMAL) {
-            statistics_.good_posture_count++;
-            consecutive_bad_posture_count_ = 0;  // 重置连续不良姿势计数
-        } else if (result.posture_type != PostureType::UNKNOWN) {
-            statistics_.bad_posture_count++;
-            
-            // 检查是否是相同的不良姿势
-            if (result.posture_type == last_posture_type_) {
-                consecutive_bad_posture_count_++;
-            } else {
-                consecutive_bad_posture_count_ = 1;
-            }
+        // 检查是否是相同的不良姿势
+        if (result.posture_type == last_posture_type_) {
+            consecutive_bad_posture_count_++;
+        } else {
+            consecutive_bad_posture_count_ = 1;
         }
     }
     
@@ -221,9 +237,7 @@ void PostureService::ProcessResult(const PostureResult& result) {
         if (current_time - last_alert_time_ms_ >= config_.alert_interval_ms) {
             TriggerAlert(result);
             last_alert_time_ms_ = current_time;
-            
-            std::lock_guard<std::mutex> lock(stats_mutex_);
-            statistics_.alerts_triggered++;
+            alerts_counter_->Add();
         }
     }
     
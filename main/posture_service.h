@@ -5,6 +5,7 @@
 #include "boards/common/camera.h"
 #include "display/display.h"
 #include "posture_camera_adapter.h"
+#include "metrics.h"
 #include <memory>
 #include <thread>
 #include <atomic>
@@ -104,9 +105,14 @@ private:
     int consecutive_bad_posture_count_ = 0;
     uint64_t last_alert_time_ms_ = 0;
     
-    // 统计信息
+    // 统计信息，计数器在指标注册表中，重置时只记录基线
+    MetricCounter* detections_counter_;
+    MetricCounter* good_posture_counter_;
+    MetricCounter* bad_posture_counter_;
+    MetricCounter* alerts_counter_;
+    MetricHistogram* inference_histogram_;
     mutable std::mutex stats_mutex_;
-    Statistics statistics_;
+    Statistics statistics_baseline_;
     
     // 姿态检测模型
 #ifdef CONFIG_BOARD_TYPE_ESP32_P4_WIFI6_TOUCH_LCD_4B
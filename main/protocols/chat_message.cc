@@ -0,0 +1,271 @@
+#include "chat_message.h"
+
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+
+namespace {
+
+class ChatMessageScanner {
+public:
+    ChatMessageScanner(const char* json, size_t length, char* scratch, size_t scratch_size)
+        : p_(json), end_(json + length), scratch_(scratch), scratch_end_(scratch + scratch_size) {
+    }
+
+    bool Parse(ChatMessage& message) {
+        SkipSpace();
+        if (!Consume('{')) {
+            return false;
+        }
+        SkipSpace();
+        if (Consume('}')) {
+            return false;
+        }
+
+        while (true) {
+            SkipSpace();
+            std::string_view key;
+            if (!ReadString(key)) {
+                return false;
+            }
+            SkipSpace();
+            if (!Consume(':')) {
+                return false;
+            }
+            SkipSpace();
+
+            if (p_ < end_ && *p_ == '"') {
+                std::string_view value;
+                if (!ReadString(value)) {
+                    return false;
+                }
+                if (key == "type") {
+                    message.type = value;
+                } else if (key == "state") {
+                    message.state = value;
+                } else if (key == "text") {
+                    message.text = value;
+                } else if (key == "emotion") {
+                    message.emotion = value;
+                }
+            } else if (!SkipLiteral()) {
+                // Nested objects and arrays are left to cJSON
+                return false;
+            }
+
+            SkipSpace();
+            if (Consume(',')) {
+                continue;
+            }
+            if (Consume('}')) {
+                break;
+            }
+            return false;
+        }
+
+        SkipSpace();
+        return p_ == end_ || *p_ == '\0';
+    }
+
+private:
+    const char* p_;
+    const char* end_;
+    char* scratch_;
+    char* scratch_end_;
+
+    void SkipSpace() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\r' || *p_ == '\n')) {
+            p_++;
+        }
+    }
+
+    bool Consume(char c) {
+        if (p_ < end_ && *p_ == c) {
+            p_++;
+            return true;
+        }
+        return false;
+    }
+
+    // true, false and null must match exactly, numbers must follow the JSON grammar
+    bool SkipLiteral() {
+        for (const char* literal : {"true", "false", "null"}) {
+            size_t size = strlen(literal);
+            if ((size_t)(end_ - p_) >= size && memcmp(p_, literal, size) == 0) {
+                p_ += size;
+                return true;
+            }
+        }
+        return SkipNumber();
+    }
+
+    bool SkipDigits() {
+        const char* start = p_;
+        while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+            p_++;
+        }
+        return p_ > start;
+    }
+
+    bool SkipNumber() {
+        Consume('-');
+        if (!Consume('0') && !SkipDigits()) {
+            return false;
+        }
+        if (Consume('.') && !SkipDigits()) {
+            return false;
+        }
+        if (Consume('e') || Consume('E')) {
+            if (!Consume('+')) {
+                Consume('-');
+            }
+            if (!SkipDigits()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static int HexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    bool ReadHex4(uint32_t& value) {
+        if (end_ - p_ < 4) {
+            return false;
+        }
+        value = 0;
+        for (int i = 0; i < 4; i++) {
+            int digit = HexValue(*p_++);
+            if (digit < 0) {
+                return false;
+            }
+            value = (value << 4) | digit;
+        }
+        return true;
+    }
+
+    bool PutUtf8(char*& out, uint32_t code) {
+        char buffer[4];
+        int size;
+        if (code < 0x80) {
+            buffer[0] = code;
+            size = 1;
+        } else if (code < 0x800) {
+            buffer[0] = 0xC0 | (code >> 6);
+            buffer[1] = 0x80 | (code & 0x3F);
+            size = 2;
+        } else if (code < 0x10000) {
+            buffer[0] = 0xE0 | (code >> 12);
+            buffer[1] = 0x80 | ((code >> 6) & 0x3F);
+            buffer[2] = 0x80 | (code & 0x3F);
+            size = 3;
+        } else {
+            buffer[0] = 0xF0 | (code >> 18);
+            buffer[1] = 0x80 | ((code >> 12) & 0x3F);
+            buffer[2] = 0x80 | ((code >> 6) & 0x3F);
+            buffer[3] = 0x80 | (code & 0x3F);
+            size = 4;
+        }
+        if (scratch_end_ - out < size) {
+            return false;
+        }
+        memcpy(out, buffer, size);
+        out += size;
+        return true;
+    }
+
+    bool ReadString(std::string_view& value) {
+        if (!Consume('"')) {
+            return false;
+        }
+        // Fast path: most strings have no escapes and are returned in place
+        const char* start = p_;
+        while (p_ < end_ && *p_ != '"' && *p_ != '\\') {
+            p_++;
+        }
+        if (p_ >= end_) {
+            return false;
+        }
+        if (*p_ == '"') {
+            value = std::string_view(start, p_ - start);
+            p_++;
+            return true;
+        }
+
+        // Slow path: decode into the scratch buffer
+        char* out = scratch_;
+        size_t prefix = p_ - start;
+        if ((size_t)(scratch_end_ - out) < prefix) {
+            return false;
+        }
+        memcpy(out, start, prefix);
+        out += prefix;
+
+        while (p_ < end_ && *p_ != '"') {
+            char c = *p_++;
+            if (c != '\\') {
+                if (out >= scratch_end_) {
+                    return false;
+                }
+                *out++ = c;
+                continue;
+            }
+            if (p_ >= end_) {
+                return false;
+            }
+            c = *p_++;
+            uint32_t code;
+            switch (c) {
+            case '"': case '\\': case '/': code = c; break;
+            case 'b': code = '\b'; break;
+            case 'f': code = '\f'; break;
+            case 'n': code = '\n'; break;
+            case 'r': code = '\r'; break;
+            case 't': code = '\t'; break;
+            case 'u':
+                if (!ReadHex4(code)) {
+                    return false;
+                }
+                // UTF-16 surrogate pair, e.g. emoji
+                if (code >= 0xD800 && code <= 0xDBFF) {
+                    uint32_t low;
+                    if (end_ - p_ < 6 || p_[0] != '\\' || p_[1] != 'u') {
+                        return false;
+                    }
+                    p_ += 2;
+                    if (!ReadHex4(low) || low < 0xDC00 || low > 0xDFFF) {
+                        return false;
+                    }
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                break;
+            default:
+                return false;
+            }
+            if (!PutUtf8(out, code)) {
+                return false;
+            }
+        }
+        if (!Consume('"')) {
+            return false;
+        }
+        value = std::string_view(scratch_, out - scratch_);
+        scratch_ = out;
+        return true;
+    }
+};
+
+} // namespace
+
+bool ParseChatMessage(const char* json, size_t length, ChatMessage& message, char* scratch, size_t scratch_size) {
+    message = ChatMessage();
+    ChatMessageScanner scanner(json, length, scratch, scratch_size);
+    if (!scanner.Parse(message)) {
+        return false;
+    }
+    return message.type == "tts" || message.type == "stt" || message.type == "llm";
+}
@@ -0,0 +1,24 @@
+#ifndef _CHAT_MESSAGE_H_
+#define _CHAT_MESSAGE_H_
+
+#include <cstddef>
+#include <string_view>
+
+/*
+ * 每轮对话中 tts / stt / llm 消息出现次数最多，且结构都是一层的 JSON:
+ *   {"type":"tts","state":"sentence_start","text":"...","session_id":"..."}
+ *
+ * ParseChatMessage 直接扫描文本取出 type / state / text / emotion，
+ * 不构建 cJSON 树也不分配内存。字符串字段指向原始数据，含转义时解码到 scratch。
+ * 遇到嵌套对象、数组或其他类型的消息返回 false，由调用方回退到 cJSON。
+ */
+struct ChatMessage {
+    std::string_view type;
+    std::string_view state;
+    std::string_view text;
+    std::string_view emotion;
+};
+
+bool ParseChatMessage(const char* json, size_t length, ChatMessage& message, char* scratch, size_t scratch_size);
+
+#endif // _CHAT_MESSAGE_H_
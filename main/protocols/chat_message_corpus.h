@@ -0,0 +1,24 @@
+#ifndef _CHAT_MESSAGE_CORPUS_H_
+#define _CHAT_MESSAGE_CORPUS_H_
+
+/*
+ * 一轮对话中服务器下发的 stt / llm / tts 消息，格式与服务器实际发送的一致，
+ * 供设备和主机上的 chat_parse / chat_cjson 基准测试使用。
+ * 前半轮中文直接以 UTF-8 发送，后半轮按 Python json.dumps 的默认行为转义为 \uXXXX。
+ */
+static const char* const kChatMessageCorpus[] = {
+    "{\"type\":\"stt\",\"text\":\"今天北京天气怎么样\",\"session_id\":\"5f0c7a3e-2b1d-4e8a-9c6f-3d2e1b0a9f87\"}",
+    "{\"type\":\"llm\",\"text\":\"😊\",\"emotion\":\"happy\",\"session_id\":\"5f0c7a3e-2b1d-4e8a-9c6f-3d2e1b0a9f87\"}",
+    "{\"type\":\"tts\",\"state\":\"start\",\"sample_rate\":24000,\"session_id\":\"5f0c7a3e-2b1d-4e8a-9c6f-3d2e1b0a9f87\"}",
+    "{\"type\":\"tts\",\"state\":\"sentence_start\",\"text\":\"今天北京晴，气温十五到二十五度。\",\"session_id\":\"5f0c7a3e-2b1d-4e8a-9c6f-3d2e1b0a9f87\"}",
+    "{\"type\":\"tts\",\"state\":\"sentence_end\",\"text\":\"今天北京晴，气温十五到二十五度。\",\"session_id\":\"5f0c7a3e-2b1d-4e8a-9c6f-3d2e1b0a9f87\"}",
+    "{\"type\":\"tts\",\"state\":\"sentence_start\",\"text\":\"早晚温差比较大，出门记得带件外套哦！\",\"session_id\":\"5f0c7a3e-2b1d-4e8a-9c6f-3d2e1b0a9f87\"}",
+    "{\"type\":\"tts\",\"state\":\"sentence_end\",\"text\":\"早晚温差比较大，出门记得带件外套哦！\",\"session_id\":\"5f0c7a3e-2b1d-4e8a-9c6f-3d2e1b0a9f87\"}",
+    "{\"type\": \"stt\", \"text\": \"\\u90a3\\u660e\\u5929\\u5462\", \"session_id\": \"5f0c7a3e-2b1d-4e8a-9c6f-3d2e1b0a9f87\"}",
+    "{\"type\": \"llm\", \"text\": \"\\ud83e\\udd14\", \"emotion\": \"thinking\", \"session_id\": \"5f0c7a3e-2b1d-4e8a-9c6f-3d2e1b0a9f87\"}",
+    "{\"type\": \"tts\", \"state\": \"sentence_start\", \"text\": \"\\u660e\\u5929\\u591a\\u4e91\\u8f6c\\u9634\\uff0c\\u53ef\\u80fd\\u6709\\u5c0f\\u96e8\\u3002\", \"session_id\": \"5f0c7a3e-2b1d-4e8a-9c6f-3d2e1b0a9f87\"}",
+    "{\"type\": \"tts\", \"state\": \"sentence_end\", \"text\": \"\\u660e\\u5929\\u591a\\u4e91\\u8f6c\\u9634\\uff0c\\u53ef\\u80fd\\u6709\\u5c0f\\u96e8\\u3002\", \"session_id\": \"5f0c7a3e-2b1d-4e8a-9c6f-3d2e1b0a9f87\"}",
+    "{\"type\": \"tts\", \"state\": \"stop\", \"session_id\": \"5f0c7a3e-2b1d-4e8a-9c6f-3d2e1b0a9f87\"}",
+};
+
+#endif // _CHAT_MESSAGE_CORPUS_H_
@@ -0,0 +1,236 @@
+#include "loopback_protocol.h"
+#include "application.h"
+#include "system_info.h"
+
+#include <cstring>
+#include <cJSON.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#define TAG "Loopback"
+
+LoopbackProtocol::LoopbackProtocol() {
+    command_queue_ = xQueueCreate(4, sizeof(LoopbackCommand));
+}
+
+LoopbackProtocol::~LoopbackProtocol() {
+    if (server_task_handle_ != nullptr) {
+        vTaskDelete(server_task_handle_);
+    }
+    vQueueDelete(command_queue_);
+}
+
+bool LoopbackProtocol::Start() {
+    if (server_task_handle_ != nullptr) {
+        return true;
+    }
+
+    // The server task plays the role of the network stack, so incoming messages
+    // arrive on another task just like the websocket / udp callbacks
+    xTaskCreate([](void* arg) {
+        LoopbackProtocol* protocol = (LoopbackProtocol*)arg;
+        protocol->ServerTask();
+    }, "loopback_server", 4096, this, 4, &server_task_handle_);
+    ESP_LOGI(TAG, "Loopback server started, turn duration: %d ms", CONFIG_LOOPBACK_TURN_DURATION_MS);
+    return true;
+}
+
+bool LoopbackProtocol::SendAudio(std::unique_ptr<AudioStreamPacket> packet) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!channel_opened_) {
+        return false;
+    }
+    if (!recording_) {
+        return true;
+    }
+
+    stats_.uplink_packets++;
+    stats_.uplink_bytes += packet->payload.size();
+    recorded_packets_.push_back(std::move(packet));
+
+    // There is no server VAD here, so end the turn after a fixed duration
+    if (recorded_packets_.size() * OPUS_FRAME_DURATION_MS >= CONFIG_LOOPBACK_TURN_DURATION_MS) {
+        lock.unlock();
+        EndTurn();
+    }
+    return true;
+}
+
+bool LoopbackProtocol::SendText(const std::string& text) {
+    if (!channel_opened_) {
+        return false;
+    }
+
+    cJSON* root = cJSON_Parse(text.c_str());
+    if (root == nullptr) {
+        ESP_LOGE(TAG, "Failed to parse outgoing message: %s", text.c_str());
+        return false;
+    }
+
+    auto type = cJSON_GetObjectItem(root, "type");
+    auto state = cJSON_GetObjectItem(root, "state");
+    if (cJSON_IsString(type) && strcmp(type->valuestring, "listen") == 0 && cJSON_IsString(state)) {
+        if (strcmp(state->valuestring, "start") == 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            recorded_packets_.clear();
+            stats_ = LoopbackTurnStats();
+            stats_.listen_start_us = esp_timer_get_time();
+            recording_ = true;
+            aborted_ = false;
+#if CONFIG_LOOPBACK_PRINT_CPU_USAGE
+            LoopbackCommand command = kLoopbackCommandSampleCpu;
+            xQueueSend(command_queue_, &command, 0);
+#endif
+        } else if (strcmp(state->valuestring, "stop") == 0) {
+            EndTurn();
+        }
+    } else if (cJSON_IsString(type) && strcmp(type->valuestring, "abort") == 0) {
+        ESP_LOGI(TAG, "Abort speaking");
+        aborted_ = true;
+    } else {
+        ESP_LOGD(TAG, "Ignore message: %s", text.c_str());
+    }
+
+    cJSON_Delete(root);
+    return true;
+}
+
+bool LoopbackProtocol::IsAudioChannelOpened() const {
+    return channel_opened_ && !error_occurred_ && !IsTimeout();
+}
+
+void LoopbackProtocol::CloseAudioChannel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        channel_opened_ = false;
+        recording_ = false;
+        aborted_ = true;
+        recorded_packets_.clear();
+    }
+
+    if (on_audio_channel_closed_ != nullptr) {
+        on_audio_channel_closed_();
+    }
+}
+
+bool LoopbackProtocol::OpenAudioChannel() {
+    error_occurred_ = false;
+    // Echo the uplink packets back, so the server audio params equal the uplink params
+    server_sample_rate_ = 16000;
+    server_frame_duration_ = OPUS_FRAME_DURATION_MS;
+    last_incoming_time_ = std::chrono::steady_clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        session_id_ = "loopback-" + std::to_string(++session_count_);
+        ESP_LOGI(TAG, "Session ID: %s", session_id_.c_str());
+        channel_opened_ = true;
+    }
+
+    if (on_audio_channel_opened_ != nullptr) {
+        on_audio_channel_opened_();
+    }
+    return true;
+}
+
+void LoopbackProtocol::EndTurn() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!recording_) {
+        return;
+    }
+    recording_ = false;
+    stats_.turn_end_us = esp_timer_get_time();
+
+    LoopbackCommand command = kLoopbackCommandEndTurn;
+    if (xQueueSend(command_queue_, &command, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Command queue is full, drop turn");
+    }
+}
+
+void LoopbackProtocol::ServerTask() {
+    while (true) {
+        LoopbackCommand command;
+        if (xQueueReceive(command_queue_, &command, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if (command == kLoopbackCommandEndTurn) {
+            PlaybackTurn();
+        } else if (command == kLoopbackCommandSampleCpu) {
+            // Sample the uplink phase (AFE + Opus encoder), which is the heaviest part of a turn
+            SystemInfo::PrintTaskCpuUsage(pdMS_TO_TICKS(1000));
+        }
+    }
+}
+
+void LoopbackProtocol::ReplyJson(const std::string& json) {
+    if (!DispatchChatMessage(json.data(), json.size())) {
+        cJSON* root = cJSON_Parse(json.c_str());
+        if (on_incoming_json_ != nullptr) {
+            on_incoming_json_(root);
+        }
+        cJSON_Delete(root);
+    }
+    last_incoming_time_ = std::chrono::steady_clock::now();
+}
+
+void LoopbackProtocol::PlaybackTurn() {
+    // SendText may reset stats_ for the next turn while this one is still playing, so work on a copy
+    std::deque<std::unique_ptr<AudioStreamPacket>> packets;
+    LoopbackTurnStats stats;
+    std::string prefix;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        packets = std::move(recorded_packets_);
+        stats = stats_;
+        prefix = "{\"session_id\":\"" + session_id_ + "\",";
+    }
+
+    turn_count_++;
+    ReplyJson(prefix + "\"type\":\"stt\",\"text\":\"loopback turn " + std::to_string(turn_count_) + "\"}");
+    ReplyJson(prefix + "\"type\":\"llm\",\"emotion\":\"happy\"}");
+    ReplyJson(prefix + "\"type\":\"tts\",\"state\":\"start\"}");
+    ReplyJson(prefix + "\"type\":\"tts\",\"state\":\"sentence_start\",\"text\":\"echo " +
+        std::to_string(packets.size()) + " packets\"}");
+
+    // Pace the downlink like a real TTS stream: one packet per frame duration
+    TickType_t last_wake_time = xTaskGetTickCount();
+    while (!packets.empty()) {
+        if (aborted_ || !channel_opened_) {
+            break;
+        }
+        auto packet = std::move(packets.front());
+        packets.pop_front();
+        packet->sample_rate = server_sample_rate_;
+        packet->frame_duration = server_frame_duration_;
+
+        if (stats.first_downlink_us == 0) {
+            stats.first_downlink_us = esp_timer_get_time();
+        }
+        stats.downlink_packets++;
+        stats.downlink_bytes += packet->payload.size();
+        if (on_incoming_audio_ != nullptr) {
+            on_incoming_audio_(std::move(packet));
+        }
+        last_incoming_time_ = std::chrono::steady_clock::now();
+        vTaskDelayUntil(&last_wake_time, pdMS_TO_TICKS(server_frame_duration_));
+    }
+
+    if (channel_opened_) {
+        ReplyJson(prefix + "\"type\":\"tts\",\"state\":\"stop\"}");
+    }
+    stats.tts_stop_us = esp_timer_get_time();
+    PrintTurnStats(stats);
+}
+
+void LoopbackProtocol::PrintTurnStats(const LoopbackTurnStats& s) {
+    int64_t uplink_us = s.turn_end_us - s.listen_start_us;
+    int64_t downlink_us = s.tts_stop_us - s.first_downlink_us;
+    int turn_latency_ms = s.first_downlink_us > 0 ? (int)((s.first_downlink_us - s.turn_end_us) / 1000) : -1;
+    float uplink_pps = uplink_us > 0 ? s.uplink_packets * 1000000.0f / uplink_us : 0;
+    float downlink_pps = (s.first_downlink_us > 0 && downlink_us > 0) ? s.downlink_packets * 1000000.0f / downlink_us : 0;
+
+    ESP_LOGI(TAG, "Turn %d: latency=%dms uplink=%lu pkts/%lu bytes (%.1f pps) downlink=%lu pkts/%lu bytes (%.1f pps)%s",
+        turn_count_, turn_latency_ms, s.uplink_packets, s.uplink_bytes, uplink_pps,
+        s.downlink_packets, s.downlink_bytes, downlink_pps, aborted_.load() ? " aborted" : "");
+    SystemInfo::PrintHeapStats();
+}
@@ -0,0 +1,74 @@
+#ifndef _LOOPBACK_PROTOCOL_H_
+#define _LOOPBACK_PROTOCOL_H_
+
+
+#include "protocol.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+/*
+ * LoopbackProtocol 在设备内部模拟服务器，不依赖任何网络服务:
+ * hello -> 返回 server hello
+ * listen start -> 缓存上行 Opus 包
+ * listen stop / 达到单轮时长 -> 回复 stt / tts start / sentence_start，
+ *                               按帧间隔回放缓存的 Opus 包，最后 tts stop
+ *
+ * 每一轮结束后打印轮次延迟、上下行包速率，用于可重复的端到端性能测试。
+ */
+struct LoopbackTurnStats {
+    uint32_t uplink_packets = 0;
+    uint32_t uplink_bytes = 0;
+    uint32_t downlink_packets = 0;
+    uint32_t downlink_bytes = 0;
+    int64_t listen_start_us = 0;
+    int64_t turn_end_us = 0;
+    int64_t first_downlink_us = 0;
+    int64_t tts_stop_us = 0;
+};
+
+class LoopbackProtocol : public Protocol {
+public:
+    LoopbackProtocol();
+    ~LoopbackProtocol();
+
+    bool Start() override;
+    bool SendAudio(std::unique_ptr<AudioStreamPacket> packet) override;
+    bool OpenAudioChannel() override;
+    void CloseAudioChannel() override;
+    bool IsAudioChannelOpened() const override;
+
+private:
+    enum LoopbackCommand {
+        kLoopbackCommandEndTurn,
+        kLoopbackCommandSampleCpu,
+    };
+
+    QueueHandle_t command_queue_ = nullptr;
+    TaskHandle_t server_task_handle_ = nullptr;
+
+    // mutex_ 保护录制的包、recording_、stats_ 和 session_id_，服务器任务回放时取一份快照
+    std::mutex mutex_;
+    std::deque<std::unique_ptr<AudioStreamPacket>> recorded_packets_;
+    std::atomic<bool> channel_opened_{false};
+    bool recording_ = false;
+    std::atomic<bool> aborted_{false};
+    int session_count_ = 0;
+    int turn_count_ = 0;
+    LoopbackTurnStats stats_;
+
+    void ServerTask();
+    void EndTurn();
+    void PlaybackTurn();
+    void ReplyJson(const std::string& json);
+    void PrintTurnStats(const LoopbackTurnStats& stats);
+    bool SendText(const std::string& text) override;
+};
+
+#endif // _LOOPBACK_PROTOCOL_H_
@@ -2,9 +2,13 @@
 #include "board.h"
 #include "application.h"
 #include "settings.h"
+#include "heap_tracker.h"
+#include "timeline_trace.h"
 
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <cstring>
+#include <algorithm>
 #include <arpa/inet.h>
 #include "assets/lang_config.h"
 
@@ -12,10 +16,21 @@
 
 MqttProtocol::MqttProtocol() {
     event_group_handle_ = xEventGroupCreate();
+
+#if CONFIG_USE_UDP_SEND_PIPELINE
+    xTaskCreate([](void* arg) {
+        auto protocol = (MqttProtocol*)arg;
+        protocol->UdpSendTask();
+        vTaskDelete(NULL);
+    }, "udp_send", 4096, this, 4, &udp_send_task_handle_);
+#endif
 }
 
 MqttProtocol::~MqttProtocol() {
     ESP_LOGI(TAG, "MqttProtocol deinit");
+    if (udp_send_task_handle_ != nullptr) {
+        vTaskDelete(udp_send_task_handle_);
+    }
     vEventGroupDelete(event_group_handle_);
 }
 
@@ -54,7 +69,17 @@ bool MqttProtocol::StartMqttClient(bool report_error) {
     });
 
     mqtt_->OnMessage([this](const std::string& topic, const std::string& payload) {
-        cJSON* root = cJSON_Parse(payload.c_str());
+        TRACE_SCOPE("protocol_receive");
+        if (DispatchChatMessage(payload.data(), payload.size())) {
+            last_incoming_time_ = std::chrono::steady_clock::now();
+            return;
+        }
+
+        cJSON* root;
+        {
+            HeapTagScope scope(kHeapTagJson);
+            root = cJSON_Parse(payload.c_str());
+        }
         if (root == nullptr) {
             ESP_LOGE(TAG, "Failed to parse json message %s", payload.c_str());
             return;
@@ -112,14 +137,17 @@ bool MqttProtocol::SendText(const std::string& text) {
         SetError(Lang::Strings::SERVER_ERROR);
         return false;
     }
+    recorder_.RecordJson(kSessionRecordOutgoingJson, text);
     return true;
 }
 
 bool MqttProtocol::SendAudio(std::unique_ptr<AudioStreamPacket> packet) {
+    TRACE_SCOPE("send_audio");
     std::lock_guard<std::mutex> lock(channel_mutex_);
     if (udp_ == nullptr) {
         return false;
     }
+    recorder_.RecordAudio(kSessionRecordOutgoingAudio, *packet);
 
     std::string nonce(aes_nonce_);
     *(uint16_t*)&nonce[2] = htons(packet->payload.size());
@@ -138,7 +166,81 @@ bool MqttProtocol::SendAudio(std::unique_ptr<AudioStreamPacket> packet) {
         return false;
     }
 
-    return udp_->Send(encrypted) > 0;
+#if CONFIG_USE_UDP_SEND_PIPELINE
+    // 蜂窝模组每次发送都是一次 AT 交互，交给发送任务，主循环不必等待模组逐条应答
+    {
+        std::lock_guard<std::mutex> queue_lock(udp_send_mutex_);
+        if (udp_send_queue_.size() >= MQTT_UDP_SEND_QUEUE_SIZE) {
+            udp_send_queue_.pop_front();
+            udp_send_stats_.dropped++;
+        }
+        udp_send_queue_.push_back(UdpDatagram{std::move(encrypted), esp_timer_get_time()});
+    }
+    udp_send_cv_.notify_one();
+    // 发送任务的失败在下一次调用时返回，调用者与同步发送时一样停止本轮发送
+    return !udp_send_failed_.exchange(false);
+#else
+    return SendDatagram(*udp_, encrypted, esp_timer_get_time());
+#endif
+}
+
+// 同步发送时在 channel_mutex_ 内调用，发送任务在锁外调用，统计由 udp_send_mutex_ 保护
+bool MqttProtocol::SendDatagram(Udp& udp, const std::string& data, int64_t enqueue_time_us) {
+    int64_t start_time = esp_timer_get_time();
+    TRACE_BEGIN("udp_send");
+    bool sent = udp.Send(data) > 0;
+    TRACE_END("udp_send");
+    int64_t end_time = esp_timer_get_time();
+
+    uint32_t send_us = end_time - start_time;
+    uint32_t latency_us = end_time - enqueue_time_us;
+    std::lock_guard<std::mutex> lock(udp_send_mutex_);
+    udp_send_stats_.packets++;
+    udp_send_stats_.bytes += data.size();
+    udp_send_stats_.total_send_us += send_us;
+    udp_send_stats_.max_send_us = std::max(udp_send_stats_.max_send_us, send_us);
+    udp_send_stats_.total_latency_us += latency_us;
+    udp_send_stats_.max_latency_us = std::max(udp_send_stats_.max_latency_us, latency_us);
+
+    link_stats_.packets_sent++;
+    if (!sent) {
+        udp_send_stats_.failures++;
+        link_stats_.send_failures++;
+    }
+    return sent;
+}
+
+void MqttProtocol::UdpSendTask() {
+    while (true) {
+        std::unique_lock<std::mutex> lock(udp_send_mutex_);
+        udp_send_cv_.wait(lock, [this]() { return !udp_send_queue_.empty(); });
+        auto datagram = std::move(udp_send_queue_.front());
+        udp_send_queue_.pop_front();
+        lock.unlock();
+
+        // 只在取快照时持有 channel_mutex_，AT 交互期间 SendAudio 可以继续加密入队；
+        // 通道关闭后快照保证 Udp 对象在本次发送结束前有效
+        std::shared_ptr<Udp> udp;
+        {
+            std::lock_guard<std::mutex> channel_lock(channel_mutex_);
+            udp = udp_;
+        }
+        if (udp != nullptr && !SendDatagram(*udp, datagram.data, datagram.enqueue_time_us)) {
+            udp_send_failed_ = true;
+        }
+    }
+}
+
+// 调用时需持有 udp_send_mutex_
+void MqttProtocol::PrintUdpSendStats() {
+    auto& stats = udp_send_stats_;
+    if (stats.packets == 0) {
+        return;
+    }
+    ESP_LOGI(TAG, "UDP send: %lu packets, %lu bytes, %lu failed, %lu dropped, send avg %d us max %lu us, latency avg %d us max %lu us",
+        stats.packets, stats.bytes, stats.failures, stats.dropped,
+        (int)(stats.total_send_us / stats.packets), stats.max_send_us,
+        (int)(stats.total_latency_us / stats.packets), stats.max_latency_us);
 }
 
 void MqttProtocol::CloseAudioChannel() {
@@ -146,6 +248,12 @@ void MqttProtocol::CloseAudioChannel() {
         std::lock_guard<std::mutex> lock(channel_mutex_);
         udp_.reset();
     }
+    {
+        std::lock_guard<std::mutex> lock(udp_send_mutex_);
+        udp_send_queue_.clear();
+        PrintUdpSendStats();
+    }
+    udp_send_failed_ = false;
 
     std::string message = "{";
     message += "\"session_id\":\"" + session_id_ + "\",";
@@ -159,12 +267,14 @@ void MqttProtocol::CloseAudioChannel() {
 }
 
 bool MqttProtocol::OpenAudioChannel() {
+    int64_t connect_start_time = esp_timer_get_time();
     if (mqtt_ == nullptr || !mqtt_->IsConnected()) {
         ESP_LOGI(TAG, "MQTT is not connected, try to connect now");
         if (!StartMqttClient(true)) {
             return false;
         }
     }
+    int64_t hello_start_time = esp_timer_get_time();
 
     error_occurred_ = false;
     session_id_ = "";
@@ -187,6 +297,7 @@ bool MqttProtocol::OpenAudioChannel() {
     auto network = Board::GetInstance().GetNetwork();
     udp_ = network->CreateUdp(2);
     udp_->OnMessage([this](const std::string& data) {
+        TRACE_SCOPE("protocol_receive");
         /*
          * UDP Encrypted OPUS Packet Format:
          * |type 1u|flags 1u|payload_len 2u|ssrc 4u|timestamp 4u|sequence 4u|
@@ -202,13 +313,18 @@ bool MqttProtocol::OpenAudioChannel() {
         }
         uint32_t timestamp = ntohl(*(uint32_t*)&data[8]);
         uint32_t sequence = ntohl(*(uint32_t*)&data[12]);
-        if (sequence < remote_sequence_) {
-            ESP_LOGW(TAG, "Received audio packet with old sequence: %lu, expected: %lu", sequence, remote_sequence_);
+        // Drop duplicated or replayed packets, only a gap after the last packet counts as loss
+        if (remote_sequence_ > 0 && sequence <= remote_sequence_) {
+            ESP_LOGW(TAG, "Received audio packet with old sequence: %lu, expected: %lu", sequence, remote_sequence_ + 1);
             return;
         }
         if (sequence != remote_sequence_ + 1) {
             ESP_LOGW(TAG, "Received audio packet with wrong sequence: %lu, expected: %lu", sequence, remote_sequence_ + 1);
+            if (remote_sequence_ > 0) {
+                link_stats_.packets_lost += sequence - remote_sequence_ - 1;
+            }
         }
+        link_stats_.packets_received++;
 
         size_t decrypted_size = data.size() - aes_nonce_.size();
         size_t nc_off = 0;
@@ -232,7 +348,16 @@ bool MqttProtocol::OpenAudioChannel() {
         last_incoming_time_ = std::chrono::steady_clock::now();
     });
 
+    int64_t udp_start_time = esp_timer_get_time();
     udp_->Connect(udp_server_, udp_port_);
+    {
+        std::lock_guard<std::mutex> stats_lock(udp_send_mutex_);
+        udp_send_stats_ = UdpSendStats();
+    }
+    int64_t now = esp_timer_get_time();
+    ESP_LOGI(TAG, "Channel setup: mqtt %d ms, hello %d ms, udp %d ms",
+        (int)((hello_start_time - connect_start_time) / 1000), (int)((udp_start_time - hello_start_time) / 1000),
+        (int)((now - udp_start_time) / 1000));
 
     if (on_audio_channel_opened_ != nullptr) {
         on_audio_channel_opened_();
@@ -9,17 +9,42 @@
 #include <mbedtls/aes.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/event_groups.h>
+#include <freertos/task.h>
 
 #include <functional>
 #include <string>
 #include <map>
 #include <mutex>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <condition_variable>
 
 #define MQTT_PING_INTERVAL_SECONDS 90
 #define MQTT_RECONNECT_INTERVAL_MS 10000
 
 #define MQTT_PROTOCOL_SERVER_HELLO_EVENT (1 << 0)
 
+// 发送任务积压超过该包数时丢弃最老的包
+#define MQTT_UDP_SEND_QUEUE_SIZE 16
+
+struct UdpDatagram {
+    std::string data;
+    int64_t enqueue_time_us;
+};
+
+// 每个音频通道的 UDP 发送统计，关闭通道时打印，用于对比同步发送与发送任务
+struct UdpSendStats {
+    uint32_t packets = 0;
+    uint32_t bytes = 0;
+    uint32_t failures = 0;
+    uint32_t dropped = 0;
+    int64_t total_send_us = 0;      // Udp::Send 调用耗时
+    uint32_t max_send_us = 0;
+    int64_t total_latency_us = 0;   // 从加密完成到发送完成
+    uint32_t max_latency_us = 0;
+};
+
 class MqttProtocol : public Protocol {
 public:
     MqttProtocol();
@@ -38,17 +63,28 @@ private:
 
     std::mutex channel_mutex_;
     std::unique_ptr<Mqtt> mqtt_;
-    std::unique_ptr<Udp> udp_;
+    std::shared_ptr<Udp> udp_;     // 发送任务持有快照，在 channel_mutex_ 之外发送
     mbedtls_aes_context aes_ctx_;
     std::string aes_nonce_;
     std::string udp_server_;
     int udp_port_;
     uint32_t local_sequence_;
     uint32_t remote_sequence_;
+    UdpSendStats udp_send_stats_;  // 由 udp_send_mutex_ 保护
+
+    // CONFIG_USE_UDP_SEND_PIPELINE
+    TaskHandle_t udp_send_task_handle_ = nullptr;
+    std::mutex udp_send_mutex_;
+    std::condition_variable udp_send_cv_;
+    std::deque<UdpDatagram> udp_send_queue_;
+    std::atomic<bool> udp_send_failed_ = false;    // 发送任务发送失败，下一次 SendAudio 返回 false
 
     bool StartMqttClient(bool report_error=false);
     void ParseServerHello(const cJSON* root);
     std::string DecodeHexString(const std::string& hex_string);
+    bool SendDatagram(Udp& udp, const std::string& data, int64_t enqueue_time_us);
+    void UdpSendTask();
+    void PrintUdpSendStats();
 
     bool SendText(const std::string& text) override;
     std::string GetHelloMessage();
@@ -5,11 +5,21 @@
 #define TAG "Protocol"
 
 void Protocol::OnIncomingJson(std::function<void(const cJSON* root)> callback) {
-    on_incoming_json_ = callback;
+    on_incoming_json_ = [this, callback](const cJSON* root) {
+        recorder_.RecordJson(kSessionRecordIncomingJson, root);
+        callback(root);
+    };
+}
+
+void Protocol::OnIncomingChatMessage(std::function<void(const ChatMessage& message)> callback) {
+    on_incoming_chat_message_ = callback;
 }
 
 void Protocol::OnIncomingAudio(std::function<void(std::unique_ptr<AudioStreamPacket> packet)> callback) {
-    on_incoming_audio_ = callback;
+    on_incoming_audio_ = [this, callback](std::unique_ptr<AudioStreamPacket> packet) {
+        recorder_.RecordAudio(kSessionRecordIncomingAudio, *packet);
+        callback(std::move(packet));
+    };
 }
 
 void Protocol::OnAudioChannelOpened(std::function<void()> callback) {
@@ -24,6 +34,31 @@ void Protocol::OnNetworkError(std::function<void(const std::string& message)> ca
     on_network_error_ = callback;
 }
 
+// Returns false if the message is not a chat message, the caller should parse it with cJSON
+bool Protocol::DispatchChatMessage(const char* json, size_t length) {
+    if (on_incoming_chat_message_ == nullptr) {
+        return false;
+    }
+
+    // Only escaped strings are decoded into the scratch buffer, longer ones fall back to cJSON
+    char scratch[512];
+    ChatMessage message;
+    if (!ParseChatMessage(json, length, message, scratch, sizeof(scratch))) {
+        return false;
+    }
+    recorder_.RecordJson(kSessionRecordIncomingJson, json, length);
+    on_incoming_chat_message_(message);
+    return true;
+}
+
+bool Protocol::StartRecording(const std::string& path) {
+    return recorder_.Start(path, session_id_, server_sample_rate_, server_frame_duration_);
+}
+
+void Protocol::StopRecording() {
+    recorder_.Stop();
+}
+
 void Protocol::SetError(const std::string& message) {
     error_occurred_ = true;
     if (on_network_error_ != nullptr) {
@@ -2,6 +2,9 @@
 #define PROTOCOL_H
 
 #include <cJSON.h>
+#include "session_recorder.h"
+#include "chat_message.h"
+
 #include <string>
 #include <functional>
 #include <chrono>
@@ -41,6 +44,14 @@ enum ListeningMode {
     kListeningModeRealtime // 需要 AEC 支持
 };
 
+// 音频链路的累计计数，由上层按周期取差值用于码率控制
+struct LinkStats {
+    uint32_t packets_sent = 0;
+    uint32_t send_failures = 0;
+    uint32_t packets_received = 0;
+    uint32_t packets_lost = 0;      // 根据下行序号空洞估计，仅 UDP 有效，码率控制用作上行丢包的近似
+};
+
 class Protocol {
 public:
     virtual ~Protocol() = default;
@@ -54,13 +65,22 @@ public:
     inline const std::string& session_id() const {
         return session_id_;
     }
+    inline const LinkStats& link_stats() const {
+        return link_stats_;
+    }
 
     void OnIncomingAudio(std::function<void(std::unique_ptr<AudioStreamPacket> packet)> callback);
     void OnIncomingJson(std::function<void(const cJSON* root)> callback);
+    // tts / stt / llm 消息的快速路径，未设置时全部走 OnIncomingJson
+    void OnIncomingChatMessage(std::function<void(const ChatMessage& message)> callback);
     void OnAudioChannelOpened(std::function<void()> callback);
     void OnAudioChannelClosed(std::function<void()> callback);
     void OnNetworkError(std::function<void(const std::string& message)> callback);
 
+    // 录制收发的 JSON 和音频帧，用于离线回放 (见 ReplayProtocol)
+    bool StartRecording(const std::string& path);
+    void StopRecording();
+
     virtual bool Start() = 0;
     virtual bool OpenAudioChannel() = 0;
     virtual void CloseAudioChannel() = 0;
@@ -74,6 +94,7 @@ public:
 
 protected:
     std::function<void(const cJSON* root)> on_incoming_json_;
+    std::function<void(const ChatMessage& message)> on_incoming_chat_message_;
     std::function<void(std::unique_ptr<AudioStreamPacket> packet)> on_incoming_audio_;
     std::function<void()> on_audio_channel_opened_;
     std::function<void()> on_audio_channel_closed_;
@@ -84,7 +105,10 @@ protected:
     bool error_occurred_ = false;
     std::string session_id_;
     std::chrono::time_point<std::chrono::steady_clock> last_incoming_time_;
+    SessionRecorder recorder_;
+    LinkStats link_stats_;
 
+    bool DispatchChatMessage(const char* json, size_t length);
     virtual bool SendText(const std::string& text) = 0;
     virtual void SetError(const std::string& message);
     virtual bool IsTimeout() const;
@@ -0,0 +1,233 @@
+#include "replay_protocol.h"
+#include "system_info.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cJSON.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#define TAG "Replay"
+
+ReplayProtocol::ReplayProtocol(const std::string& path, int speed_percent)
+    : path_(path), speed_percent_(speed_percent) {
+}
+
+ReplayProtocol::~ReplayProtocol() {
+    if (replay_task_handle_ != nullptr) {
+        vTaskDelete(replay_task_handle_);
+    }
+    if (file_ != nullptr) {
+        fclose(file_);
+    }
+}
+
+bool ReplayProtocol::Start() {
+    if (replay_task_handle_ != nullptr) {
+        return true;
+    }
+
+    // Incoming messages are delivered from another task, just like the network callbacks
+    xTaskCreate([](void* arg) {
+        ReplayProtocol* protocol = (ReplayProtocol*)arg;
+        while (true) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            protocol->ReplayTask();
+            protocol->replaying_ = false;
+        }
+    }, "replay", 4096 * 2, this, 4, &replay_task_handle_);
+
+    FILE* file = fopen(path_.c_str(), "rb");
+    if (file == nullptr) {
+        ESP_LOGE(TAG, "Session file %s not found", path_.c_str());
+        return false;
+    }
+    fclose(file);
+    ESP_LOGI(TAG, "Replay %s at %d%% speed", path_.c_str(), speed_percent_);
+    return true;
+}
+
+bool ReplayProtocol::SendAudio(std::unique_ptr<AudioStreamPacket> packet) {
+    if (!channel_opened_) {
+        return false;
+    }
+    stats_.outgoing_audio++;
+    return true;
+}
+
+bool ReplayProtocol::SendText(const std::string& text) {
+    if (!channel_opened_) {
+        return false;
+    }
+    stats_.outgoing_json++;
+    ESP_LOGD(TAG, "Outgoing: %s", text.c_str());
+    return true;
+}
+
+bool ReplayProtocol::IsAudioChannelOpened() const {
+    return channel_opened_ && !error_occurred_ && !IsTimeout();
+}
+
+void ReplayProtocol::CloseAudioChannel() {
+    stopped_ = true;
+    if (!channel_opened_.exchange(false)) {
+        return;
+    }
+
+    if (on_audio_channel_closed_ != nullptr) {
+        on_audio_channel_closed_();
+    }
+}
+
+bool ReplayProtocol::ReadSessionInfo() {
+    SessionFileHeader file_header;
+    if (fread(&file_header, sizeof(file_header), 1, file_) != 1 || file_header.magic != SESSION_FILE_MAGIC) {
+        ESP_LOGE(TAG, "Invalid session file: %s", path_.c_str());
+        return false;
+    }
+    if (file_header.version != SESSION_FILE_VERSION) {
+        ESP_LOGE(TAG, "Unsupported session file version: %u", file_header.version);
+        return false;
+    }
+
+    SessionRecordHeader header;
+    if (fread(&header, sizeof(header), 1, file_) != 1 || header.type != kSessionRecordSession) {
+        ESP_LOGE(TAG, "Missing session record");
+        return false;
+    }
+    std::string json(header.payload_size, '\0');
+    if (fread(json.data(), json.size(), 1, file_) != 1) {
+        return false;
+    }
+
+    cJSON* root = cJSON_Parse(json.c_str());
+    if (root == nullptr) {
+        return false;
+    }
+    auto session_id = cJSON_GetObjectItem(root, "session_id");
+    auto sample_rate = cJSON_GetObjectItem(root, "sample_rate");
+    auto frame_duration = cJSON_GetObjectItem(root, "frame_duration");
+    if (cJSON_IsString(session_id)) {
+        session_id_ = session_id->valuestring;
+    }
+    if (cJSON_IsNumber(sample_rate)) {
+        server_sample_rate_ = sample_rate->valueint;
+    }
+    if (cJSON_IsNumber(frame_duration)) {
+        server_frame_duration_ = frame_duration->valueint;
+    }
+    cJSON_Delete(root);
+    return true;
+}
+
+bool ReplayProtocol::OpenAudioChannel() {
+    // Wait for the previous replay to quit, it owns the file until then
+    stopped_ = true;
+    while (replaying_) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    error_occurred_ = false;
+    file_ = fopen(path_.c_str(), "rb");
+    if (file_ == nullptr || !ReadSessionInfo()) {
+        if (file_ != nullptr) {
+            fclose(file_);
+            file_ = nullptr;
+        }
+        SetError("Failed to open session file");
+        return false;
+    }
+    ESP_LOGI(TAG, "Replay session %s, sample rate %d, frame duration %d",
+        session_id_.c_str(), server_sample_rate_, server_frame_duration_);
+
+    stats_ = ReplayStats();
+    stats_.start_us = esp_timer_get_time();
+    last_incoming_time_ = std::chrono::steady_clock::now();
+    stopped_ = false;
+    channel_opened_ = true;
+
+    if (on_audio_channel_opened_ != nullptr) {
+        on_audio_channel_opened_();
+    }
+
+    replaying_ = true;
+    xTaskNotifyGive(replay_task_handle_);
+    return true;
+}
+
+void ReplayProtocol::ReplayTask() {
+    replay_count_++;
+    SessionRecordHeader header;
+    std::string payload;
+
+    while (!stopped_ && fread(&header, sizeof(header), 1, file_) == 1) {
+        payload.resize(header.payload_size);
+        if (header.payload_size > 0 && fread(payload.data(), header.payload_size, 1, file_) != 1) {
+            ESP_LOGW(TAG, "Truncated record at %lu ms", header.time_ms);
+            break;
+        }
+
+        if (header.type == kSessionRecordOutgoingJson || header.type == kSessionRecordOutgoingAudio) {
+            stats_.recorded_outgoing++;
+            continue;
+        }
+
+        // Sleep in short slices so that CloseAudioChannel takes effect quickly
+        int64_t target_us = stats_.start_us + (int64_t)header.time_ms * 1000 * 100 / speed_percent_;
+        int64_t now = esp_timer_get_time();
+        while (!stopped_ && target_us - now > 1000) {
+            int64_t wait_ms = std::min<int64_t>((target_us - now) / 1000, 100);
+            vTaskDelay(pdMS_TO_TICKS(wait_ms) > 0 ? pdMS_TO_TICKS(wait_ms) : 1);
+            now = esp_timer_get_time();
+        }
+        if (stopped_) {
+            break;
+        }
+        uint32_t lateness_ms = now > target_us ? (now - target_us) / 1000 : 0;
+        stats_.total_lateness_ms += lateness_ms;
+        stats_.max_lateness_ms = std::max(stats_.max_lateness_ms, lateness_ms);
+
+        if (header.type == kSessionRecordIncomingJson) {
+            if (!DispatchChatMessage(payload.data(), payload.size())) {
+                cJSON* root = cJSON_Parse(payload.c_str());
+                if (root != nullptr && on_incoming_json_ != nullptr) {
+                    on_incoming_json_(root);
+                }
+                cJSON_Delete(root);
+            }
+            stats_.incoming_json++;
+        } else if (header.type == kSessionRecordIncomingAudio && payload.size() >= sizeof(uint32_t)) {
+            auto packet = std::make_unique<AudioStreamPacket>();
+            packet->sample_rate = server_sample_rate_;
+            packet->frame_duration = server_frame_duration_;
+            memcpy(&packet->timestamp, payload.data(), sizeof(uint32_t));
+            packet->payload.assign(payload.begin() + sizeof(uint32_t), payload.end());
+            if (on_incoming_audio_ != nullptr) {
+                on_incoming_audio_(std::move(packet));
+            }
+            stats_.incoming_audio++;
+        }
+        last_incoming_time_ = std::chrono::steady_clock::now();
+    }
+
+    fclose(file_);
+    file_ = nullptr;
+    PrintReplayStats();
+
+    // The recorded session is over, go back to idle like a server side close
+    if (!stopped_) {
+        CloseAudioChannel();
+    }
+}
+
+void ReplayProtocol::PrintReplayStats() {
+    auto& s = stats_;
+    uint32_t incoming = s.incoming_json + s.incoming_audio;
+    uint32_t elapsed_ms = (esp_timer_get_time() - s.start_us) / 1000;
+    ESP_LOGI(TAG, "Replay %d%s: %lu ms, incoming json=%lu audio=%lu, outgoing json=%lu audio=%lu (recorded %lu), "
+        "lateness avg=%lu ms max=%lu ms",
+        replay_count_, stopped_ ? " stopped" : "", elapsed_ms, s.incoming_json, s.incoming_audio,
+        s.outgoing_json, s.outgoing_audio, s.recorded_outgoing,
+        incoming > 0 ? (uint32_t)(s.total_lateness_ms / incoming) : 0, s.max_lateness_ms);
+    SystemInfo::PrintHeapStats();
+}
@@ -0,0 +1,61 @@
+#ifndef _REPLAY_PROTOCOL_H_
+#define _REPLAY_PROTOCOL_H_
+
+
+#include "protocol.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+
+/*
+ * ReplayProtocol 回放 SessionRecorder 录制的会话:
+ * 打开音频通道后，按录制时间戳 (可加速) 把服务器下发的 JSON 和音频帧
+ * 送入 Application，设备上行的消息只做计数。
+ *
+ * 回放结束后打印调度延迟、上下行计数，并关闭音频通道，
+ * 用真实会话重复测试解码队列、界面刷新和 MCP 处理的性能。
+ */
+struct ReplayStats {
+    uint32_t incoming_json = 0;
+    uint32_t incoming_audio = 0;
+    uint32_t recorded_outgoing = 0;
+    uint32_t outgoing_json = 0;
+    uint32_t outgoing_audio = 0;
+    uint32_t max_lateness_ms = 0;
+    uint64_t total_lateness_ms = 0;
+    int64_t start_us = 0;
+};
+
+class ReplayProtocol : public Protocol {
+public:
+    ReplayProtocol(const std::string& path, int speed_percent);
+    ~ReplayProtocol();
+
+    bool Start() override;
+    bool SendAudio(std::unique_ptr<AudioStreamPacket> packet) override;
+    bool OpenAudioChannel() override;
+    void CloseAudioChannel() override;
+    bool IsAudioChannelOpened() const override;
+
+private:
+    std::string path_;
+    int speed_percent_;
+    FILE* file_ = nullptr;
+    TaskHandle_t replay_task_handle_ = nullptr;
+    std::atomic<bool> channel_opened_ = false;
+    std::atomic<bool> stopped_ = true;
+    std::atomic<bool> replaying_ = false;
+    int replay_count_ = 0;
+    ReplayStats stats_;
+
+    bool ReadSessionInfo();
+    void ReplayTask();
+    void PrintReplayStats();
+    bool SendText(const std::string& text) override;
+};
+
+#endif // _REPLAY_PROTOCOL_H_
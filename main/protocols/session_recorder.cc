@@ -0,0 +1,137 @@
+#include "session_recorder.h"
+#include "protocol.h"
+#include "memory_placement.h"
+
+#include <cstring>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+
+#define TAG "SessionRecorder"
+
+// 写 SD 卡是阻塞操作，用较大的缓冲区把小包合并成整块写入
+#define SESSION_RECORDER_BUFFER_SIZE (16 * 1024)
+
+SessionRecorder::~SessionRecorder() {
+    Stop();
+}
+
+bool SessionRecorder::Start(const std::string& path, const std::string& session_id, int sample_rate, int frame_duration) {
+    Stop();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_ = fopen(path.c_str(), "wb");
+    if (file_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to open %s", path.c_str());
+        return false;
+    }
+
+    buffer_ = (char*)memory_placement_malloc(MEMORY_BUFFER_SESSION_RECORD, SESSION_RECORDER_BUFFER_SIZE);
+    if (buffer_ != nullptr) {
+        setvbuf(file_, buffer_, _IOFBF, SESSION_RECORDER_BUFFER_SIZE);
+    }
+
+    SessionFileHeader header = {
+        .magic = SESSION_FILE_MAGIC,
+        .version = SESSION_FILE_VERSION,
+        .reserved = 0,
+    };
+    fwrite(&header, sizeof(header), 1, file_);
+
+    path_ = path;
+    start_time_us_ = esp_timer_get_time();
+    record_count_ = 0;
+    total_bytes_ = sizeof(header);
+
+    std::string json = "{\"session_id\":\"" + session_id + "\",\"sample_rate\":" + std::to_string(sample_rate) +
+        ",\"frame_duration\":" + std::to_string(frame_duration) + "}";
+    WriteRecord(kSessionRecordSession, nullptr, 0, json.data(), json.size());
+    recording_ = true;
+    ESP_LOGI(TAG, "Recording session %s to %s", session_id.c_str(), path.c_str());
+    return true;
+}
+
+void SessionRecorder::Stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_ == nullptr) {
+        return;
+    }
+    recording_ = false;
+    fclose(file_);
+    file_ = nullptr;
+    if (buffer_ != nullptr) {
+        memory_placement_free(buffer_);
+        buffer_ = nullptr;
+    }
+
+    uint32_t duration_ms = (esp_timer_get_time() - start_time_us_) / 1000;
+    ESP_LOGI(TAG, "Saved %s: %lu records, %lu bytes, %lu ms", path_.c_str(), record_count_, total_bytes_, duration_ms);
+}
+
+void SessionRecorder::RecordJson(SessionRecordType type, const std::string& json) {
+    RecordJson(type, json.data(), json.size());
+}
+
+void SessionRecorder::RecordJson(SessionRecordType type, const char* json, size_t length) {
+    if (!recording_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    WriteRecord(type, nullptr, 0, json, length);
+}
+
+void SessionRecorder::RecordJson(SessionRecordType type, const cJSON* root) {
+    if (!recording_ || root == nullptr) {
+        return;
+    }
+    char* json = cJSON_PrintUnformatted(root);
+    if (json == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        WriteRecord(type, nullptr, 0, json, strlen(json));
+    }
+    cJSON_free(json);
+}
+
+void SessionRecorder::RecordAudio(SessionRecordType type, const AudioStreamPacket& packet) {
+    if (!recording_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    WriteRecord(type, &packet.timestamp, sizeof(packet.timestamp), packet.payload.data(), packet.payload.size());
+}
+
+void SessionRecorder::WriteRecord(SessionRecordType type, const void* prefix, size_t prefix_size, const void* data, size_t size) {
+    if (file_ == nullptr) {
+        return;
+    }
+
+    SessionRecordHeader header = {
+        .time_ms = (uint32_t)((esp_timer_get_time() - start_time_us_) / 1000),
+        .type = type,
+        .reserved = 0,
+        .reserved2 = 0,
+        .payload_size = (uint32_t)(prefix_size + size),
+    };
+    bool ok = fwrite(&header, sizeof(header), 1, file_) == 1;
+    if (ok && prefix_size > 0) {
+        ok = fwrite(prefix, prefix_size, 1, file_) == 1;
+    }
+    if (ok && size > 0) {
+        ok = fwrite(data, size, 1, file_) == 1;
+    }
+    if (!ok) {
+        // SD 卡被拔出或写满，停止录制，避免每个包都报错
+        ESP_LOGE(TAG, "Failed to write %s, stop recording", path_.c_str());
+        recording_ = false;
+        fclose(file_);
+        file_ = nullptr;
+        heap_caps_free(buffer_);
+        buffer_ = nullptr;
+        return;
+    }
+    record_count_++;
+    total_bytes_ += sizeof(header) + prefix_size + size;
+}
@@ -0,0 +1,77 @@
+#ifndef _SESSION_RECORDER_H_
+#define _SESSION_RECORDER_H_
+
+#include <cJSON.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+struct AudioStreamPacket;
+
+/*
+ * 会话录制文件格式 (小端):
+ *   文件头: SessionFileHeader
+ *   记录:   SessionRecordHeader + payload，依次排列直到文件结尾
+ *
+ * kSessionRecordSession  payload 为 JSON: session_id / sample_rate / frame_duration
+ * kSessionRecordXxxJson  payload 为 JSON 文本
+ * kSessionRecordXxxAudio payload 为 4 字节音频时间戳 + Opus 数据
+ *
+ * 主机端可用 scripts/session_log.py 查看或导出，设备端由 ReplayProtocol 回放。
+ */
+#define SESSION_FILE_MAGIC 0x52535a58  // "XZSR"
+#define SESSION_FILE_VERSION 1
+
+enum SessionRecordType : uint8_t {
+    kSessionRecordSession = 0,
+    kSessionRecordIncomingJson = 1,
+    kSessionRecordOutgoingJson = 2,
+    kSessionRecordIncomingAudio = 3,
+    kSessionRecordOutgoingAudio = 4,
+};
+
+struct SessionFileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+} __attribute__((packed));
+
+struct SessionRecordHeader {
+    uint32_t time_ms;       // 相对录制开始的时间
+    uint8_t type;           // SessionRecordType
+    uint8_t reserved;
+    uint16_t reserved2;
+    uint32_t payload_size;
+} __attribute__((packed));
+
+class SessionRecorder {
+public:
+    SessionRecorder() = default;
+    ~SessionRecorder();
+
+    bool Start(const std::string& path, const std::string& session_id, int sample_rate, int frame_duration);
+    void Stop();
+    bool IsRecording() const { return recording_; }
+
+    void RecordJson(SessionRecordType type, const std::string& json);
+    void RecordJson(SessionRecordType type, const char* json, size_t length);
+    void RecordJson(SessionRecordType type, const cJSON* root);
+    void RecordAudio(SessionRecordType type, const AudioStreamPacket& packet);
+
+private:
+    std::mutex mutex_;
+    std::atomic<bool> recording_ = false;
+    FILE* file_ = nullptr;
+    char* buffer_ = nullptr;
+    int64_t start_time_us_ = 0;
+    uint32_t record_count_ = 0;
+    uint32_t total_bytes_ = 0;
+    std::string path_;
+
+    void WriteRecord(SessionRecordType type, const void* prefix, size_t prefix_size, const void* data, size_t size);
+};
+
+#endif // _SESSION_RECORDER_H_
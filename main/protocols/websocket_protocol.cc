@@ -3,10 +3,13 @@
 #include "system_info.h"
 #include "application.h"
 #include "settings.h"
+#include "heap_tracker.h"
+#include "timeline_trace.h"
 
 #include <cstring>
 #include <cJSON.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <arpa/inet.h>
 #include "assets/lang_config.h"
 
@@ -26,10 +29,13 @@ bool WebsocketProtocol::Start() {
 }
 
 bool WebsocketProtocol::SendAudio(std::unique_ptr<AudioStreamPacket> packet) {
+    TRACE_SCOPE("send_audio");
     if (websocket_ == nullptr || !websocket_->IsConnected()) {
         return false;
     }
+    recorder_.RecordAudio(kSessionRecordOutgoingAudio, *packet);
 
+    bool sent;
     if (version_ == 2) {
         std::string serialized;
         serialized.resize(sizeof(BinaryProtocol2) + packet->payload.size());
@@ -41,7 +47,7 @@ bool WebsocketProtocol::SendAudio(std::unique_ptr<AudioStreamPacket> packet) {
         bp2->payload_size = htonl(packet->payload.size());
         memcpy(bp2->payload, packet->payload.data(), packet->payload.size());
 
-        return websocket_->Send(serialized.data(), serialized.size(), true);
+        sent = websocket_->Send(serialized.data(), serialized.size(), true);
     } else if (version_ == 3) {
         std::string serialized;
         serialized.resize(sizeof(BinaryProtocol3) + packet->payload.size());
@@ -51,10 +57,16 @@ bool WebsocketProtocol::SendAudio(std::unique_ptr<AudioStreamPacket> packet) {
         bp3->payload_size = htons(packet->payload.size());
         memcpy(bp3->payload, packet->payload.data(), packet->payload.size());
 
-        return websocket_->Send(serialized.data(), serialized.size(), true);
+        sent = websocket_->Send(serialized.data(), serialized.size(), true);
     } else {
-        return websocket_->Send(packet->payload.data(), packet->payload.size(), true);
+        sent = websocket_->Send(packet->payload.data(), packet->payload.size(), true);
     }
+
+    link_stats_.packets_sent++;
+    if (!sent) {
+        link_stats_.send_failures++;
+    }
+    return sent;
 }
 
 bool WebsocketProtocol::SendText(const std::string& text) {
@@ -67,6 +79,7 @@ bool WebsocketProtocol::SendText(const std::string& text) {
         SetError(Lang::Strings::SERVER_ERROR);
         return false;
     }
+    recorder_.RecordJson(kSessionRecordOutgoingJson, text);
 
     return true;
 }
@@ -109,6 +122,7 @@ bool WebsocketProtocol::OpenAudioChannel() {
     websocket_->SetHeader("Client-Id", Board::GetInstance().GetUuid().c_str());
 
     websocket_->OnData([this](const char* data, size_t len, bool binary) {
+        TRACE_SCOPE("protocol_receive");
         if (binary) {
             if (on_incoming_audio_ != nullptr) {
                 if (version_ == 2) {
@@ -144,9 +158,13 @@ bool WebsocketProtocol::OpenAudioChannel() {
                     }));
                 }
             }
-        } else {
+        } else if (!DispatchChatMessage(data, len)) {
             // Parse JSON data
-            auto root = cJSON_Parse(data);
+            cJSON* root;
+            {
+                HeapTagScope scope(kHeapTagJson);
+                root = cJSON_Parse(data);
+            }
             auto type = cJSON_GetObjectItem(root, "type");
             if (cJSON_IsString(type)) {
                 if (strcmp(type->valuestring, "hello") == 0) {
@@ -172,11 +190,14 @@ bool WebsocketProtocol::OpenAudioChannel() {
     });
 
     ESP_LOGI(TAG, "Connecting to websocket server: %s with version: %d", url.c_str(), version_);
+    // Connect covers DNS, TCP, TLS and the websocket upgrade
+    int64_t connect_start_time = esp_timer_get_time();
     if (!websocket_->Connect(url.c_str())) {
         ESP_LOGE(TAG, "Failed to connect to websocket server");
         SetError(Lang::Strings::SERVER_NOT_CONNECTED);
         return false;
     }
+    int64_t hello_start_time = esp_timer_get_time();
 
     // Send hello message to describe the client
     auto message = GetHelloMessage();
@@ -191,6 +212,9 @@ bool WebsocketProtocol::OpenAudioChannel() {
         SetError(Lang::Strings::SERVER_TIMEOUT);
         return false;
     }
+    int64_t now = esp_timer_get_time();
+    ESP_LOGI(TAG, "Channel setup: connect %d ms, hello %d ms",
+        (int)((hello_start_time - connect_start_time) / 1000), (int)((now - hello_start_time) / 1000));
 
     if (on_audio_channel_opened_ != nullptr) {
         on_audio_channel_opened_();
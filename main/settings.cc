@@ -1,87 +1,299 @@
 #include "settings.h"
 
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_system.h>
 #include <nvs_flash.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <map>
+#include <mutex>
+#include <vector>
 
 #define TAG "Settings"
 
-Settings::Settings(const std::string& ns, bool read_write) : ns_(ns), read_write_(read_write) {
-    nvs_open(ns.c_str(), read_write_ ? NVS_READWRITE : NVS_READONLY, &nvs_handle_);
+#define SETTINGS_COMMIT_DELAY_MS 3000
+// 写 flash 和 NVS 页回收可能耗时数十毫秒，在低优先级任务中进行，不占用共享的 esp_timer 任务
+#define SETTINGS_COMMIT_TASK_PRIORITY 1
+#define SETTINGS_COMMIT_TASK_STACK_SIZE 4096
+
+struct SettingsValue {
+    nvs_type_t type;            // NVS_TYPE_ANY 表示已删除，等待提交
+    int32_t int_value;
+    std::string string_value;
+    bool dirty;
+};
+
+struct SettingsNamespace {
+    std::map<std::string, SettingsValue> values;
+    bool erase_all = false;
+    bool dirty = false;
+};
+
+class SettingsStore {
+public:
+    static SettingsStore& GetInstance() {
+        static SettingsStore instance;
+        return instance;
+    }
+
+    SettingsNamespace* Load(const std::string& name);
+    // 修改缓存后调用，调用者需持有 mutex()
+    void MarkDirty(SettingsNamespace* ns);
+    void Flush();
+    std::mutex& mutex() { return mutex_; }
+
+private:
+    SettingsStore();
+
+    std::mutex mutex_;          // 保护缓存
+    std::mutex flush_mutex_;    // 定时提交与重启时的提交不能同时进行
+    std::map<std::string, SettingsNamespace> namespaces_;
+    esp_timer_handle_t commit_timer_ = nullptr;
+    TaskHandle_t commit_task_ = nullptr;
+};
+
+SettingsStore::SettingsStore() {
+    xTaskCreate([](void* arg) {
+        auto store = (SettingsStore*)arg;
+        while (true) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            store->Flush();
+        }
+    }, "settings_commit", SETTINGS_COMMIT_TASK_STACK_SIZE, this, SETTINGS_COMMIT_TASK_PRIORITY, &commit_task_);
+
+    // 定时器只负责唤醒提交任务
+    esp_timer_create_args_t commit_timer_args = {
+        .callback = [](void* arg) {
+            auto store = (SettingsStore*)arg;
+            if (store->commit_task_ != nullptr) {
+                xTaskNotifyGive(store->commit_task_);
+            } else {
+                store->Flush();
+            }
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "settings_commit",
+        .skip_unhandled_events = true,
+    };
+    esp_timer_create(&commit_timer_args, &commit_timer_);
+
+    esp_register_shutdown_handler([]() {
+        SettingsStore::GetInstance().Flush();
+    });
 }
 
-Settings::~Settings() {
-    if (nvs_handle_ != 0) {
-        if (read_write_ && dirty_) {
-            ESP_ERROR_CHECK(nvs_commit(nvs_handle_));
+SettingsNamespace* SettingsStore::Load(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = namespaces_.find(name);
+    if (it != namespaces_.end()) {
+        return &it->second;
+    }
+    auto& ns = namespaces_[name];
+
+    // Settings 只读写 i32 和字符串，其它类型的键保持原样
+    std::vector<std::pair<std::string, nvs_type_t>> keys;
+    nvs_iterator_t iterator = nullptr;
+    esp_err_t ret = nvs_entry_find(NVS_DEFAULT_PART_NAME, name.c_str(), NVS_TYPE_ANY, &iterator);
+    while (ret == ESP_OK) {
+        nvs_entry_info_t info;
+        nvs_entry_info(iterator, &info);
+        if (info.type == NVS_TYPE_I32 || info.type == NVS_TYPE_STR) {
+            keys.emplace_back(info.key, info.type);
         }
-        nvs_close(nvs_handle_);
+        ret = nvs_entry_next(&iterator);
     }
+    nvs_release_iterator(iterator);
+
+    nvs_handle_t handle;
+    if (keys.empty() || nvs_open(name.c_str(), NVS_READONLY, &handle) != ESP_OK) {
+        return &ns;
+    }
+    for (auto& [key, type] : keys) {
+        SettingsValue value = {type, 0, "", false};
+        if (type == NVS_TYPE_I32) {
+            ret = nvs_get_i32(handle, key.c_str(), &value.int_value);
+        } else {
+            size_t length = 0;
+            ret = nvs_get_str(handle, key.c_str(), nullptr, &length);
+            if (ret == ESP_OK) {
+                value.string_value.resize(length);
+                ret = nvs_get_str(handle, key.c_str(), value.string_value.data(), &length);
+                while (!value.string_value.empty() && value.string_value.back() == '\0') {
+                    value.string_value.pop_back();
+                }
+            }
+        }
+        if (ret == ESP_OK) {
+            ns.values[key] = std::move(value);
+        } else {
+            ESP_LOGW(TAG, "Failed to read %s.%s: %s", name.c_str(), key.c_str(), esp_err_to_name(ret));
+        }
+    }
+    nvs_close(handle);
+    ESP_LOGD(TAG, "Loaded %u keys from %s", (unsigned)ns.values.size(), name.c_str());
+    return &ns;
 }
 
-std::string Settings::GetString(const std::string& key, const std::string& default_value) {
-    if (nvs_handle_ == 0) {
-        return default_value;
+void SettingsStore::MarkDirty(SettingsNamespace* ns) {
+    ns->dirty = true;
+    // 定时器运行中说明已有提交在等待，不再推迟，保证修改最多延迟 SETTINGS_COMMIT_DELAY_MS 写入
+    if (commit_timer_ != nullptr && !esp_timer_is_active(commit_timer_)) {
+        esp_timer_start_once(commit_timer_, SETTINGS_COMMIT_DELAY_MS * 1000);
     }
+}
 
-    size_t length = 0;
-    if (nvs_get_str(nvs_handle_, key.c_str(), nullptr, &length) != ESP_OK) {
-        return default_value;
+void SettingsStore::Flush() {
+    struct PendingNamespace {
+        std::string name;
+        bool erase_all;
+        std::vector<std::pair<std::string, SettingsValue>> values;
+    };
+
+    std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+    std::vector<PendingNamespace> pending;
+    {
+        // 只在复制修改时持有缓存锁，写 flash 期间其它任务仍可读取
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& [name, ns] : namespaces_) {
+            if (!ns.dirty) {
+                continue;
+            }
+            PendingNamespace item = {name, ns.erase_all, {}};
+            for (auto& [key, value] : ns.values) {
+                if (value.dirty) {
+                    item.values.emplace_back(key, value);
+                    value.dirty = false;
+                }
+            }
+            ns.erase_all = false;
+            ns.dirty = false;
+            pending.push_back(std::move(item));
+        }
     }
 
-    std::string value;
-    value.resize(length);
-    ESP_ERROR_CHECK(nvs_get_str(nvs_handle_, key.c_str(), value.data(), &length));
-    while (!value.empty() && value.back() == '\0') {
-        value.pop_back();
+    for (auto& item : pending) {
+        nvs_handle_t handle;
+        esp_err_t ret = nvs_open(item.name.c_str(), NVS_READWRITE, &handle);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to open namespace %s: %s", item.name.c_str(), esp_err_to_name(ret));
+            continue;
+        }
+        if (item.erase_all) {
+            ret = nvs_erase_all(handle);
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to erase namespace %s: %s", item.name.c_str(), esp_err_to_name(ret));
+            }
+        }
+        for (auto& [key, value] : item.values) {
+            if (value.type == NVS_TYPE_I32) {
+                ret = nvs_set_i32(handle, key.c_str(), value.int_value);
+            } else if (value.type == NVS_TYPE_STR) {
+                ret = nvs_set_str(handle, key.c_str(), value.string_value.c_str());
+            } else {
+                ret = nvs_erase_key(handle, key.c_str());
+                if (ret == ESP_ERR_NVS_NOT_FOUND) {
+                    ret = ESP_OK;
+                }
+            }
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to write %s.%s: %s", item.name.c_str(), key.c_str(), esp_err_to_name(ret));
+            }
+        }
+        ret = nvs_commit(handle);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to commit %s: %s", item.name.c_str(), esp_err_to_name(ret));
+        }
+        nvs_close(handle);
+        ESP_LOGD(TAG, "Committed %u keys to %s", (unsigned)item.values.size(), item.name.c_str());
     }
-    return value;
+}
+
+Settings::Settings(const std::string& ns, bool read_write) : ns_(ns), read_write_(read_write) {
+    namespace_ = SettingsStore::GetInstance().Load(ns);
+}
+
+Settings::~Settings() {
+}
+
+std::string Settings::GetString(const std::string& key, const std::string& default_value) {
+    std::lock_guard<std::mutex> lock(SettingsStore::GetInstance().mutex());
+    auto it = namespace_->values.find(key);
+    if (it == namespace_->values.end() || it->second.type != NVS_TYPE_STR) {
+        return default_value;
+    }
+    return it->second.string_value;
 }
 
 void Settings::SetString(const std::string& key, const std::string& value) {
-    if (read_write_) {
-        ESP_ERROR_CHECK(nvs_set_str(nvs_handle_, key.c_str(), value.c_str()));
-        dirty_ = true;
-    } else {
+    if (!read_write_) {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
+        return;
     }
+    auto& store = SettingsStore::GetInstance();
+    std::lock_guard<std::mutex> lock(store.mutex());
+    auto& entry = namespace_->values[key];
+    if (entry.type == NVS_TYPE_STR && entry.string_value == value) {
+        return;
+    }
+    entry = {NVS_TYPE_STR, 0, value, true};
+    store.MarkDirty(namespace_);
 }
 
 int32_t Settings::GetInt(const std::string& key, int32_t default_value) {
-    if (nvs_handle_ == 0) {
-        return default_value;
-    }
-
-    int32_t value;
-    if (nvs_get_i32(nvs_handle_, key.c_str(), &value) != ESP_OK) {
+    std::lock_guard<std::mutex> lock(SettingsStore::GetInstance().mutex());
+    auto it = namespace_->values.find(key);
+    if (it == namespace_->values.end() || it->second.type != NVS_TYPE_I32) {
         return default_value;
     }
-    return value;
+    return it->second.int_value;
 }
 
 void Settings::SetInt(const std::string& key, int32_t value) {
-    if (read_write_) {
-        ESP_ERROR_CHECK(nvs_set_i32(nvs_handle_, key.c_str(), value));
-        dirty_ = true;
-    } else {
+    if (!read_write_) {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
+        return;
+    }
+    auto& store = SettingsStore::GetInstance();
+    std::lock_guard<std::mutex> lock(store.mutex());
+    auto& entry = namespace_->values[key];
+    if (entry.type == NVS_TYPE_I32 && entry.int_value == value) {
+        return;
     }
+    entry = {NVS_TYPE_I32, value, "", true};
+    store.MarkDirty(namespace_);
 }
 
 void Settings::EraseKey(const std::string& key) {
-    if (read_write_) {
-        auto ret = nvs_erase_key(nvs_handle_, key.c_str());
-        if (ret != ESP_ERR_NVS_NOT_FOUND) {
-            ESP_ERROR_CHECK(ret);
-        }
-    } else {
+    if (!read_write_) {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
+        return;
     }
+    auto& store = SettingsStore::GetInstance();
+    std::lock_guard<std::mutex> lock(store.mutex());
+    auto it = namespace_->values.find(key);
+    if (it != namespace_->values.end() && it->second.type == NVS_TYPE_ANY) {
+        return;
+    }
+    // 缓存中没有的键也可能是其它类型，同样交给 NVS 删除
+    namespace_->values[key] = {NVS_TYPE_ANY, 0, "", true};
+    store.MarkDirty(namespace_);
 }
 
 void Settings::EraseAll() {
-    if (read_write_) {
-        ESP_ERROR_CHECK(nvs_erase_all(nvs_handle_));
-    } else {
+    if (!read_write_) {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
+        return;
     }
+    auto& store = SettingsStore::GetInstance();
+    std::lock_guard<std::mutex> lock(store.mutex());
+    namespace_->values.clear();
+    namespace_->erase_all = true;
+    store.MarkDirty(namespace_);
+}
+
+void Settings::Flush() {
+    SettingsStore::GetInstance().Flush();
 }
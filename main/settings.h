@@ -4,6 +4,15 @@
 #include <string>
 #include <nvs_flash.h>
 
+struct SettingsNamespace;
+
+/*
+ * NVS 设置。每个命名空间在第一次使用时整体读入内存，之后的读取不再访问 NVS；
+ * 写入只修改内存并在 SETTINGS_COMMIT_DELAY_MS 后由低优先级的提交任务合并提交，连续调节音量、亮度时只写一次 flash。
+ * esp_restart 时自动提交未写入的修改，深度睡眠或关机前需要调用 Settings::Flush()：
+ * PowerSaveTimer、SleepTimer、Axp2101/Sy6970::PowerOff 已经调用，板卡自己切断电源的路径需自行调用。
+ * 其它组件绕过 Settings 直接写入的 NVS 数据要到重启后才能读到。
+ */
 class Settings {
 public:
     Settings(const std::string& ns, bool read_write = false);
@@ -16,11 +25,13 @@ public:
     void EraseKey(const std::string& key);
     void EraseAll();
 
+    // 立即提交所有命名空间中未写入的修改
+    static void Flush();
+
 private:
     std::string ns_;
-    nvs_handle_t nvs_handle_ = 0;
+    SettingsNamespace* namespace_ = nullptr;
     bool read_write_ = false;
-    bool dirty_ = false;
 };
 
 #endif
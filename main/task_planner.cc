@@ -0,0 +1,269 @@
+#include "task_planner.h"
+#include "settings.h"
+
+#include <esp_log.h>
+#include <esp_console.h>
+#include <esp_pthread.h>
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+
+#define TAG "TaskPlanner"
+
+#define LOAD_CHECK_WINDOW_MS 5000
+
+/*
+ * ESP32-S3 的 WiFi、LwIP 任务在核心 0，录音、AFE 和唤醒词集中在核心 1，
+ * Opus 编解码、MJPEG 软件解码和摄像头编码放在核心 0，避免与 AFE 抢占同一个核心；
+ * ESP32-P4 的 WiFi 在外部芯片上，JPEG 由硬件解码，除录音外大多不绑定核心，由调度器分配。
+ * 单核芯片上所有绑定都会被忽略。
+ */
+static const TaskPlacement kDefaultPlacements[kTaskRoleCount] = {
+    {"main_loop",       -1, 3},
+#if CONFIG_USE_AUDIO_PROCESSOR
+    {"audio_input",      1, 8},
+#else
+    {"audio_input",     -1, 8},
+#endif
+    {"audio_output",    -1, 3},
+#if CONFIG_IDF_TARGET_ESP32S3
+    {"opus_codec",       0, 2},
+    {"audio_processor",  1, 5},
+    {"wake_word",        1, 5},
+    {"posture",         -1, 5},
+    {"mjpeg_manager",   -1, 3},
+    {"mjpeg_player",     0, 2},
+    {"camera_encoder",   0, 2},
+#else
+    {"opus_codec",      -1, 2},
+    {"audio_processor", -1, 5},
+    {"wake_word",       -1, 5},
+    {"posture",         -1, 5},
+    {"mjpeg_manager",    1, 3},
+    {"mjpeg_player",     0, 4},
+    {"camera_encoder",  -1, 5},
+#endif
+    {"lvgl",            -1, 4},
+    {"mcp_tool",        -1, 1},
+};
+
+static int FindRole(const char* name) {
+    for (int i = 0; i < kTaskRoleCount; i++) {
+        if (strcmp(kDefaultPlacements[i].role, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// 解析 "核心:优先级"，核心为数字或 any
+static bool ParsePlacement(const char* value, int* core, int* priority) {
+    const char* colon = strchr(value, ':');
+    if (colon == nullptr) {
+        return false;
+    }
+    if (colon - value == 3 && strncmp(value, "any", 3) == 0) {
+        *core = -1;
+    } else {
+        char* end = nullptr;
+        *core = strtol(value, &end, 10);
+        if (end != colon || *core < 0 || *core >= CONFIG_FREERTOS_NUMBER_OF_CORES) {
+            return false;
+        }
+    }
+    char* end = nullptr;
+    *priority = strtol(colon + 1, &end, 10);
+    return end != colon + 1 && *end == '\0' && *priority > 0 && *priority < configMAX_PRIORITIES;
+}
+
+TaskPlanner::TaskPlanner() {
+    memcpy(placements_, kDefaultPlacements, sizeof(placements_));
+
+    Settings settings("tasks");
+    for (int i = 0; i < kTaskRoleCount; i++) {
+        auto value = settings.GetString(placements_[i].role);
+        if (value.empty()) {
+            continue;
+        }
+        int core, priority;
+        if (ParsePlacement(value.c_str(), &core, &priority)) {
+            placements_[i].core = core;
+            placements_[i].priority = priority;
+            from_settings_[i] = true;
+        } else {
+            ESP_LOGW(TAG, "Invalid placement for %s: %s", placements_[i].role, value.c_str());
+        }
+    }
+
+    for (auto& placement : placements_) {
+        if (placement.core >= CONFIG_FREERTOS_NUMBER_OF_CORES) {
+            placement.core = -1;
+        }
+    }
+}
+
+BaseType_t TaskPlanner::GetCoreId(TaskRole role) const {
+    return placements_[role].core < 0 ? tskNO_AFFINITY : placements_[role].core;
+}
+
+BaseType_t TaskPlanner::CreateTask(TaskRole role, TaskFunction_t function, const char* name, uint32_t stack_size,
+    void* arg, TaskHandle_t* handle) {
+    BaseType_t ret = xTaskCreatePinnedToCore(function, name, stack_size, arg, placements_[role].priority, handle,
+        GetCoreId(role));
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create task %s", name);
+    }
+    return ret;
+}
+
+std::thread TaskPlanner::CreateThread(TaskRole role, const char* name, size_t stack_size, std::function<void()> function) {
+    // 配置只影响当前线程随后创建的线程，创建后恢复，不影响调用者的其它线程
+    esp_pthread_cfg_t previous;
+    bool has_previous = esp_pthread_get_cfg(&previous) == ESP_OK;
+
+    esp_pthread_cfg_t cfg = esp_pthread_get_default_config();
+    cfg.thread_name = name;
+    cfg.prio = placements_[role].priority;
+    cfg.pin_to_core = GetCoreId(role);
+    if (stack_size > 0) {
+        cfg.stack_size = stack_size;
+    }
+    esp_pthread_set_cfg(&cfg);
+    std::thread thread(std::move(function));
+
+    if (!has_previous) {
+        previous = esp_pthread_get_default_config();
+    }
+    esp_pthread_set_cfg(&previous);
+    return thread;
+}
+
+void TaskPlanner::StartLoadCheck(int delay_ms) {
+#if CONFIG_USE_TASK_LOAD_CHECK
+    load_check_delay_ms_ = delay_ms;
+    xTaskCreate([](void* arg) {
+        auto planner = (TaskPlanner*)arg;
+        vTaskDelay(pdMS_TO_TICKS(planner->load_check_delay_ms_));
+        planner->CheckLoad();
+        vTaskDelete(NULL);
+    }, "load_check", 4096, this, 1, nullptr);
+#endif
+}
+
+void TaskPlanner::CheckLoad() {
+#if CONFIG_USE_TASK_LOAD_CHECK
+    int capacity = uxTaskGetNumberOfTasks() + 8;
+    std::vector<TaskStatus_t> before(capacity);
+    std::vector<TaskStatus_t> after(capacity);
+    configRUN_TIME_COUNTER_TYPE before_time = 0, after_time = 0;
+    int before_count = uxTaskGetSystemState(before.data(), capacity, &before_time);
+    vTaskDelay(pdMS_TO_TICKS(LOAD_CHECK_WINDOW_MS));
+    int after_count = uxTaskGetSystemState(after.data(), capacity, &after_time);
+    uint32_t elapsed = after_time - before_time;
+    if (before_count == 0 || after_count == 0 || elapsed == 0) {
+        ESP_LOGW(TAG, "Load check skipped");
+        return;
+    }
+
+    // 每个任务在窗口内占单个核心的千分比
+    auto get_permille = [&](const TaskStatus_t& status) -> uint32_t {
+        configRUN_TIME_COUNTER_TYPE last_counter = 0;
+        for (int j = 0; j < before_count; j++) {
+            if (before[j].xHandle == status.xHandle) {
+                last_counter = before[j].ulRunTimeCounter;
+                break;
+            }
+        }
+        return (uint64_t)(uint32_t)(status.ulRunTimeCounter - last_counter) * 1000 / elapsed;
+    };
+
+    for (int core = 0; core < CONFIG_FREERTOS_NUMBER_OF_CORES; core++) {
+        TaskHandle_t idle = xTaskGetIdleTaskHandleForCore(core);
+        uint32_t idle_permille = 0;
+        for (int i = 0; i < after_count; i++) {
+            if (after[i].xHandle == idle) {
+                idle_permille = std::min<uint32_t>(get_permille(after[i]), 1000);
+                break;
+            }
+        }
+        uint32_t load = (1000 - idle_permille) / 10;
+        if (load <= CONFIG_TASK_LOAD_CHECK_PERCENT) {
+            ESP_LOGI(TAG, "Core %d load %lu%%", core, load);
+            continue;
+        }
+
+        ESP_LOGW(TAG, "Core %d is overloaded: %lu%% > %d%%", core, load, CONFIG_TASK_LOAD_CHECK_PERCENT);
+#if CONFIG_FREERTOS_VTASKLIST_INCLUDE_COREID
+        std::vector<std::pair<uint32_t, const TaskStatus_t*>> pinned;
+        for (int i = 0; i < after_count; i++) {
+            if (after[i].xCoreID == core && after[i].xHandle != idle) {
+                pinned.emplace_back(get_permille(after[i]), &after[i]);
+            }
+        }
+        std::sort(pinned.begin(), pinned.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+        for (size_t i = 0; i < pinned.size() && i < 5; i++) {
+            ESP_LOGW(TAG, "  %-16s prio %2u %3lu.%lu%%", pinned[i].second->pcTaskName,
+                (unsigned)pinned[i].second->uxCurrentPriority, pinned[i].first / 10, pinned[i].first % 10);
+        }
+#endif
+        for (int i = 0; i < kTaskRoleCount; i++) {
+            if (placements_[i].core == core) {
+                ESP_LOGW(TAG, "  planned: %s", placements_[i].role);
+            }
+        }
+    }
+#endif
+}
+
+void TaskPlanner::Print() {
+    ESP_LOGI(TAG, "%-16s %-4s %4s %-8s", "role", "core", "prio", "source");
+    for (int i = 0; i < kTaskRoleCount; i++) {
+        auto& placement = placements_[i];
+        char core[8];
+        if (placement.core < 0) {
+            strcpy(core, "any");
+        } else {
+            snprintf(core, sizeof(core), "%d", placement.core);
+        }
+        ESP_LOGI(TAG, "%-16s %-4s %4d %-8s", placement.role, core, placement.priority,
+            from_settings_[i] ? "nvs" : "default");
+    }
+}
+
+void TaskPlanner::RegisterConsoleCommand() {
+    const esp_console_cmd_t cmd = {
+        .command = "tasks",
+        .help = "Show task placement, or set the core and priority of a role: tasks [role core|any:priority|default]",
+        .hint = nullptr,
+        .func = [](int argc, char** argv) -> int {
+            if (argc < 3) {
+                TaskPlanner::GetInstance().Print();
+                return 0;
+            }
+            if (FindRole(argv[1]) < 0) {
+                printf("Unknown role: %s\n", argv[1]);
+                return 1;
+            }
+            Settings settings("tasks", true);
+            if (strcmp(argv[2], "default") == 0) {
+                settings.EraseKey(argv[1]);
+            } else {
+                int core, priority;
+                if (!ParsePlacement(argv[2], &core, &priority)) {
+                    printf("Invalid placement: %s\n", argv[2]);
+                    return 1;
+                }
+                settings.SetString(argv[1], argv[2]);
+            }
+            printf("Saved, reboot to take effect\n");
+            return 0;
+        },
+        .argtable = nullptr,
+    };
+    esp_err_t ret = esp_console_cmd_register(&cmd);
+    if (ret != ESP_OK) {
+        ESP_LOGD(TAG, "Console is not available: %s", esp_err_to_name(ret));
+    }
+}
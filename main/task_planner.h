@@ -0,0 +1,75 @@
+#ifndef TASK_PLANNER_H
+#define TASK_PLANNER_H
+
+#include <functional>
+#include <thread>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+/*
+ * 固件任务的核心绑定和优先级规划。各模块按角色向规划表查询核心和优先级，不再各自写死，
+ * 默认表按芯片区分，见 task_planner.cc。
+ *
+ * 现场调整：NVS 命名空间 tasks 中以角色名为键保存 "核心:优先级"，核心为 any 表示不绑定，
+ * 可以用串口命令 tasks <角色> <核心:优先级> 修改，重启后生效。
+ *
+ * 启动完成后打印规划表；开启 CONFIG_USE_TASK_LOAD_CHECK 时，稳定运行一段时间后测量每个核心的占用，
+ * 超过 CONFIG_TASK_LOAD_CHECK_PERCENT 时打印该核心上占用最高的任务，便于调整规划。
+ */
+enum TaskRole {
+    kTaskRoleMainLoop,          // Application 主循环，运行在 main 任务中，只使用优先级
+    kTaskRoleAudioInput,
+    kTaskRoleAudioOutput,
+    kTaskRoleOpusCodec,
+    kTaskRoleAudioProcessor,    // AFE 降噪、VAD 的 fetch 任务
+    kTaskRoleWakeWord,          // 唤醒词检测的 fetch 任务
+    kTaskRolePosture,
+    kTaskRoleMjpegManager,      // MJPEG 播放命令队列
+    kTaskRoleMjpegPlayer,       // MJPEG 读取和解码
+    kTaskRoleCameraEncoder,     // 摄像头图片 JPEG 编码线程
+    kTaskRoleLvgl,              // esp_lvgl_port 任务 (LCD 屏幕)
+    kTaskRoleMcpTool,           // MCP 工具调用的工作任务
+    kTaskRoleCount,
+};
+
+struct TaskPlacement {
+    const char* role;
+    int core;       // -1 表示不绑定核心
+    int priority;
+};
+
+class TaskPlanner {
+public:
+    static TaskPlanner& GetInstance() {
+        static TaskPlanner instance;
+        return instance;
+    }
+    TaskPlanner(const TaskPlanner&) = delete;
+    TaskPlanner& operator=(const TaskPlanner&) = delete;
+
+    const TaskPlacement& Get(TaskRole role) const { return placements_[role]; }
+    // 供 xTaskCreatePinnedToCore 使用，不绑定时为 tskNO_AFFINITY
+    BaseType_t GetCoreId(TaskRole role) const;
+
+    BaseType_t CreateTask(TaskRole role, TaskFunction_t function, const char* name, uint32_t stack_size,
+        void* arg, TaskHandle_t* handle);
+    // 按规划创建 std::thread，stack_size 为 0 时使用 pthread 默认栈大小
+    std::thread CreateThread(TaskRole role, const char* name, size_t stack_size, std::function<void()> function);
+
+    // 延迟 delay_ms 后测量一次各核心占用
+    void StartLoadCheck(int delay_ms);
+    void Print();
+    void RegisterConsoleCommand();
+
+private:
+    TaskPlanner();
+
+    TaskPlacement placements_[kTaskRoleCount];
+    bool from_settings_[kTaskRoleCount] = {};
+    int load_check_delay_ms_ = 0;
+
+    void CheckLoad();
+};
+
+#endif // TASK_PLANNER_H
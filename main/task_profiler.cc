@@ -0,0 +1,211 @@
+#include "task_profiler.h"
+#include "memory_placement.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <esp_console.h>
+#include <cJSON.h>
+
+#include <algorithm>
+#include <cstring>
+
+#define TAG "TaskProfiler"
+
+void TaskProfiler::Start(int interval_ms) {
+    if (task_handle_ != nullptr) {
+        return;
+    }
+
+    // 历史记录约 9KB，优先放在 PSRAM
+    size_t history_size = sizeof(TaskProfileSample) * PROFILER_HISTORY_SIZE;
+    history_ = (TaskProfileSample*)memory_placement_malloc(MEMORY_BUFFER_PROFILER, history_size);
+    status_array_ = (TaskStatus_t*)malloc(sizeof(TaskStatus_t) * PROFILER_STATUS_ARRAY_SIZE);
+    if (history_ == nullptr || status_array_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate profiler buffers");
+        memory_placement_free(history_);
+        free(status_array_);
+        history_ = nullptr;
+        status_array_ = nullptr;
+        return;
+    }
+
+    interval_ms_ = interval_ms;
+    xTaskCreate([](void* arg) {
+        auto profiler = (TaskProfiler*)arg;
+        profiler->ProfilerTask();
+        vTaskDelete(NULL);
+    }, "profiler", 4096, this, 1, &task_handle_);
+
+    RegisterConsoleCommand();
+}
+
+void TaskProfiler::ProfilerTask() {
+    while (true) {
+        TakeSample();
+        vTaskDelay(pdMS_TO_TICKS(interval_ms_));
+    }
+}
+
+void TaskProfiler::TakeSample() {
+    configRUN_TIME_COUNTER_TYPE total_time = 0;
+    int count = uxTaskGetSystemState(status_array_, PROFILER_STATUS_ARRAY_SIZE, &total_time);
+    if (count == 0) {
+        ESP_LOGW(TAG, "More than %d tasks, sample skipped", PROFILER_STATUS_ARRAY_SIZE);
+        return;
+    }
+
+    // The first sample has no previous counters and is only used as a baseline
+    uint32_t elapsed = total_time - last_total_time_;
+    bool has_baseline = last_count_ > 0 && elapsed > 0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& sample = history_[history_head_];
+    sample.time_ms = esp_timer_get_time() / 1000;
+    sample.interval_ms = interval_ms_;
+    sample.task_count = 0;
+
+    TaskHandle_t handles[PROFILER_STATUS_ARRAY_SIZE];
+    configRUN_TIME_COUNTER_TYPE counters[PROFILER_STATUS_ARRAY_SIZE];
+    for (int i = 0; i < count; i++) {
+        auto& status = status_array_[i];
+        handles[i] = status.xHandle;
+        counters[i] = status.ulRunTimeCounter;
+
+        // 新建的任务按从 0 开始计算
+        configRUN_TIME_COUNTER_TYPE last_counter = 0;
+        for (int j = 0; j < last_count_; j++) {
+            if (last_handles_[j] == status.xHandle) {
+                last_counter = last_counters_[j];
+                break;
+            }
+        }
+        uint32_t permille = has_baseline ?
+            (uint64_t)(uint32_t)(status.ulRunTimeCounter - last_counter) * 1000 / ((uint64_t)elapsed * CONFIG_FREERTOS_NUMBER_OF_CORES) : 0;
+
+        TaskProfileEntry entry;
+        strncpy(entry.name, status.pcTaskName, sizeof(entry.name) - 1);
+        entry.name[sizeof(entry.name) - 1] = '\0';
+        entry.cpu_permille = std::min<uint32_t>(permille, 1000);
+        entry.priority = status.uxCurrentPriority;
+        entry.stack_free_bytes = status.usStackHighWaterMark * sizeof(StackType_t);
+#if CONFIG_FREERTOS_VTASKLIST_INCLUDE_COREID
+        entry.core_id = status.xCoreID == tskNO_AFFINITY ? -1 : status.xCoreID;
+#else
+        entry.core_id = -1;
+#endif
+
+        if (sample.task_count < PROFILER_MAX_TASKS) {
+            sample.tasks[sample.task_count++] = entry;
+        } else {
+            // Replace the task with the lowest CPU usage
+            auto lowest = std::min_element(sample.tasks, sample.tasks + PROFILER_MAX_TASKS,
+                [](const TaskProfileEntry& a, const TaskProfileEntry& b) { return a.cpu_permille < b.cpu_permille; });
+            if (lowest->cpu_permille < entry.cpu_permille) {
+                *lowest = entry;
+            }
+        }
+    }
+    std::sort(sample.tasks, sample.tasks + sample.task_count,
+        [](const TaskProfileEntry& a, const TaskProfileEntry& b) { return a.cpu_permille > b.cpu_permille; });
+
+    memcpy(last_handles_, handles, sizeof(TaskHandle_t) * count);
+    memcpy(last_counters_, counters, sizeof(configRUN_TIME_COUNTER_TYPE) * count);
+    last_count_ = count;
+    last_total_time_ = total_time;
+
+    if (!has_baseline) {
+        return;
+    }
+    history_head_ = (history_head_ + 1) % PROFILER_HISTORY_SIZE;
+    history_count_ = std::min(history_count_ + 1, PROFILER_HISTORY_SIZE);
+}
+
+std::string TaskProfiler::GetProfileJson(int count) {
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "interval_ms", interval_ms_);
+    cJSON_AddNumberToObject(root, "cores", CONFIG_FREERTOS_NUMBER_OF_CORES);
+    cJSON* samples = cJSON_CreateArray();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        count = std::min(count, history_count_);
+        // 从最新的采样开始
+        for (int i = 1; i <= count; i++) {
+            auto& sample = history_[(history_head_ - i + PROFILER_HISTORY_SIZE) % PROFILER_HISTORY_SIZE];
+            cJSON* item = cJSON_CreateObject();
+            cJSON_AddNumberToObject(item, "time_ms", sample.time_ms);
+            cJSON* tasks = cJSON_CreateArray();
+            for (int j = 0; j < sample.task_count; j++) {
+                auto& entry = sample.tasks[j];
+                cJSON* task = cJSON_CreateObject();
+                cJSON_AddStringToObject(task, "name", entry.name);
+                cJSON_AddNumberToObject(task, "cpu_percent", entry.cpu_permille / 10.0);
+                cJSON_AddNumberToObject(task, "stack_free", entry.stack_free_bytes);
+                cJSON_AddNumberToObject(task, "core", entry.core_id);
+                cJSON_AddNumberToObject(task, "priority", entry.priority);
+                cJSON_AddItemToArray(tasks, task);
+            }
+            cJSON_AddItemToObject(item, "tasks", tasks);
+            cJSON_AddItemToArray(samples, item);
+        }
+    }
+    cJSON_AddItemToObject(root, "samples", samples);
+
+    char* json = cJSON_PrintUnformatted(root);
+    std::string result(json);
+    cJSON_free(json);
+    cJSON_Delete(root);
+    return result;
+}
+
+void TaskProfiler::PrintLatest() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (history_count_ == 0) {
+        printf("No profile sample yet\n");
+        return;
+    }
+    auto& sample = history_[(history_head_ - 1 + PROFILER_HISTORY_SIZE) % PROFILER_HISTORY_SIZE];
+    printf("| Task             |   CPU  | Stack free | Core | Prio\n");
+    for (int i = 0; i < sample.task_count; i++) {
+        auto& entry = sample.tasks[i];
+        printf("| %-16s | %3u.%u%% | %10lu | %4d | %4u\n", entry.name, entry.cpu_permille / 10, entry.cpu_permille % 10,
+            entry.stack_free_bytes, entry.core_id, entry.priority);
+    }
+}
+
+void TaskProfiler::RegisterConsoleCommand() {
+    const esp_console_cmd_t cmd = {
+        .command = "profile",
+        .help = "Print CPU usage, minimum free stack and core of each task",
+        .hint = nullptr,
+        .func = [](int argc, char** argv) -> int {
+            TaskProfiler::GetInstance().PrintLatest();
+            return 0;
+        },
+        .argtable = nullptr,
+    };
+
+#if CONFIG_USE_PROFILER_CONSOLE
+    // Boards like SenseCAP Watcher have created their own console, just add the command to it
+    esp_console_repl_t* repl = nullptr;
+    esp_console_repl_config_t repl_config = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+    repl_config.prompt = "xiaozhi>";
+#if CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+    esp_console_dev_usb_serial_jtag_config_t hw_config = ESP_CONSOLE_DEV_USB_SERIAL_JTAG_CONFIG_DEFAULT();
+    esp_err_t err = esp_console_new_repl_usb_serial_jtag(&hw_config, &repl_config, &repl);
+#else
+    esp_console_dev_uart_config_t hw_config = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+    esp_err_t err = esp_console_new_repl_uart(&hw_config, &repl_config, &repl);
+#endif
+    if (err == ESP_OK) {
+        esp_console_cmd_register(&cmd);
+        esp_console_start_repl(repl);
+        return;
+    }
+#endif
+
+    esp_err_t ret = esp_console_cmd_register(&cmd);
+    if (ret != ESP_OK) {
+        ESP_LOGD(TAG, "Console is not available: %s", esp_err_to_name(ret));
+    }
+}
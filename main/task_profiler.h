@@ -0,0 +1,73 @@
+#ifndef TASK_PROFILER_H
+#define TASK_PROFILER_H
+
+#include <string>
+#include <mutex>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+/*
+ * 后台任务剖析器，替代需要阻塞 1 秒的 SystemInfo::PrintTaskCpuUsage。
+ * 低优先级任务每隔 CONFIG_TASK_PROFILER_INTERVAL_MS 采样一次所有任务的
+ * CPU 占用 (占全部核心的千分比)、栈剩余最小值和所在核心，保存在固定大小的环形缓冲中，
+ * 可以通过 MCP 工具 self.system.get_profile 或串口命令 profile 查询。
+ */
+#define PROFILER_MAX_TASKS 32
+#define PROFILER_HISTORY_SIZE 12
+// uxTaskGetSystemState 要求数组能容纳所有任务，每次采样只保留 CPU 占用最高的 PROFILER_MAX_TASKS 个
+#define PROFILER_STATUS_ARRAY_SIZE 48
+
+struct TaskProfileEntry {
+    char name[configMAX_TASK_NAME_LEN];
+    uint16_t cpu_permille;
+    int8_t core_id;             // -1 表示未绑定核心
+    uint8_t priority;
+    uint32_t stack_free_bytes;  // 历史最小剩余栈
+};
+
+struct TaskProfileSample {
+    uint32_t time_ms;
+    uint32_t interval_ms;
+    uint16_t task_count;
+    TaskProfileEntry tasks[PROFILER_MAX_TASKS];
+};
+
+class TaskProfiler {
+public:
+    static TaskProfiler& GetInstance() {
+        static TaskProfiler instance;
+        return instance;
+    }
+    TaskProfiler(const TaskProfiler&) = delete;
+    TaskProfiler& operator=(const TaskProfiler&) = delete;
+
+    void Start(int interval_ms);
+    // 最近 count 次采样，JSON 格式，供 MCP 工具返回
+    std::string GetProfileJson(int count);
+    // 打印最近一次采样，串口命令使用
+    void PrintLatest();
+
+private:
+    TaskProfiler() = default;
+
+    std::mutex mutex_;
+    TaskHandle_t task_handle_ = nullptr;
+    int interval_ms_ = 0;
+    TaskStatus_t* status_array_ = nullptr;
+    TaskProfileSample* history_ = nullptr;
+    int history_head_ = 0;
+    int history_count_ = 0;
+
+    // 上一次采样的累计运行时间，按任务句柄匹配
+    TaskHandle_t last_handles_[PROFILER_STATUS_ARRAY_SIZE] = {};
+    configRUN_TIME_COUNTER_TYPE last_counters_[PROFILER_STATUS_ARRAY_SIZE] = {};
+    int last_count_ = 0;
+    configRUN_TIME_COUNTER_TYPE last_total_time_ = 0;
+
+    void ProfilerTask();
+    void TakeSample();
+    void RegisterConsoleCommand();
+};
+
+#endif // TASK_PROFILER_H
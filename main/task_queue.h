@@ -0,0 +1,310 @@
+#ifndef TASK_QUEUE_H
+#define TASK_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/*
+ * 主循环的任务队列，替代 mutex + std::deque<std::function<void()>>。
+ *
+ * - InlineTask 把不超过 TASK_INLINE_SIZE 字节的可调用对象直接存放在内部，
+ *   常见的 [this] / [this, state] 捕获不再分配堆内存；更大的捕获退化为堆分配并计数。
+ * - TaskQueue 是有界的多生产者单消费者环形队列 (每个槽位带序号)，生产者之间只用 CAS，
+ *   可以在音频回调、网络回调和 esp_timer 中调用，不会被主循环持锁阻塞。
+ * - 环形队列满时任务进入带锁的溢出队列并计数，任务不会丢失，执行顺序保持不变。
+ */
+
+#define TASK_INLINE_SIZE 40
+#define TASK_QUEUE_CAPACITY 32
+// 等待时间直方图，第 i 个桶统计小于 2^i ms 的任务，最后一个桶统计其余
+#define TASK_LATENCY_BUCKETS 12
+
+class InlineTask {
+public:
+    InlineTask() = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, InlineTask>>>
+    explicit InlineTask(F&& callable) {
+        using Fn = std::decay_t<F>;
+        if constexpr (FitsInline<Fn>()) {
+            new (storage_) Fn(std::forward<F>(callable));
+            ops_ = &InlineOps<Fn>::ops;
+        } else {
+            *reinterpret_cast<Fn**>(storage_) = new Fn(std::forward<F>(callable));
+            ops_ = &HeapOps<Fn>::ops;
+        }
+    }
+
+    InlineTask(InlineTask&& other) noexcept {
+        MoveFrom(other);
+    }
+
+    InlineTask& operator=(InlineTask&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    InlineTask(const InlineTask&) = delete;
+    InlineTask& operator=(const InlineTask&) = delete;
+
+    ~InlineTask() {
+        Reset();
+    }
+
+    explicit operator bool() const { return ops_ != nullptr; }
+    bool is_heap() const { return ops_ != nullptr && ops_->heap; }
+
+    void operator()() {
+        ops_->invoke(storage_);
+    }
+
+    void Reset() {
+        if (ops_ != nullptr) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+private:
+    struct Ops {
+        void (*invoke)(void* storage);
+        void (*move)(void* dst, void* src);
+        void (*destroy)(void* storage);
+        bool heap;
+    };
+
+    template <typename Fn>
+    static constexpr bool FitsInline() {
+        return sizeof(Fn) <= TASK_INLINE_SIZE && alignof(Fn) <= alignof(std::max_align_t) &&
+            std::is_nothrow_move_constructible_v<Fn>;
+    }
+
+    template <typename Fn>
+    struct InlineOps {
+        static void Invoke(void* storage) { (*static_cast<Fn*>(storage))(); }
+        static void Move(void* dst, void* src) {
+            new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        }
+        static void Destroy(void* storage) { static_cast<Fn*>(storage)->~Fn(); }
+        static constexpr Ops ops = { Invoke, Move, Destroy, false };
+    };
+
+    template <typename Fn>
+    struct HeapOps {
+        static void Invoke(void* storage) { (**static_cast<Fn**>(storage))(); }
+        static void Move(void* dst, void* src) { *static_cast<Fn**>(dst) = *static_cast<Fn**>(src); }
+        static void Destroy(void* storage) { delete *static_cast<Fn**>(storage); }
+        static constexpr Ops ops = { Invoke, Move, Destroy, true };
+    };
+
+    alignas(std::max_align_t) unsigned char storage_[TASK_INLINE_SIZE];
+    const Ops* ops_ = nullptr;
+
+    void MoveFrom(InlineTask& other) {
+        ops_ = other.ops_;
+        if (ops_ != nullptr) {
+            ops_->move(storage_, other.storage_);
+            other.ops_ = nullptr;
+        }
+    }
+};
+
+struct TaskQueueStats {
+    uint32_t pushed = 0;
+    uint32_t heap_tasks = 0;        // 捕获超过 TASK_INLINE_SIZE，退化为堆分配
+    uint32_t overflows = 0;         // 环形队列已满，进入溢出队列
+};
+
+struct TaskLatencyStats {
+    uint32_t tasks = 0;
+    uint32_t max_us = 0;
+    uint64_t total_us = 0;
+    uint32_t histogram[TASK_LATENCY_BUCKETS] = {0};
+
+    void Record(uint32_t wait_us) {
+        tasks++;
+        total_us += wait_us;
+        max_us = wait_us > max_us ? wait_us : max_us;
+        int bucket = 0;
+        for (uint32_t ms = wait_us / 1000; ms > 0 && bucket < TASK_LATENCY_BUCKETS - 1; ms >>= 1) {
+            bucket++;
+        }
+        histogram[bucket]++;
+    }
+
+    // 返回分位数所在桶的上界 (ms)
+    uint32_t PercentileMs(uint32_t percent) const {
+        uint32_t count = 0;
+        for (int bucket = 0; bucket < TASK_LATENCY_BUCKETS; bucket++) {
+            count += histogram[bucket];
+            if (count * 100 >= tasks * percent) {
+                return bucket < TASK_LATENCY_BUCKETS - 1 ? 1u << bucket : max_us / 1000;
+            }
+        }
+        return max_us / 1000;
+    }
+};
+
+class TaskQueue {
+public:
+    TaskQueue() {
+        for (uint32_t i = 0; i < TASK_QUEUE_CAPACITY; i++) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // 可在任意任务中调用，enqueue_time_us 在执行前原样交给 RunPending 的 on_run，用于统计排队时间
+    template <typename F>
+    void Push(F&& callable, int64_t enqueue_time_us = 0) {
+        InlineTask task(std::forward<F>(callable));
+        pushed_.fetch_add(1, std::memory_order_relaxed);
+        if (task.is_heap()) {
+            heap_tasks_.fetch_add(1, std::memory_order_relaxed);
+        }
+        // 溢出队列非空时也进入溢出队列，保证先后顺序
+        if (!overflowed_.load(std::memory_order_acquire) && TryPush(task, enqueue_time_us)) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(overflow_mutex_);
+        overflow_.push_back(OverflowTask{std::move(task), enqueue_time_us});
+        overflowed_.store(true, std::memory_order_release);
+        overflows_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /*
+     * 只能由消费者调用，最多执行 max_tasks 个调用前已入队的任务，执行过程中新加入的任务留到下一次。
+     * 每个任务执行前调用 on_run(enqueue_time_us)，返回执行的任务数
+     */
+    template <typename OnRun>
+    size_t RunPending(size_t max_tasks, OnRun&& on_run) {
+        size_t count = 0;
+        uint32_t end = enqueue_pos_.load(std::memory_order_acquire);
+        InlineTask task;
+        int64_t enqueue_time_us;
+        while (count < max_tasks && dequeue_pos_ != end && TryPop(task, enqueue_time_us)) {
+            on_run(enqueue_time_us);
+            task();
+            task.Reset();
+            count++;
+        }
+
+        // 溢出队列里的任务都晚于环形队列中的任务，环形队列清空后才能执行
+        while (count < max_tasks && overflowed_.load(std::memory_order_acquire) &&
+            dequeue_pos_ == enqueue_pos_.load(std::memory_order_acquire)) {
+            {
+                std::lock_guard<std::mutex> lock(overflow_mutex_);
+                if (overflow_.empty()) {
+                    overflowed_.store(false, std::memory_order_release);
+                    break;
+                }
+                task = std::move(overflow_.front().task);
+                enqueue_time_us = overflow_.front().enqueue_time_us;
+                overflow_.pop_front();
+                if (overflow_.empty()) {
+                    overflowed_.store(false, std::memory_order_release);
+                }
+            }
+            on_run(enqueue_time_us);
+            task();
+            task.Reset();
+            count++;
+        }
+        return count;
+    }
+
+    /*
+     * 只能由消费者调用，只有下一个任务已经可以执行时才返回 true。
+     * 生产者已占位但还没写完的槽位 (可能被同核上更低优先级的任务抢占) 不算，否则主循环会反复唤醒自己，
+     * 低优先级的生产者永远得不到运行；生产者写完后由 Schedule 设置事件位唤醒主循环
+     */
+    bool HasPending() const {
+        const Cell& cell = cells_[dequeue_pos_ & (TASK_QUEUE_CAPACITY - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) == dequeue_pos_ + 1) {
+            return true;
+        }
+        return dequeue_pos_ == enqueue_pos_.load(std::memory_order_acquire) && overflowed_.load(std::memory_order_acquire);
+    }
+
+    TaskQueueStats GetStats() const {
+        TaskQueueStats stats;
+        stats.pushed = pushed_.load(std::memory_order_relaxed);
+        stats.heap_tasks = heap_tasks_.load(std::memory_order_relaxed);
+        stats.overflows = overflows_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    struct Cell {
+        std::atomic<uint32_t> sequence;
+        int64_t enqueue_time_us;
+        InlineTask task;
+    };
+
+    struct OverflowTask {
+        InlineTask task;
+        int64_t enqueue_time_us;
+    };
+
+    static_assert((TASK_QUEUE_CAPACITY & (TASK_QUEUE_CAPACITY - 1)) == 0, "TASK_QUEUE_CAPACITY must be a power of 2");
+
+    Cell cells_[TASK_QUEUE_CAPACITY];
+    std::atomic<uint32_t> enqueue_pos_{0};
+    uint32_t dequeue_pos_ = 0;
+
+    std::mutex overflow_mutex_;
+    std::deque<OverflowTask> overflow_;
+    std::atomic<bool> overflowed_{false};
+
+    std::atomic<uint32_t> pushed_{0};
+    std::atomic<uint32_t> heap_tasks_{0};
+    std::atomic<uint32_t> overflows_{0};
+
+    bool TryPush(InlineTask& task, int64_t enqueue_time_us) {
+        uint32_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells_[pos & (TASK_QUEUE_CAPACITY - 1)];
+            uint32_t sequence = cell->sequence.load(std::memory_order_acquire);
+            int32_t diff = (int32_t)(sequence - pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->task = std::move(task);
+        cell->enqueue_time_us = enqueue_time_us;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(InlineTask& task, int64_t& enqueue_time_us) {
+        Cell* cell = &cells_[dequeue_pos_ & (TASK_QUEUE_CAPACITY - 1)];
+        uint32_t sequence = cell->sequence.load(std::memory_order_acquire);
+        if ((int32_t)(sequence - (dequeue_pos_ + 1)) < 0) {
+            // 队列为空，或生产者已占位但还没写完
+            return false;
+        }
+        task = std::move(cell->task);
+        enqueue_time_us = cell->enqueue_time_us;
+        cell->sequence.store(dequeue_pos_ + TASK_QUEUE_CAPACITY, std::memory_order_release);
+        dequeue_pos_++;
+        return true;
+    }
+};
+
+#endif // TASK_QUEUE_H
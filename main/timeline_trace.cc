@@ -0,0 +1,246 @@
+#include "timeline_trace.h"
+#include "memory_placement.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <esp_console.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <atomic>
+#include <mutex>
+#include <cstring>
+#include <cstdlib>
+
+#define TAG "TimelineTrace"
+
+#if CONFIG_USE_TIMELINE_TRACE
+
+#define TRACE_EVENTS_PER_CORE CONFIG_TIMELINE_TRACE_EVENTS_PER_CORE
+static_assert((TRACE_EVENTS_PER_CORE & (TRACE_EVENTS_PER_CORE - 1)) == 0, "TIMELINE_TRACE_EVENTS_PER_CORE must be a power of 2");
+
+struct TraceEvent {
+    int64_t timestamp_us;               // esp_timer 的绝对时间，导出时减去开始时间 (32 位偏移约 71.6 分钟就会回绕)
+    std::atomic<uint32_t> sequence;     // 写完后为 index + 1，导出时用来跳过未写完或已被覆盖的事件
+    const char* name;
+    int32_t value;
+    TaskHandle_t task;
+    uint8_t type;
+};
+
+// 计数器放在内部 RAM，事件数组在 PSRAM
+struct TraceBuffer {
+    TraceEvent* events = nullptr;
+    std::atomic<uint32_t> head{0};
+};
+
+static TraceBuffer s_buffers[CONFIG_FREERTOS_NUMBER_OF_CORES];
+static std::atomic<bool> s_recording{false};
+static int64_t s_start_time_us = 0;
+static std::mutex s_write_mutex;
+
+// newlib nano 的 printf 不支持 %lld，64 位时间偏移手动转成十进制
+static const char* FormatTimestamp(int64_t us, char (&buffer)[24]) {
+    char* p = buffer + sizeof(buffer) - 1;
+    *p = '\0';
+    uint64_t value = us < 0 ? -(uint64_t)us : us;
+    do {
+        *--p = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+    if (us < 0) {
+        *--p = '-';
+    }
+    return p;
+}
+
+extern "C" void timeline_trace_record(trace_event_type_t type, const char* name, int32_t value) {
+    if (!s_recording.load(std::memory_order_relaxed)) {
+        return;
+    }
+    auto& buffer = s_buffers[xPortGetCoreID()];
+    uint32_t index = buffer.head.fetch_add(1, std::memory_order_relaxed);
+    auto& event = buffer.events[index & (TRACE_EVENTS_PER_CORE - 1)];
+    event.sequence.store(0, std::memory_order_relaxed);
+    event.timestamp_us = esp_timer_get_time();
+    event.name = name;
+    event.value = value;
+    event.task = xTaskGetCurrentTaskHandle();
+    event.type = type;
+    event.sequence.store(index + 1, std::memory_order_release);
+}
+
+bool TimelineTrace::Start() {
+    if (s_buffers[0].events == nullptr) {
+        for (auto& buffer : s_buffers) {
+            buffer.events = (TraceEvent*)memory_placement_calloc(MEMORY_BUFFER_TRACE, TRACE_EVENTS_PER_CORE, sizeof(TraceEvent));
+            if (buffer.events == nullptr) {
+                ESP_LOGE(TAG, "Failed to allocate trace buffer");
+                return false;
+            }
+        }
+        s_start_time_us = esp_timer_get_time();
+        RegisterConsoleCommand();
+        ESP_LOGI(TAG, "Recording %d events per core, %u bytes", TRACE_EVENTS_PER_CORE,
+            (unsigned)(TRACE_EVENTS_PER_CORE * sizeof(TraceEvent) * CONFIG_FREERTOS_NUMBER_OF_CORES));
+    }
+    s_recording = true;
+    return true;
+}
+
+void TimelineTrace::Pause() {
+    s_recording = false;
+}
+
+void TimelineTrace::Resume() {
+    if (s_buffers[0].events != nullptr) {
+        s_recording = true;
+    }
+}
+
+bool TimelineTrace::IsRecording() const {
+    return s_recording;
+}
+
+int TimelineTrace::Save(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        ESP_LOGE(TAG, "Failed to open %s", path.c_str());
+        return -1;
+    }
+    int count = Write(file);
+    fclose(file);
+    ESP_LOGI(TAG, "Saved %d events to %s", count, path.c_str());
+    return count;
+}
+
+int TimelineTrace::Dump() {
+    printf("\nTRACE_JSON_BEGIN\n");
+    int count = Write(stdout);
+    printf("TRACE_JSON_END\n");
+    fflush(stdout);
+    return count;
+}
+
+int TimelineTrace::Write(FILE* file) {
+    if (s_buffers[0].events == nullptr) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(s_write_mutex);
+
+    // 导出期间暂停记录，等待正在写入的事件完成，避免读到被覆盖的事件
+    bool was_recording = s_recording;
+    s_recording = false;
+    vTaskDelay(pdMS_TO_TICKS(10));
+
+    fprintf(file, "{\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"%s\"}}", BOARD_NAME);
+
+    // 已退出的任务没有名字，Perfetto 中显示为线程号
+    UBaseType_t task_count = uxTaskGetNumberOfTasks() + 4;
+    auto status_array = (TaskStatus_t*)malloc(sizeof(TaskStatus_t) * task_count);
+    if (status_array != nullptr) {
+        task_count = uxTaskGetSystemState(status_array, task_count, nullptr);
+        for (UBaseType_t i = 0; i < task_count; i++) {
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"%s\"}}",
+                (unsigned long)(uintptr_t)status_array[i].xHandle, status_array[i].pcTaskName);
+        }
+        free(status_array);
+    }
+
+    int count = 0;
+    for (auto& buffer : s_buffers) {
+        uint32_t head = buffer.head.load(std::memory_order_acquire);
+        uint32_t start = head > TRACE_EVENTS_PER_CORE ? head - TRACE_EVENTS_PER_CORE : 0;
+        for (uint32_t index = start; index != head; index++) {
+            auto& event = buffer.events[index & (TRACE_EVENTS_PER_CORE - 1)];
+            if (event.sequence.load(std::memory_order_acquire) != index + 1) {
+                continue;
+            }
+            unsigned long tid = (unsigned long)(uintptr_t)event.task;
+            char ts_buffer[24];
+            const char* ts = FormatTimestamp(event.timestamp_us - s_start_time_us, ts_buffer);
+            switch (event.type) {
+            case TRACE_EVENT_BEGIN:
+            case TRACE_EVENT_END:
+                fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%s,\"pid\":1,\"tid\":%lu}",
+                    event.name, event.type == TRACE_EVENT_BEGIN ? 'B' : 'E', ts, tid);
+                break;
+            case TRACE_EVENT_INSTANT:
+                fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%s,\"pid\":1,\"tid\":%lu}",
+                    event.name, ts, tid);
+                break;
+            case TRACE_EVENT_COUNTER:
+                fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%s,\"pid\":1,\"args\":{\"value\":%ld}}",
+                    event.name, ts, (long)event.value);
+                break;
+            }
+            count++;
+        }
+    }
+    fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+    s_recording = was_recording;
+    return count;
+}
+
+void TimelineTrace::RegisterConsoleCommand() {
+    const esp_console_cmd_t cmd = {
+        .command = "trace",
+        .help = "Timeline trace: trace start | stop | dump | save [path]",
+        .hint = nullptr,
+        .func = [](int argc, char** argv) -> int {
+            auto& trace = TimelineTrace::GetInstance();
+            const char* action = argc > 1 ? argv[1] : "dump";
+            if (strcmp(action, "start") == 0) {
+                trace.Resume();
+            } else if (strcmp(action, "stop") == 0) {
+                trace.Pause();
+            } else if (strcmp(action, "save") == 0) {
+                trace.Save(argc > 2 ? argv[2] : "/sdcard/trace.json");
+            } else if (strcmp(action, "dump") == 0) {
+                trace.Dump();
+            } else {
+                printf("Unknown action: %s\n", action);
+                return 1;
+            }
+            return 0;
+        },
+        .argtable = nullptr,
+    };
+    esp_err_t ret = esp_console_cmd_register(&cmd);
+    if (ret != ESP_OK) {
+        ESP_LOGD(TAG, "Console is not available: %s", esp_err_to_name(ret));
+    }
+}
+
+#else
+
+extern "C" void timeline_trace_record(trace_event_type_t type, const char* name, int32_t value) {
+}
+
+bool TimelineTrace::Start() {
+    ESP_LOGW(TAG, "Timeline trace is disabled, enable CONFIG_USE_TIMELINE_TRACE");
+    return false;
+}
+
+void TimelineTrace::Pause() {
+}
+
+void TimelineTrace::Resume() {
+}
+
+bool TimelineTrace::IsRecording() const {
+    return false;
+}
+
+int TimelineTrace::Save(const std::string& path) {
+    return -1;
+}
+
+int TimelineTrace::Dump() {
+    return -1;
+}
+
+#endif // CONFIG_USE_TIMELINE_TRACE
@@ -0,0 +1,98 @@
+#ifndef TIMELINE_TRACE_H
+#define TIMELINE_TRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "sdkconfig.h"
+
+/*
+ * 时间线追踪，记录各处理阶段的开始/结束、瞬时事件和计数器，导出为 Chrome trace JSON，
+ * 可以直接在 Perfetto (ui.perfetto.dev) 或 chrome://tracing 中打开。
+ *
+ * 每个核心一个环形缓冲 (PSRAM)，写入只用一次原子加法，不加锁，可在任意任务中调用，
+ * 缓冲满后覆盖最早的事件，相当于飞行记录仪：复现卡顿后保存到 SD 卡或输出到串口即可。
+ * 关闭 CONFIG_USE_TIMELINE_TRACE 时所有宏为空。C 文件 (如 MJPEG 播放器) 也可以使用。
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    TRACE_EVENT_BEGIN,
+    TRACE_EVENT_END,
+    TRACE_EVENT_INSTANT,
+    TRACE_EVENT_COUNTER,
+} trace_event_type_t;
+
+// name 必须是字符串常量，导出时才读取
+void timeline_trace_record(trace_event_type_t type, const char* name, int32_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#if CONFIG_USE_TIMELINE_TRACE
+#define TRACE_BEGIN(name) timeline_trace_record(TRACE_EVENT_BEGIN, name, 0)
+#define TRACE_END(name) timeline_trace_record(TRACE_EVENT_END, name, 0)
+#define TRACE_INSTANT(name) timeline_trace_record(TRACE_EVENT_INSTANT, name, 0)
+#define TRACE_COUNTER(name, value) timeline_trace_record(TRACE_EVENT_COUNTER, name, (int32_t)(value))
+#else
+#define TRACE_BEGIN(name) do {} while (0)
+#define TRACE_END(name) do {} while (0)
+#define TRACE_INSTANT(name) do {} while (0)
+#define TRACE_COUNTER(name, value) do {} while (0)
+#endif
+
+#ifdef __cplusplus
+
+#include <string>
+
+#if CONFIG_USE_TIMELINE_TRACE
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name_(name) { TRACE_BEGIN(name_); }
+    ~TraceScope() { TRACE_END(name_); }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name_;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name) do {} while (0)
+#endif
+
+class TimelineTrace {
+public:
+    static TimelineTrace& GetInstance() {
+        static TimelineTrace instance;
+        return instance;
+    }
+    TimelineTrace(const TimelineTrace&) = delete;
+    TimelineTrace& operator=(const TimelineTrace&) = delete;
+
+    // 分配缓冲并开始记录
+    bool Start();
+    void Pause();
+    void Resume();
+    bool IsRecording() const;
+    // 写入文件 (如 /sdcard/trace.json)，返回写入的事件数，失败返回 -1
+    int Save(const std::string& path);
+    // 输出到串口，主机端截取 TRACE_JSON_BEGIN 与 TRACE_JSON_END 之间的内容保存为 .json
+    int Dump();
+
+private:
+    TimelineTrace() = default;
+
+    int Write(FILE* file);
+    void RegisterConsoleCommand();
+};
+
+#endif // __cplusplus
+
+#endif // TIMELINE_TRACE_H
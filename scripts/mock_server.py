@@ -0,0 +1,230 @@
+import argparse
+import asyncio
+import json
+import struct
+import threading
+import time
+import uuid
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+import websockets
+
+
+'''
+  本地替身服务器，用于不依赖云端服务的端到端性能测试。
+
+  1. OTA 接口 (HTTP): 设备启动时请求 CONFIG_OTA_URL，返回 websocket 配置，
+     让设备连接到本机的 websocket 服务。
+  2. Websocket 接口: 实现 hello / listen / abort / tts / stt 消息，
+     支持二进制协议版本 1 / 2 / 3。
+     - 默认将上行 Opus 包原样作为 TTS 回放 (echo)
+     - 指定 --p3 时回放 p3 文件 (16kHz / 60ms Opus)
+
+  每轮对话结束后打印上行包速率、设备首包延迟和下行时长。
+
+  用法:
+    pip install websockets
+    python mock_server.py --host 192.168.1.100
+  然后在 menuconfig 中把 OTA URL 设置为 http://192.168.1.100:8002/xiaozhi/ota/
+'''
+
+
+def pack_audio(version, payload, timestamp=0):
+    if version == 2:
+        return struct.pack('>HHIII', version, 0, 0, timestamp, len(payload)) + payload
+    if version == 3:
+        return struct.pack('>BBH', 0, 0, len(payload)) + payload
+    return payload
+
+
+def unpack_audio(version, data):
+    if version == 2:
+        _, _, _, _, size = struct.unpack('>HHIII', data[:16])
+        return data[16:16 + size]
+    if version == 3:
+        _, _, size = struct.unpack('>BBH', data[:4])
+        return data[4:4 + size]
+    return data
+
+
+def load_p3(filename):
+    packets = []
+    with open(filename, 'rb') as f:
+        while True:
+            header = f.read(4)
+            if len(header) < 4:
+                break
+            _, _, size = struct.unpack('>BBH', header)
+            packets.append(f.read(size))
+    return packets
+
+
+class Session:
+    def __init__(self, websocket, args):
+        self.websocket = websocket
+        self.args = args
+        self.version = 1
+        self.session_id = str(uuid.uuid4())
+        self.frame_duration = 60
+        self.recording = False
+        self.packets = []
+        self.turn = 0
+        self.turn_task = None
+        self.connect_time = time.monotonic()
+        self.listen_start_time = 0
+        self.first_uplink_time = 0
+
+    async def send_json(self, message):
+        message['session_id'] = self.session_id
+        await self.websocket.send(json.dumps(message))
+
+    async def on_hello(self, message):
+        self.version = message.get('version', 1)
+        self.frame_duration = message.get('audio_params', {}).get('frame_duration', 60)
+        await self.send_json({
+            'type': 'hello',
+            'transport': 'websocket',
+            'audio_params': {
+                'format': 'opus',
+                'sample_rate': 16000,
+                'channels': 1,
+                'frame_duration': self.frame_duration,
+            },
+        })
+        print(f'[{self.session_id[:8]}] hello version={self.version} '
+              f'setup={(time.monotonic() - self.connect_time) * 1000:.0f}ms')
+
+    async def on_listen(self, message):
+        state = message.get('state')
+        if state == 'start':
+            self.recording = True
+            self.packets = []
+            self.listen_start_time = time.monotonic()
+            self.first_uplink_time = 0
+            print(f'[{self.session_id[:8]}] listen start mode={message.get("mode")}')
+        elif state == 'stop':
+            self.end_turn('stop')
+        elif state == 'detect':
+            print(f'[{self.session_id[:8]}] wake word: {message.get("text")}')
+
+    def on_audio(self, data):
+        if not self.recording:
+            return
+        if self.first_uplink_time == 0:
+            self.first_uplink_time = time.monotonic()
+        self.packets.append(unpack_audio(self.version, data))
+        if len(self.packets) * self.frame_duration >= self.args.turn_duration:
+            self.end_turn('duration')
+
+    def end_turn(self, reason):
+        if not self.recording:
+            return
+        self.recording = False
+        self.turn += 1
+        elapsed = time.monotonic() - self.listen_start_time
+        first_delay = (self.first_uplink_time - self.listen_start_time) * 1000 if self.first_uplink_time else -1
+        uplink_bytes = sum(len(p) for p in self.packets)
+        print(f'[{self.session_id[:8]}] turn {self.turn} end ({reason}): uplink={len(self.packets)} pkts '
+              f'{uplink_bytes} bytes {len(self.packets) / max(elapsed, 0.001):.1f} pps '
+              f'first_packet={first_delay:.0f}ms')
+        packets = self.args.p3_packets if self.args.p3_packets else self.packets
+        self.turn_task = asyncio.ensure_future(self.play(packets))
+
+    async def play(self, packets):
+        await self.send_json({'type': 'stt', 'text': f'mock turn {self.turn}'})
+        await self.send_json({'type': 'llm', 'emotion': 'happy'})
+        await self.send_json({'type': 'tts', 'state': 'start'})
+        await self.send_json({'type': 'tts', 'state': 'sentence_start', 'text': f'{len(packets)} packets'})
+        start = time.monotonic()
+        timestamp = 0
+        for i, payload in enumerate(packets):
+            # 按帧间隔发送，模拟实时 TTS 流
+            delay = start + i * self.frame_duration / 1000 - time.monotonic()
+            if delay > 0:
+                await asyncio.sleep(delay)
+            await self.websocket.send(pack_audio(self.version, payload, timestamp))
+            timestamp += self.frame_duration
+        await self.send_json({'type': 'tts', 'state': 'stop'})
+        print(f'[{self.session_id[:8]}] turn {self.turn} tts: {len(packets)} pkts '
+              f'in {(time.monotonic() - start) * 1000:.0f}ms')
+
+    async def on_abort(self, message):
+        print(f'[{self.session_id[:8]}] abort reason={message.get("reason")}')
+        if self.turn_task and not self.turn_task.done():
+            self.turn_task.cancel()
+            await self.send_json({'type': 'tts', 'state': 'stop'})
+
+    async def run(self):
+        async for data in self.websocket:
+            if isinstance(data, bytes):
+                self.on_audio(data)
+                continue
+            message = json.loads(data)
+            handler = getattr(self, f'on_{message.get("type")}', None)
+            if handler:
+                await handler(message)
+            else:
+                print(f'[{self.session_id[:8]}] ignore: {data[:120]}')
+        if self.turn_task:
+            self.turn_task.cancel()
+        print(f'[{self.session_id[:8]}] disconnected')
+
+
+def start_ota_server(args):
+    ws_url = f'ws://{args.host}:{args.ws_port}/xiaozhi/v1/'
+
+    class OtaHandler(BaseHTTPRequestHandler):
+        def do_POST(self):
+            length = int(self.headers.get('Content-Length', 0))
+            self.rfile.read(length)
+            self.reply()
+
+        def do_GET(self):
+            self.reply()
+
+        def reply(self):
+            body = json.dumps({
+                'websocket': {'url': ws_url, 'token': 'mock', 'version': args.version},
+                'server_time': {'timestamp': int(time.time() * 1000), 'timezone_offset': 480},
+            }).encode()
+            self.send_response(200)
+            self.send_header('Content-Type', 'application/json')
+            self.send_header('Content-Length', str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+            print(f'OTA request from {self.client_address[0]} -> {ws_url}')
+
+        def log_message(self, format, *args):
+            pass
+
+    server = ThreadingHTTPServer(('0.0.0.0', args.ota_port), OtaHandler)
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    print(f'OTA server: http://{args.host}:{args.ota_port}/xiaozhi/ota/')
+
+
+async def main(args):
+    start_ota_server(args)
+
+    async def handler(websocket, *_):
+        await Session(websocket, args).run()
+
+    async with websockets.serve(handler, '0.0.0.0', args.ws_port, max_size=None):
+        print(f'Websocket server: ws://{args.host}:{args.ws_port}/xiaozhi/v1/')
+        await asyncio.Future()
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='本地 OTA + Websocket 替身服务器，用于端到端性能测试')
+    parser.add_argument('--host', default='127.0.0.1', help='设备可访问的本机地址 (默认: 127.0.0.1)')
+    parser.add_argument('--ota-port', type=int, default=8002, help='OTA HTTP 端口 (默认: 8002)')
+    parser.add_argument('--ws-port', type=int, default=8000, help='Websocket 端口 (默认: 8000)')
+    parser.add_argument('--version', type=int, default=1, choices=[1, 2, 3], help='二进制协议版本 (默认: 1)')
+    parser.add_argument('--turn-duration', type=int, default=3000, help='单轮最长录音时长 ms (默认: 3000)')
+    parser.add_argument('--p3', help='用 p3 文件代替回声作为 TTS 音频')
+
+    args = parser.parse_args()
+    args.p3_packets = load_p3(args.p3) if args.p3 else None
+    try:
+        asyncio.run(main(args))
+    except KeyboardInterrupt:
+        print('\nStopped')
@@ -0,0 +1,102 @@
+import argparse
+import json
+import struct
+
+
+'''
+  查看 / 导出设备录制的会话文件 (CONFIG_USE_SESSION_RECORDER)。
+
+  文件格式 (小端):
+    文件头: magic "XZSR" (uint32) + version (uint16) + reserved (uint16)
+    记录:   time_ms (uint32) + type (uint8) + reserved (uint8 + uint16) + payload_size (uint32) + payload
+
+  type: 0 会话信息  1 下行 JSON  2 上行 JSON  3 下行音频  4 上行音频
+  音频 payload 为 4 字节时间戳 + Opus 数据。
+
+  用法:
+    python session_log.py 6523a1f0.xzs                  # 打印消息时间线和统计
+    python session_log.py 6523a1f0.xzs --p3 tts.p3      # 导出下行音频为 p3 文件
+    python session_log.py 6523a1f0.xzs --speed 200      # 计算 2 倍速回放的时长
+'''
+
+SESSION_FILE_MAGIC = 0x52535a58
+TYPE_NAMES = ['session', 'in-json', 'out-json', 'in-audio', 'out-audio']
+
+
+def read_session(filename):
+    records = []
+    with open(filename, 'rb') as f:
+        magic, version, _ = struct.unpack('<IHH', f.read(8))
+        if magic != SESSION_FILE_MAGIC:
+            raise ValueError(f'{filename} is not a session file')
+        if version != 1:
+            raise ValueError(f'unsupported version {version}')
+        while True:
+            header = f.read(12)
+            if len(header) < 12:
+                break
+            time_ms, record_type, _, _, size = struct.unpack('<IBBHI', header)
+            payload = f.read(size)
+            if len(payload) < size:
+                print(f'truncated record at {time_ms} ms')
+                break
+            records.append((time_ms, record_type, payload))
+    return records
+
+
+def print_timeline(records):
+    for time_ms, record_type, payload in records:
+        if record_type in (0, 1, 2):
+            print(f'{time_ms:8d} {TYPE_NAMES[record_type]:9s} {payload.decode(errors="replace")[:160]}')
+
+
+def print_summary(records, speed):
+    counts = [0] * len(TYPE_NAMES)
+    sizes = [0] * len(TYPE_NAMES)
+    for _, record_type, payload in records:
+        if record_type < len(TYPE_NAMES):
+            counts[record_type] += 1
+            sizes[record_type] += len(payload)
+    duration = records[-1][0] if records else 0
+    print(f'\nduration: {duration} ms, replay at {speed}%: {duration * 100 // speed} ms')
+    for i, name in enumerate(TYPE_NAMES[1:], 1):
+        print(f'  {name:9s} {counts[i]:6d} records {sizes[i]:9d} bytes')
+
+    # 下行音频到达间隔，用于判断服务器推流是否平稳
+    arrivals = [t for t, record_type, _ in records if record_type == 3]
+    if len(arrivals) > 1:
+        gaps = sorted(b - a for a, b in zip(arrivals, arrivals[1:]))
+        print(f'  in-audio gap: p50={gaps[len(gaps) // 2]} ms p99={gaps[len(gaps) * 99 // 100]} ms max={gaps[-1]} ms')
+
+
+def export_p3(records, filename):
+    count = 0
+    with open(filename, 'wb') as f:
+        for _, record_type, payload in records:
+            if record_type != 3:
+                continue
+            opus = payload[4:]
+            f.write(struct.pack('>BBH', 0, 0, len(opus)))
+            f.write(opus)
+            count += 1
+    print(f'exported {count} packets to {filename}')
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='查看或导出设备录制的会话文件')
+    parser.add_argument('filename', help='会话文件 (.xzs)')
+    parser.add_argument('--p3', help='把下行音频导出为 p3 文件')
+    parser.add_argument('--speed', type=int, default=100, help='回放速度百分比 (默认: 100)')
+    parser.add_argument('--quiet', action='store_true', help='只打印统计信息')
+
+    args = parser.parse_args()
+    records = read_session(args.filename)
+    if records and records[0][1] == 0:
+        info = json.loads(records[0][2])
+        print(f'session {info.get("session_id")} sample_rate={info.get("sample_rate")} '
+              f'frame_duration={info.get("frame_duration")}')
+    if not args.quiet:
+        print_timeline(records)
+    print_summary(records, args.speed)
+    if args.p3:
+        export_p3(records, args.p3)